@@ -30,6 +30,7 @@
 #include "scripting/toplevel/XML.h"
 #include "scripting/toplevel/XMLList.h"
 #include "scripting/toplevel/Error.h"
+#include "scripting/flash/utils/Dictionary.h"
 #include <3rdparty/pugixml/src/pugixml.hpp>
 
 using namespace lightspark;
@@ -440,10 +441,8 @@ void ASObject::call_toString(asAtom &ret)
 	asAtomHandler::callFunction(o,ret,v,NULL,0,false);
 }
 
-tiny_string ASObject::call_toJSON(bool& ok,std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces,const tiny_string& filter)
+bool ASObject::call_toJSON(std::string& res, std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces,const tiny_string& filter)
 {
-	tiny_string res;
-	ok = false;
 	multiname toJSONName(NULL);
 	toJSONName.name_type=multiname::NAME_STRING;
 	toJSONName.name_s_id=getSystemState()->getUniqueStringId("toJSON");
@@ -451,25 +450,25 @@ tiny_string ASObject::call_toJSON(bool& ok,std::vector<ASObject *> &path, asAtom
 	toJSONName.ns.emplace_back(getSystemState(),BUILTIN_STRINGS::STRING_AS3NS,NAMESPACE);
 	toJSONName.isAttribute = false;
 	if (!ASObject::hasPropertyByMultiname(toJSONName, true, true))
-		return res;
+		return false;
 
 	asAtom o=asAtomHandler::invalidAtom;
 	getVariableByMultiname(o,toJSONName,SKIP_IMPL);
 	if (!asAtomHandler::isFunction(o))
-		return res;
+		return false;
 	asAtom v=asAtomHandler::fromObject(this);
 	asAtom ret=asAtomHandler::invalidAtom;
 	asAtomHandler::callFunction(o,ret,v,NULL,0,false);
 	if (asAtomHandler::isString(ret))
 	{
 		res += "\"";
-		res += asAtomHandler::toString(ret,getSystemState());
+		tiny_string s = asAtomHandler::toString(ret,getSystemState());
+		res.append(s.raw_buf(),s.numBytes());
 		res += "\"";
 	}
 	else 
-		res = asAtomHandler::toObject(ret,getSystemState())->toJSON(path,replacer,spaces,filter);
-	ok = true;
-	return res;
+		asAtomHandler::toObject(ret,getSystemState())->toJSON(res,path,replacer,spaces,filter);
+	return true;
 }
 
 bool ASObject::isPrimitive() const
@@ -1721,7 +1720,7 @@ void ASObject::dumpObjectCounters(uint32_t threshhold)
 }
 #endif
 ASObject::ASObject(Class_base* c,SWFOBJECT_TYPE t,CLASS_SUBTYPE st):objfreelist(c && c->getSystemState()->singleworker && c->isReusable ? c->freelist : nullptr),Variables((c)?c->memoryAccount:nullptr),classdef(c),proxyMultiName(nullptr),sys(c?c->sys:nullptr),
-	stringId(UINT32_MAX),type(t),subtype(st),traitsInitialized(false),constructIndicator(false),constructorCallComplete(false),implEnable(true)
+	stringId(UINT32_MAX),type(t),subtype(st),traitsInitialized(false),constructIndicator(false),constructorCallComplete(false),weakDictionaryKey(false),implEnable(true)
 {
 #ifndef NDEBUG
 	//Stuff only used in debugging
@@ -1736,7 +1735,7 @@ ASObject::ASObject(Class_base* c,SWFOBJECT_TYPE t,CLASS_SUBTYPE st):objfreelist(
 }
 
 ASObject::ASObject(const ASObject& o):objfreelist(o.classdef && o.classdef->getSystemState()->singleworker && o.classdef->isReusable ? o.classdef->freelist : nullptr),Variables((o.classdef)?o.classdef->memoryAccount:nullptr),classdef(nullptr),proxyMultiName(nullptr),sys(o.classdef? o.classdef->sys : nullptr),
-	stringId(o.stringId),type(o.type),subtype(o.subtype),traitsInitialized(false),constructIndicator(false),constructorCallComplete(false),implEnable(true)
+	stringId(o.stringId),type(o.type),subtype(o.subtype),traitsInitialized(false),constructIndicator(false),constructorCallComplete(false),weakDictionaryKey(false),implEnable(true)
 {
 #ifndef NDEBUG
 	//Stuff only used in debugging
@@ -1745,6 +1744,12 @@ ASObject::ASObject(const ASObject& o):objfreelist(o.classdef && o.classdef->getS
 	assert(o.Variables.size()==0);
 }
 
+void ASObject::removeFromWeakDictionaries()
+{
+	weakDictionaryKey=false;
+	Dictionary::weakKeyDestroyed(this);
+}
+
 void ASObject::setClass(Class_base* c)
 {
 	if (classdef == c)
@@ -2259,62 +2264,85 @@ ASObject *ASObject::describeType() const
 	return XML::createFromNode(root);
 }
 
-tiny_string ASObject::toJSON(std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces,const tiny_string& filter)
+void ASObject::appendJSONString(std::string& res, const tiny_string& s)
 {
-	bool ok;
-	tiny_string res = call_toJSON(ok,path,replacer,spaces,filter);
-	if (ok)
-		return res;
+	res += '"';
+	const char* p = s.raw_buf();
+	const char* end = p+s.numBytes();
+	while (p < end)
+	{
+		// copy runs of characters that don't need escaping in one step
+		const char* start = p;
+		while (p < end && (unsigned char)*p >= 0x20 && (unsigned char)*p < 0x80 && *p != '"' && *p != '\\')
+			p++;
+		if (p != start)
+			res.append(start,p-start);
+		if (p == end)
+			break;
+		uint32_t c = (unsigned char)*p;
+		if (c >= 0x80)
+		{
+			c = g_utf8_get_char(p);
+			const char* next = g_utf8_next_char(p);
+			if (c > 0xff)
+			{
+				char hexstr[16];
+				sprintf(hexstr,"\\u%04x",c);
+				res += hexstr;
+			}
+			else
+				res.append(p,next-p);
+			p = next;
+			continue;
+		}
+		switch (c)
+		{
+			case '\b':
+				res += "\\b";
+				break;
+			case '\f':
+				res += "\\f";
+				break;
+			case '\n':
+				res += "\\n";
+				break;
+			case '\r':
+				res += "\\r";
+				break;
+			case '\t':
+				res += "\\t";
+				break;
+			case '\"':
+				res += "\\\"";
+				break;
+			case '\\':
+				res += "\\\\";
+				break;
+			default:
+			{
+				char hexstr[16];
+				sprintf(hexstr,"\\u%04x",c);
+				res += hexstr;
+				break;
+			}
+		}
+		p++;
+	}
+	res += '"';
+}
+
+void ASObject::toJSON(std::string& res, std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces,const tiny_string& filter)
+{
+	if (call_toJSON(res,path,replacer,spaces,filter))
+		return;
 
-	tiny_string newline = (spaces.empty() ? "" : "\n");
 	if (this->isPrimitive())
 	{
 		switch(this->type)
 		{
 			case T_STRING:
-			{
-				res += "\"";
-				tiny_string sub = this->toString();
-				for (CharIterator it=sub.begin(); it!=sub.end(); it++)
-				{
-					switch (*it)
-					{
-						case '\b':
-							res += "\\b";
-							break;
-						case '\f':
-							res += "\\f";
-							break;
-						case '\n':
-							res += "\\n";
-							break;
-						case '\r':
-							res += "\\r";
-							break;
-						case '\t':
-							res += "\\t";
-							break;
-						case '\"':
-							res += "\\\"";
-							break;
-						case '\\':
-							res += "\\\\";
-							break;
-						default:
-							if (*it < 0x20 || *it > 0xff)
-							{
-								char hexstr[7];
-								sprintf(hexstr,"\\u%04x",*it);
-								res += hexstr;
-							}
-							else
-								res += *it;
-							break;
-					}
-				}
-				res += "\"";
+				appendJSONString(res,this->toString());
 				break;
-			}
 			case T_UNDEFINED:
 				res += "null";
 				break;
@@ -2322,16 +2350,22 @@ tiny_string ASObject::toJSON(std::vector<ASObject *> &path, asAtom replacer, con
 			case T_INTEGER:
 			case T_UINTEGER:
 			{
-				tiny_string s = this->toString();
-				if (s == "Infinity" || s == "-Infinity" || s == "NaN")
+				number_t n = this->toNumber();
+				if (std::isnan(n) || std::isinf(n))
 					res += "null";
 				else
-					res += s;
+				{
+					tiny_string s = this->toString();
+					res.append(s.raw_buf(),s.numBytes());
+				}
 				break;
 			}
 			default:
-				res += this->toString();
+			{
+				tiny_string s = this->toString();
+				res.append(s.raw_buf(),s.numBytes());
 				break;
+			}
 		}
 	}
 	else
@@ -2380,9 +2414,9 @@ tiny_string ASObject::toJSON(std::vector<ASObject *> &path, asAtom replacer, con
 				if (asAtomHandler::isValid(varIt->second.getter))
 				{
 					asAtom t=asAtomHandler::fromObject(this);
-					asAtom res=asAtomHandler::invalidAtom;
-					asAtomHandler::callFunction(varIt->second.getter,res,t,NULL,0,false);
-					v=asAtomHandler::toObject(res,getSystemState());
+					asAtom getterret=asAtomHandler::invalidAtom;
+					asAtomHandler::callFunction(varIt->second.getter,getterret,t,NULL,0,false);
+					v=asAtomHandler::toObject(getterret,getSystemState());
 				}
 				if(v && v->getObjectType() != T_UNDEFINED && varIt->second.isenumerable)
 				{
@@ -2393,13 +2427,16 @@ tiny_string ASObject::toJSON(std::vector<ASObject *> &path, asAtom replacer, con
 						std::find(path.begin(),path.end(), v) != path.end())
 						throwError<TypeError>(kJSONCyclicStructure);
 		
+					const tiny_string& name = getSystemState()->getStringFromUniqueId(varIt->first);
 					if (asAtomHandler::isValid(replacer))
 					{
 						if (!bfirst)
 							res += ",";
-						res += newline+spaces;
+						if (!spaces.empty())
+							res += "\n";
+						res.append(spaces.raw_buf(),spaces.numBytes());
 						res += "\"";
-						res += getSystemState()->getStringFromUniqueId(varIt->first);
+						res.append(name.raw_buf(),name.numBytes());
 						res += "\"";
 						res += ":";
 						if (!spaces.empty())
@@ -2412,34 +2449,42 @@ tiny_string ASObject::toJSON(std::vector<ASObject *> &path, asAtom replacer, con
 						asAtom funcret=asAtomHandler::invalidAtom;
 						asAtomHandler::callFunction(replacer,funcret,asAtomHandler::nullAtom, params, 2,true);
 						if (asAtomHandler::isValid(funcret))
-							res += asAtomHandler::toString(funcret,getSystemState());
+						{
+							tiny_string s = asAtomHandler::toString(funcret,getSystemState());
+							res.append(s.raw_buf(),s.numBytes());
+						}
 						else
-							res += v->toJSON(path,replacer,spaces+spaces,filter);
+							v->toJSON(res,path,replacer,spaces+spaces,filter);
 						bfirst = false;
 					}
-					else if (filter.empty() || filter.find(tiny_string(" ")+getSystemState()->getStringFromUniqueId(varIt->first)+" ") != tiny_string::npos)
+					else if (filter.empty() || filter.find(tiny_string(" ")+name+" ") != tiny_string::npos)
 					{
 						if (!bfirst)
 							res += ",";
-						res += newline+spaces;
+						if (!spaces.empty())
+							res += "\n";
+						res.append(spaces.raw_buf(),spaces.numBytes());
 						res += "\"";
-						res += getSystemState()->getStringFromUniqueId(varIt->first);
+						res.append(name.raw_buf(),name.numBytes());
 						res += "\"";
 						res += ":";
 						if (!spaces.empty())
 							res += " ";
-						res += v->toJSON(path,replacer,spaces+spaces,filter);
+						v->toJSON(res,path,replacer,spaces+spaces,filter);
 						bfirst = false;
 					}
 				}
 				if (!bfirst)
-					res += newline+spaces.substr_bytes(0,spaces.numBytes()/2);
+				{
+					if (!spaces.empty())
+						res += "\n";
+					res.append(spaces.raw_buf(),spaces.numBytes()/2);
+				}
 			}
 		}
 		res += "}";
 		path.pop_back();
 	}
-	return res;
 }
 
 bool ASObject::hasprop_prototype()
@@ -3195,6 +3240,14 @@ void asAtomHandler::addreplace(asAtom& ret, SystemState* sys,asAtom& v1, asAtom
 	}
 	else if(isString(v1) || isString(v2))
 	{
+		ASObject* o = getObject(ret);
+		if (&ret == &v1 && !forceint && o && o->is<ASString>() && o->isLastRef())
+		{
+			// the result replaces the only reference to the string, so we can append to it instead of creating a new string
+			LOG_CALL("add in place " << toString(v1,sys) << '+' << toString(v2,sys));
+			o->as<ASString>()->append(toString(v2,sys));
+			return;
+		}
 		tiny_string sa = toString(v1,sys);
 		sa += toString(v2,sys);
 		LOG_CALL("add " << toString(v1,sys) << '+' << toString(v2,sys));
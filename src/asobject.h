@@ -870,6 +870,8 @@ protected:
 	bool traitsInitialized:1;
 	bool constructIndicator:1;
 	bool constructorCallComplete:1; // indicates that the constructor including all super constructors has been called
+	bool weakDictionaryKey:1; // this object is used as key in a Dictionary with weak keys
+	void removeFromWeakDictionaries();
 	void serializeDynamicProperties(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
 				std::map<const ASObject*, uint32_t>& objMap,
 				std::map<const Class_base*, uint32_t> traitsMap,bool usedynamicPropertyWriter=true);
@@ -915,6 +917,8 @@ protected:
 
 	FORCE_INLINE bool destructIntern()
 	{
+		if (weakDictionaryKey)
+			removeFromWeakDictionaries();
 		destroyContents();
 		if (proxyMultiName)
 		{
@@ -1182,7 +1186,7 @@ public:
 	void call_valueOf(asAtom &ret);
 	bool has_toString();
 	void call_toString(asAtom &ret);
-	tiny_string call_toJSON(bool &ok, std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces, const tiny_string &filter);
+	bool call_toJSON(std::string& res, std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces, const tiny_string &filter);
 
 	/* Helper function for calling getClass()->getQualifiedClassName() */
 	virtual tiny_string getClassName() const;
@@ -1228,7 +1232,9 @@ public:
 
 	virtual ASObject *describeType() const;
 
-	virtual tiny_string toJSON(std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces,const tiny_string& filter);
+	// appends the JSON representation of this object to res, nothing is appended if the value is skipped
+	virtual void toJSON(std::string& res, std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces,const tiny_string& filter);
+	static void appendJSONString(std::string& res, const tiny_string& s);
 	/* returns true if the current object is of type T */
 	template<class T> bool is() const { 
 		LOG(LOG_INFO,"dynamic cast:"<<this->getClassName());
@@ -1251,6 +1257,7 @@ public:
 	void dumpVariables();
 	
 	inline void setConstructIndicator() { constructIndicator = true; }
+	inline void setWeakDictionaryKey() { weakDictionaryKey = true; }
 	inline void setConstructorCallComplete() { constructorCallComplete = true; }
 	inline void setIsInitialized(bool init=true) { traitsInitialized=init; }
 	inline bool getConstructIndicator() const { return constructIndicator; }
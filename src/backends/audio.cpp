@@ -22,6 +22,7 @@
 #include "backends/config.h"
 #include <iostream>
 #include "logger.h"
+#include "platforms/fastpaths.h"
 #include <sys/time.h>
 
 
@@ -39,11 +40,31 @@ uint32_t AudioStream::getPlayedTime()
 	ret = playedtime + (now.tv_sec * 1000 + now.tv_usec / 1000) - (starttime.tv_sec * 1000 + starttime.tv_usec / 1000);
 	return ret;
 }
+
+static int16_t mixerGain(double level)
+{
+	if (level <= 0.0)
+		return 0;
+	if (level >= 1.0)
+		return INT16_MAX;
+	return int16_t(level*INT16_MAX);
+}
+
+void AudioStream::updateGains()
+{
+	RELEASE_WRITE(gainleft,mixerGain(curvolume*panleft));
+	RELEASE_WRITE(gainright,mixerGain(curvolume*panright));
+}
+
 bool AudioStream::init(double volume)
 {
 	unmutevolume = curvolume = volume;
-	mixer_channel = manager->engineData->audio_StreamInit(this);
-	manager->engineData->audio_StreamSetVolume(mixer_channel, curvolume);
+	updateGains();
+	if (!manager->internalMixer)
+	{
+		mixer_channel = manager->engineData->audio_StreamInit(this);
+		manager->engineData->audio_StreamSetVolume(mixer_channel, curvolume);
+	}
 	isPaused = false;
 	return true;
 }
@@ -68,7 +89,8 @@ void AudioStream::SetPause(bool pause_on)
 		mixingStarted=false;
 		isPaused = false;
 	}
-	manager->engineData->audio_StreamPause(mixer_channel,pause_on);
+	if (!manager->internalMixer)
+		manager->engineData->audio_StreamPause(mixer_channel,pause_on);
 }
 
 bool AudioStream::ispaused()
@@ -87,22 +109,76 @@ void AudioStream::unmute()
 }
 void AudioStream::setVolume(double volume)
 {
-	manager->engineData->audio_StreamSetVolume(mixer_channel, volume);
+	if (!manager->internalMixer)
+		manager->engineData->audio_StreamSetVolume(mixer_channel, volume);
 	curvolume = volume;
+	updateGains();
 }
 
-void AudioStream::setPanning(uint16_t left, int16_t right)
+void AudioStream::setPanning(uint16_t left, uint16_t right)
 {
-	manager->engineData->audio_StreamSetPanning(mixer_channel,left, right);
+	if (!manager->internalMixer)
+	{
+		manager->engineData->audio_StreamSetPanning(mixer_channel,left, right);
+		return;
+	}
+	// levels are in the range 0..32768
+	panleft = min(1.0,max(0.0,left/32768.0));
+	panright = min(1.0,max(0.0,right/32768.0));
+	updateGains();
 }
 
 AudioStream::~AudioStream()
 {
-	manager->engineData->audio_StreamDeinit(mixer_channel);
+	if (!manager->internalMixer)
+		manager->engineData->audio_StreamDeinit(mixer_channel);
 	manager->removeStream(this);
 }
 
-AudioManager::AudioManager(EngineData *engine):muteAllStreams(false),audio_available(false),mixeropened(0),engineData(engine)
+void AudioManager::mixStreams(int16_t* dest, uint32_t len)
+{
+	// Never block the audio thread: streams are only added or removed
+	// under this lock, so just output silence for one buffer if it is taken
+	if (mixBuffer.empty() || !streamMutex.trylock())
+	{
+		memset(dest,0,len);
+		return;
+	}
+	// the scratch buffers are allocated when the mixer is hooked, so nothing is allocated here:
+	// a request larger than the buffers is mixed in several parts
+	uint32_t maxlen = mixBuffer.size()*sizeof(int16_t);
+	while (len)
+	{
+		uint32_t partlen = min(len,maxlen);
+		uint32_t samples = partlen/2;
+		memset(mixBuffer.data(),0,samples*sizeof(int32_t));
+		for (stream_iterator it = streams.begin(); it != streams.end(); ++it)
+		{
+			AudioStream* s = *it;
+			if (ACQUIRE_READ(s->isPaused) || !s->decoder)
+				continue;
+			s->startMixing();
+			uint32_t readcount = 0;
+			while (readcount < partlen)
+			{
+				uint32_t ret = s->decoder->copyFrame(streamBuffer.data()+readcount/2, partlen-readcount);
+				if (!ret)
+					break;
+				readcount += ret;
+			}
+			if (readcount == 0)
+				continue;
+			fastMixS16StereoIntoS32(mixBuffer.data(), streamBuffer.data(), readcount/2,
+						ACQUIRE_READ(s->gainleft), ACQUIRE_READ(s->gainright));
+		}
+		fastSaturateS32ToS16(dest, mixBuffer.data(), samples);
+		dest += samples;
+		len -= partlen;
+	}
+	streamMutex.unlock();
+}
+
+AudioManager::AudioManager(EngineData *engine):muteAllStreams(false),audio_available(false),mixeropened(0),internalMixer(false),engineData(engine)
 {
 	audio_available = engine->audio_ManagerInit();
 	mixeropened = 0;
@@ -132,6 +208,11 @@ void AudioManager::removeStream(AudioStream *s)
 	streams.remove(s);
 	if (streams.empty())
 	{
+		if (internalMixer)
+		{
+			engineData->audio_ManagerUnhookMixer();
+			internalMixer = false;
+		}
 		engineData->audio_ManagerCloseMixer();
 		mixeropened = false;
 	}
@@ -170,6 +251,12 @@ AudioStream* AudioManager::createStream(AudioDecoder* decoder, bool startpaused,
 			return NULL;
 		}
 		mixeropened = 1;
+		// the scratch buffers are used by the audio callback, which must not allocate memory
+		// (one buffer of the mixer holds LIGHTSPARK_AUDIO_BUFFERSIZE stereo sample frames)
+		mixBuffer.resize(LIGHTSPARK_AUDIO_BUFFERSIZE*2);
+		streamBuffer.resize(LIGHTSPARK_AUDIO_BUFFERSIZE*2);
+		// mix all streams in a single callback if the engine supports it
+		internalMixer = engineData->audio_ManagerHookMixer(this);
 	}
 
 	AudioStream *stream = new AudioStream(this,producer,playedTime);
@@ -197,6 +284,8 @@ AudioManager::~AudioManager()
 	}
 	if (mixeropened)
 	{
+		if (internalMixer)
+			engineData->audio_ManagerUnhookMixer();
 		engineData->audio_ManagerCloseMixer();
 	}
 	if (audio_available)
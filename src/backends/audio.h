@@ -24,6 +24,7 @@
 #include "compat.h"
 #include "backends/decoder.h"
 #include <iostream>
+#include <vector>
 
 namespace lightspark
 {
@@ -37,12 +38,25 @@ private:
 	bool muteAllStreams;
 	bool audio_available;
 	int mixeropened;
+	// true if all streams are mixed by mixStreams() inside a single engine callback
+	bool internalMixer;
 	EngineData* engineData;
 	std::list<AudioStream *> streams;
 	typedef std::list<AudioStream *>::iterator stream_iterator;
 	Mutex streamMutex;
+	// scratch buffers used by the internal mixer, allocated when the mixer is opened and only accessed from the audio callback
+	std::vector<int32_t> mixBuffer;
+	std::vector<int16_t> streamBuffer;
 public:
 	AudioManager(EngineData* engine);
+	/**
+		Mix all active streams into dest
+
+		Called by the engine from its audio callback when the internal mixer is in use.
+		@param dest Interleaved stereo 16 bit output buffer
+		@param len Length of dest in bytes
+	*/
+	void mixStreams(int16_t* dest, uint32_t len);
 
 	AudioStream *createStream(AudioDecoder *decoder, bool startpaused, IThreadJob *producer, uint32_t playedTime, double volume);
 
@@ -64,17 +78,25 @@ private:
 	AudioDecoder *decoder;
 	IThreadJob* producer;
 	bool hasStarted;
-	bool isPaused;
+	// read by the audio callback of the internal mixer
+	ACQUIRE_RELEASE_FLAG(isPaused);
 	bool mixingStarted;
 	double curvolume;
 	double unmutevolume;
+	// panning levels used by the internal mixer, 1.0 means full level
+	double panleft;
+	double panright;
+	// volume and panning combined for the internal mixer, written by the setters and read by the audio callback
+	ATOMIC_INT32(gainleft);
+	ATOMIC_INT32(gainright);
+	void updateGains();
 	uint64_t playedtime;
 	struct timeval starttime;
 	int mixer_channel;
 public:
 	bool init(double volume);
 	void startMixing();
-	AudioStream(AudioManager* _manager,IThreadJob* _producer,uint64_t _playedtime):manager(_manager),decoder(NULL),producer(_producer),hasStarted(false),isPaused(true),mixingStarted(false),playedtime(_playedtime) { }
+	AudioStream(AudioManager* _manager,IThreadJob* _producer,uint64_t _playedtime):manager(_manager),decoder(NULL),producer(_producer),hasStarted(false),isPaused(true),mixingStarted(false),curvolume(1.0),unmutevolume(1.0),panleft(1.0),panright(1.0),gainleft(0),gainright(0),playedtime(_playedtime),mixer_channel(-1) { }
 
 	void SetPause(bool pause_on);
 	uint32_t getPlayedTime();
@@ -85,7 +107,7 @@ public:
 	void resume() { SetPause(false); }
 	void setVolume(double volume);
 	void setPlayedTime(uint64_t p) { playedtime = p; }
-	void setPanning(uint16_t left, int16_t right);
+	void setPanning(uint16_t left, uint16_t right);
 	inline double getVolume() const { return curvolume; }
 	inline AudioDecoder *getDecoder() const { return decoder; }
 	~AudioStream();
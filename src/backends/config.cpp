@@ -84,7 +84,7 @@ Config::Config():
 	systemConfigDirectories(g_get_system_config_dirs()),userConfigDirectory(g_get_user_config_dir()),
 	//DEFAULT SETTINGS
 	defaultCacheDirectory((string) g_get_user_cache_dir() + G_DIR_SEPARATOR_S + "lightspark"),
-	cacheDirectory(defaultCacheDirectory),cachePrefix("cache"),
+	cacheDirectory(defaultCacheDirectory),cachePrefix("cache"),httpCacheSize(256),
 	renderingEnabled(true)
 {
 #ifdef _WIN32
@@ -210,6 +210,9 @@ void Config::handleEntry()
 	//Cache prefix
 	else if(group == "cache" && key == "prefix")
 		cachePrefix = value;
+	//HTTP cache size
+	else if(group == "cache" && key == "httpsize")
+		httpCacheSize = strtoul(value.c_str(),nullptr,10);
 	else
 		LOG(LOG_ERROR,_("Invalid entry encountered in configuration file") << ": '" << group << "/" << key << "'='" << value << "'");
 }
@@ -44,6 +44,8 @@ namespace lightspark
 		std::string cacheDirectory;
 		//Specifies what prefix the cache files should have, default="cache"
 		std::string cachePrefix;
+		//Specifies the maximum size of the HTTP response cache in megabytes, 0 means unlimited, default=256
+		uint32_t httpCacheSize;
 		//Specifies the filename including full path of the gnash executable
 		std::string gnashPath;
 		//Specifies the directory where the app can store files
@@ -59,6 +61,7 @@ namespace lightspark
 
 		const std::string& getCacheDirectory() const { return cacheDirectory; }
 		const std::string& getCachePrefix() const { return cachePrefix; }
+		uint64_t getHTTPCacheSize() const { return uint64_t(httpCacheSize)*1024*1024; }
 		const std::string& getDataDirectory() const { return dataDirectory; }
 		
 		const std::string& getGnashPath() const { return gnashPath; }
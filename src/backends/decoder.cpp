@@ -97,7 +97,7 @@ void VideoDecoder::markForDestruction()
 {
 	markedForDeletion=true;
 }
-VideoDecoder::VideoDecoder():frameRate(0),framesdecoded(0),framesdropped(0),frameWidth(0),frameHeight(0),lastframe(UINT32_MAX),currentframe(UINT32_MAX),fenceCount(0),resizeGLBuffers(false),markedForDeletion(false)
+VideoDecoder::VideoDecoder():frameRate(0),framesdecoded(0),framesdropped(0),bufferTime(0),frameWidth(0),frameHeight(0),lastframe(UINT32_MAX),currentframe(UINT32_MAX),fenceCount(0),resizeGLBuffers(false),markedForDeletion(false)
 {
 }
 
@@ -134,7 +134,8 @@ bool FFMpegVideoDecoder::fillDataAndCheckValidity()
 }
 
 FFMpegVideoDecoder::FFMpegVideoDecoder(LS_VIDEO_CODEC codecId, uint8_t* initdata, uint32_t datalen, double frameRateHint, DefineVideoStreamTag *tag):
-	ownedContext(true),curBuffer(0),codecContext(nullptr),curBufferOffset(0),currentcachedframe(UINT32_MAX),embeddedvideotag(tag)
+	ownedContext(true),curBuffer(0),codecContext(nullptr),streamingCapacity(FFMPEGVIDEODECODERMINBUFFERSIZE),decodeLatency(0),decodeStart(0),
+	curBufferOffset(0),currentcachedframe(UINT32_MAX),embeddedvideotag(tag)
 {
 	//The tag is the header, initialize decoding
 	switchCodec(codecId, initdata, datalen, frameRateHint);
@@ -203,6 +204,7 @@ void FFMpegVideoDecoder::switchCodec(LS_VIDEO_CODEC codecId, uint8_t *initdata,
 		codecContext->extradata=initdata;
 		codecContext->extradata_size=datalen;
 	}
+	setupThreading();
 #ifdef HAVE_AVCODEC_OPEN2
 	if(avcodec_open2(codecContext, codec, NULL)<0)
 #else
@@ -217,7 +219,8 @@ void FFMpegVideoDecoder::switchCodec(LS_VIDEO_CODEC codecId, uint8_t *initdata,
 }
 #if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(57, 40, 101)
 FFMpegVideoDecoder::FFMpegVideoDecoder(AVCodecParameters* codecPar, double frameRateHint):
-	ownedContext(true),curBuffer(0),codecContext(NULL),curBufferOffset(0),currentcachedframe(UINT32_MAX),embeddedvideotag(nullptr)
+	ownedContext(true),curBuffer(0),codecContext(NULL),streamingCapacity(FFMPEGVIDEODECODERMINBUFFERSIZE),decodeLatency(0),decodeStart(0),
+	curBufferOffset(0),currentcachedframe(UINT32_MAX),embeddedvideotag(nullptr)
 {
 	status=INIT;
 #ifdef HAVE_AVCODEC_ALLOC_CONTEXT3
@@ -243,6 +246,7 @@ FFMpegVideoDecoder::FFMpegVideoDecoder(AVCodecParameters* codecPar, double frame
 	}
 	avcodec_parameters_to_context(codecContext,codecPar);
 	AVCodec* codec=avcodec_find_decoder(codecPar->codec_id);
+	setupThreading();
 #ifdef HAVE_AVCODEC_OPEN2
 	if(avcodec_open2(codecContext, codec, NULL)<0)
 #else
@@ -258,7 +262,8 @@ FFMpegVideoDecoder::FFMpegVideoDecoder(AVCodecParameters* codecPar, double frame
 }
 #else
 FFMpegVideoDecoder::FFMpegVideoDecoder(AVCodecContext* _c, double frameRateHint):
-	ownedContext(false),curBuffer(0),codecContext(_c),curBufferOffset(0),currentcachedframe(UINT32_MAX),embeddedvideotag(nullptr)
+	ownedContext(false),curBuffer(0),codecContext(_c),streamingCapacity(FFMPEGVIDEODECODERMINBUFFERSIZE),decodeLatency(0),decodeStart(0),
+	curBufferOffset(0),currentcachedframe(UINT32_MAX),embeddedvideotag(nullptr)
 {
 	frameIn=av_frame_alloc();
 	status=INIT;
@@ -278,6 +283,7 @@ FFMpegVideoDecoder::FFMpegVideoDecoder(AVCodecContext* _c, double frameRateHint)
 			return;
 	}
 	AVCodec* codec=avcodec_find_decoder(codecContext->codec_id);
+	setupThreading();
 #ifdef HAVE_AVCODEC_OPEN2
 	if(avcodec_open2(codecContext, codec, NULL)<0)
 #else
@@ -296,15 +302,57 @@ FFMpegVideoDecoder::FFMpegVideoDecoder(AVCodecContext* _c, double frameRateHint)
 FFMpegVideoDecoder::~FFMpegVideoDecoder()
 {
 	while(fenceCount);
+	while(!streamingframes.empty())
+	{
+		discardStreamingFrame(streamingframes.front());
+		streamingframes.pop_front();
+	}
 	avcodec_close(codecContext);
 	if(ownedContext)
 		av_free(codecContext);
 	av_free(frameIn);
 }
 
+void FFMpegVideoDecoder::setupThreading()
+{
+	//Let libavcodec pick the number of threads. Frame threading is not used,
+	//as it delays the output by one frame per thread and the stream loop never drains the decoder
+	codecContext->thread_count=0;
+	codecContext->thread_type=FF_THREAD_SLICE;
+}
+
+void FFMpegVideoDecoder::discardStreamingFrame(const VideoFrame& f)
+{
+	AVFrame* frame=f.frame;
+	av_frame_free(&frame);
+}
+
+void FFMpegVideoDecoder::updateStreamingCapacity(int64_t decodeTime)
+{
+	//Smooth the latency over the last frames
+	if(decodeLatency==0)
+		decodeLatency=decodeTime;
+	else
+		decodeLatency=(decodeLatency*7+decodeTime)/8;
+	if(frameRate==0)
+		return;
+	//Keep the buffer time the consumer asked for (at least half a second)
+	//and enough frames to hide the jitter of slow decoding
+	double frames=frameRate*dmax(bufferTime,0.5)+4*decodeLatency*frameRate/1000000.0;
+	uint32_t capacity=FFMPEGVIDEODECODERBUFFERSIZE;
+	if(frames<FFMPEGVIDEODECODERBUFFERSIZE)
+		capacity=max(uint32_t(ceil(frames)),uint32_t(FFMPEGVIDEODECODERMINBUFFERSIZE));
+	Locker l(streamingMutex);
+	if(capacity>streamingCapacity)
+		streamingCond.broadcast();
+	streamingCapacity=capacity;
+}
+
 //setSize is called from the routine that inserts new frames
 void FFMpegVideoDecoder::setSize(uint32_t w, uint32_t h)
 {
+	//upload() reads the frame size and uploadBuffer of streamed video while holding only streamingMutex
+	Locker l(streamingMutex);
 	if(VideoDecoder::setSize(w,h))
 	{
 		//Discard all the frames
@@ -315,7 +363,7 @@ void FFMpegVideoDecoder::setSize(uint32_t w, uint32_t h)
 		if (embeddedvideotag)
 			embeddedbuffers.regen(YUVBufferGenerator(bufferSize,this->codecContext->pix_fmt==AV_PIX_FMT_YUVA420P));
 		else
-			streamingbuffers.regen(YUVBufferGenerator(bufferSize,this->codecContext->pix_fmt==AV_PIX_FMT_YUVA420P));
+			YUVBufferGenerator(bufferSize,this->codecContext->pix_fmt==AV_PIX_FMT_YUVA420P).init(uploadBuffer);
 	}
 }
 
@@ -336,12 +384,9 @@ uint32_t FFMpegVideoDecoder::skipUntil(uint32_t time)
 	}
 	else
 	{
-		while(1)
+		Locker l(streamingMutex);
+		while(!streamingframes.empty() && streamingframes.front().time<time)
 		{
-			if(streamingbuffers.isEmpty())
-				break;
-			if(streamingbuffers.front().time>=time)
-				break;
 			discardFrame();
 			ret++;
 		}
@@ -350,18 +395,25 @@ uint32_t FFMpegVideoDecoder::skipUntil(uint32_t time)
 }
 void FFMpegVideoDecoder::skipAll()
 {
-	while(!streamingbuffers.isEmpty())
-		discardFrame();
-	while(!embeddedbuffers.isEmpty())
-		discardFrame();
+	if (embeddedvideotag)
+	{
+		while(!embeddedbuffers.isEmpty())
+			discardFrame();
+	}
+	else
+	{
+		Locker l(streamingMutex);
+		while(!streamingframes.empty())
+			discardFrame();
+	}
 }
 
 bool FFMpegVideoDecoder::discardFrame()
 {
-	Locker locker(mutex);
 	//We don't want ot block if no frame is available
 	if (embeddedvideotag)
 	{
+		Locker locker(mutex);
 		bool ret=embeddedbuffers.nonBlockingPopFront();
 		if(flushing && embeddedbuffers.isEmpty()) //End of our work
 		{
@@ -374,8 +426,17 @@ bool FFMpegVideoDecoder::discardFrame()
 	}
 	else
 	{
-		bool ret=streamingbuffers.nonBlockingPopFront();
-		if(flushing && streamingbuffers.isEmpty()) //End of our work
+		//Streamed frames are only guarded by streamingMutex, as the producer
+		//may wait for room in the queue while holding the decoder mutex
+		Locker l(streamingMutex);
+		bool ret=!streamingframes.empty();
+		if(ret)
+		{
+			discardStreamingFrame(streamingframes.front());
+			streamingframes.pop_front();
+			streamingCond.signal();
+		}
+		if(flushing && streamingframes.empty()) //End of our work
 		{
 			status=FLUSHED;
 			flushed.signal();
@@ -391,6 +452,7 @@ bool FFMpegVideoDecoder::decodeData(uint8_t* data, uint32_t datalen, uint32_t ti
 	Locker locker(mutex);
 	if(datalen==0)
 		return false;
+	decodeStart=g_get_monotonic_time();
 #if defined HAVE_AVCODEC_SEND_PACKET && defined HAVE_AVCODEC_RECEIVE_FRAME
 	AVPacket* pkt = av_packet_alloc();
 	if (!pkt)
@@ -464,6 +526,7 @@ bool FFMpegVideoDecoder::decodeData(uint8_t* data, uint32_t datalen, uint32_t ti
 
 bool FFMpegVideoDecoder::decodePacket(AVPacket* pkt, uint32_t time)
 {
+	decodeStart=g_get_monotonic_time();
 #if defined HAVE_AVCODEC_SEND_PACKET && defined HAVE_AVCODEC_RECEIVE_FRAME
 	int ret = avcodec_send_packet(codecContext, pkt);
 	while (ret == 0)
@@ -529,38 +592,56 @@ bool FFMpegVideoDecoder::decodePacket(AVPacket* pkt, uint32_t time)
 
 void FFMpegVideoDecoder::copyFrameToBuffers(const AVFrame* frameIn, uint32_t time)
 {
-	YUVBuffer* curTail=nullptr;
-	curTail=embeddedvideotag ?  &embeddedbuffers.acquireLast() : &streamingbuffers.acquireLast();
-	//Only one thread may access the tail
+	if (embeddedvideotag)
+	{
+		//Only one thread may access the tail
+		YUVBuffer& curTail=embeddedbuffers.acquireLast();
+		copyFrameToYUVBuffer(frameIn,curTail);
+		curTail.time=time;
+		embeddedbuffers.commitLast();
+		return;
+	}
+	updateStreamingCapacity(g_get_monotonic_time()-decodeStart);
+	//Keep a reference to the decoded picture, the planes are only copied if the frame is displayed
+	AVFrame* frame=av_frame_clone(frameIn);
+	if(frame==nullptr)
+	{
+		LOG(LOG_ERROR,"cannot reference decoded video frame");
+		return;
+	}
+	Locker l(streamingMutex);
+	while(streamingframes.size()>=streamingCapacity)
+		streamingCond.wait(streamingMutex);
+	streamingframes.push_back(VideoFrame(frame,time));
+}
+
+void FFMpegVideoDecoder::copyFrameToYUVBuffer(const AVFrame* frameIn, YUVBuffer& buf)
+{
 	int offset[3]={0,0,0};
 	for(uint32_t y=0;y<frameHeight;y++)
 	{
-		memcpy(curTail->ch[0]+offset[0],frameIn->data[0]+(y*frameIn->linesize[0]),frameWidth);
+		memcpy(buf.ch[0]+offset[0],frameIn->data[0]+(y*frameIn->linesize[0]),frameWidth);
 		if (codecContext->pix_fmt==AV_PIX_FMT_YUVA420P)
-			memcpy(curTail->ch[3]+offset[0],frameIn->data[3]+(y*frameIn->linesize[0]),frameWidth);
+			memcpy(buf.ch[3]+offset[0],frameIn->data[3]+(y*frameIn->linesize[3]),frameWidth);
 		offset[0]+=frameWidth;
 	}
 	for(uint32_t y=0;y<frameHeight/2;y++)
 	{
-		memcpy(curTail->ch[1]+offset[1],frameIn->data[1]+(y*frameIn->linesize[1]),frameWidth/2);
-		memcpy(curTail->ch[2]+offset[2],frameIn->data[2]+(y*frameIn->linesize[2]),frameWidth/2);
+		memcpy(buf.ch[1]+offset[1],frameIn->data[1]+(y*frameIn->linesize[1]),frameWidth/2);
+		memcpy(buf.ch[2]+offset[2],frameIn->data[2]+(y*frameIn->linesize[2]),frameWidth/2);
 		offset[1]+=frameWidth/2;
 		offset[2]+=frameWidth/2;
 	}
-	curTail->time=time;
-	if (embeddedvideotag)
-		embeddedbuffers.commitLast();
-	else
-		streamingbuffers.commitLast();
 }
 
 void FFMpegVideoDecoder::upload(uint8_t* data, uint32_t w, uint32_t h)
 {
-	Locker l(mutex);
-	//Verify that the size are right
-	assert_and_throw(w==((frameWidth+15)&0xfffffff0) && h==frameHeight);
+	bool hasAlpha=codecContext->pix_fmt==AV_PIX_FMT_YUVA420P;
 	if (embeddedvideotag) // on embedded video we decode the frames during upload
 	{
+		Locker l(mutex);
+		//Verify that the size are right
+		assert_and_throw(w==((frameWidth+15)&0xfffffff0) && h==frameHeight);
 		if (currentframe != UINT32_MAX)
 		{
 			skipAll();
@@ -577,18 +658,37 @@ void FFMpegVideoDecoder::upload(uint8_t* data, uint32_t w, uint32_t h)
 			currentframe=0;
 		if(embeddedbuffers.isEmpty())
 			return;
-
+		//At least a frame is available
+		YUVBuffer& cur=embeddedbuffers.front();
+		convertYUVToTexture(data,cur.ch,hasAlpha);
 	}
 	else
 	{
-		if(streamingbuffers.isEmpty())
+		Locker l(streamingMutex);
+		//Verify that the size are right, setSize changes it while holding streamingMutex
+		assert_and_throw(w==((frameWidth+15)&0xfffffff0) && h==frameHeight);
+		if(streamingframes.empty())
 			return;
+		const AVFrame* frame=streamingframes.front().frame;
+		if(uint32_t(frame->linesize[0])==frameWidth && uint32_t(frame->linesize[1])==frameWidth/2 &&
+			uint32_t(frame->linesize[2])==frameWidth/2 && (!hasAlpha || uint32_t(frame->linesize[3])==frameWidth))
+		{
+			//The planes are already packed, convert them in place
+			uint8_t* ch[4]={frame->data[0],frame->data[1],frame->data[2],frame->data[3]};
+			convertYUVToTexture(data,ch,hasAlpha);
+		}
+		else
+		{
+			copyFrameToYUVBuffer(frame,uploadBuffer);
+			convertYUVToTexture(data,uploadBuffer.ch,hasAlpha);
+		}
 	}
-	
-	//At least a frame is available
-	YUVBuffer* cur=embeddedvideotag ? &embeddedbuffers.front() : &streamingbuffers.front();
-	fastYUV420ChannelsToYUV0Buffer(cur->ch[0],cur->ch[1],cur->ch[2],data,frameWidth,frameHeight);
-	if (codecContext->pix_fmt==AV_PIX_FMT_YUVA420P)
+}
+
+void FFMpegVideoDecoder::convertYUVToTexture(uint8_t* data, uint8_t* const ch[4], bool hasAlpha)
+{
+	fastYUV420ChannelsToYUV0Buffer(ch[0],ch[1],ch[2],data,frameWidth,frameHeight);
+	if (hasAlpha)
 	{
 		uint32_t texw= (frameWidth+15)&0xfffffff0;
 		for(uint32_t i=0;i<frameHeight;i++)
@@ -596,7 +696,7 @@ void FFMpegVideoDecoder::upload(uint8_t* data, uint32_t w, uint32_t h)
 			for(uint32_t j=0;j<frameWidth;j++)
 			{
 				uint32_t pixelCoordFull=i*texw+j;
-				data[pixelCoordFull*4+3]=cur->ch[3][i*frameWidth+j];
+				data[pixelCoordFull*4+3]=ch[3][i*frameWidth+j];
 			}
 		}
 	}
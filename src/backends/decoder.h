@@ -23,6 +23,7 @@
 #include "compat.h"
 #include "threading.h"
 #include "backends/graphics.h"
+#include <deque>
 #ifdef ENABLE_LIBAVCODEC
 extern "C"
 {
@@ -97,6 +98,10 @@ public:
 	{
 		flushed.wait();
 	}
+	bool isFlushed() const
+	{
+		return status==FLUSHED;
+	}
 };
 class DefineVideoStreamTag;
 class VideoDecoder: public Decoder, public ITextureUploadable
@@ -120,6 +125,8 @@ public:
 	double frameRate;
 	uint32_t framesdecoded;
 	uint32_t framesdropped;
+	//Seconds of video the consumer wants buffered, used to size the frame queue
+	double bufferTime;
 	/*
 		Useful to avoid destruction of the object while a pending upload is waiting
 	*/
@@ -169,6 +176,8 @@ public:
 	}
 };
 #ifdef ENABLE_LIBAVCODEC
+//Bounds of the queue of decoded frames of streamed video
+#define FFMPEGVIDEODECODERMINBUFFERSIZE 4
 #define FFMPEGVIDEODECODERBUFFERSIZE 80
 class FFMpegVideoDecoder: public VideoDecoder
 {
@@ -210,14 +219,41 @@ private:
 		YUVBufferGenerator(uint32_t b, bool _hasalpha):bufferSize(b),hasAlpha(_hasalpha){}
 		void init(YUVBuffer& buf) const;
 	};
+	class VideoFrame
+	{
+	public:
+		AVFrame* frame;
+		uint32_t time;
+		VideoFrame(AVFrame* f, uint32_t t):frame(f),time(t){}
+	};
 	bool ownedContext;
 	uint32_t curBuffer;
 	AVCodecContext* codecContext;
-	BlockingCircularQueue<YUVBuffer,FFMPEGVIDEODECODERBUFFERSIZE> streamingbuffers;
+	/*
+	   Decoded frames of streamed video, they reference the buffers owned by libavcodec.
+	   The queue is bounded by streamingCapacity, which follows the frame rate,
+	   the buffer time and the decoding latency
+	*/
+	std::deque<VideoFrame> streamingframes;
+	Mutex streamingMutex;
+	Cond streamingCond;
+	uint32_t streamingCapacity;
+	//Average decoding time of a frame in microseconds
+	double decodeLatency;
+	//Time the current packet was handed to the decoder
+	int64_t decodeStart;
+	//Used to pack the planes of a streamed frame before the conversion
+	YUVBuffer uploadBuffer;
 	BlockingCircularQueue<YUVBuffer,2> embeddedbuffers;
 	Mutex mutex;
 	AVFrame* frameIn;
+	void setupThreading();
+	void updateStreamingCapacity(int64_t decodeTime);
 	void copyFrameToBuffers(const AVFrame* frameIn, uint32_t time);
+	void copyFrameToYUVBuffer(const AVFrame* frameIn, YUVBuffer& buf);
+	//Converts packed YUV420 planes (and alpha, if any) to the texture data
+	void convertYUVToTexture(uint8_t* data, uint8_t* const ch[4], bool hasAlpha);
+	void discardStreamingFrame(const VideoFrame& f);
 	void setSize(uint32_t w, uint32_t h);
 	bool fillDataAndCheckValidity();
 	uint32_t curBufferOffset;
@@ -257,7 +293,8 @@ public:
 		}
 		else
 		{
-			if(streamingbuffers.isEmpty())
+			Locker l(streamingMutex);
+			if(streamingframes.empty())
 			{
 				status=FLUSHED;
 				flushed.signal();
@@ -269,6 +306,9 @@ public:
 };
 #endif
 
+// number of decoded frames an AudioDecoder can buffer
+#define AUDIO_DECODER_QUEUE_SIZE 150
+
 class AudioDecoder: public Decoder
 {
 protected:
@@ -290,7 +330,7 @@ protected:
 public:
 	uint32_t sampleRate;
 protected:
-	BlockingCircularQueue<FrameSamples,150> samplesBuffer;
+	BlockingCircularQueue<FrameSamples,AUDIO_DECODER_QUEUE_SIZE> samplesBuffer;
 public:
 	/**
 	  	The AudioDecoder contains audio buffers that must be aligned to 16 bytes, so we redefine the allocator
@@ -305,6 +345,11 @@ public:
 	{
 		return !samplesBuffer.isEmpty();
 	}
+	// number of decoded frames not yet consumed, may be slightly outdated when called during mixing
+	uint32_t getQueuedFrames() const
+	{
+		return samplesBuffer.len();
+	}
 	uint32_t getFrontTime() const;
 	uint32_t getBytesPerMSec() const
 	{
@@ -114,6 +114,10 @@ public:
 		Upload data to memory mapped to the graphics card (note: size is guaranteed to be enough
 	*/
 	virtual void upload(uint8_t* data, uint32_t w, uint32_t h)=0;
+	/*
+		Get the part of the data that has changed since the previous upload, only this part is copied to the texture
+	*/
+	virtual void uploadRegion(uint32_t& x, uint32_t& y, uint32_t& w, uint32_t& h) const { x=0; y=0; sizeNeeded(w,h); }
 	virtual const TextureChunk& getTexture()=0;
 	/*
 		Signal the completion of the upload to the texture
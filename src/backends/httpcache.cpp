@@ -0,0 +1,381 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2026  Lightspark Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include <unistd.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <cinttypes>
+#include <cstring>
+#include <sstream>
+#include <algorithm>
+#include <vector>
+#include "backends/httpcache.h"
+#include "backends/config.h"
+#ifdef ENABLE_CURL
+#include <curl/curl.h>
+#endif
+
+using namespace lightspark;
+using namespace std;
+
+//Heuristic freshness is a tenth of the age of the resource, but never more than a day
+#define HEURISTIC_MAX_AGE 86400
+//Pruning removes entries until the cache is this percentage of its maximum size, so it doesn't run again on the next store
+#define PRUNE_TARGET_PERCENT 90
+//Temporary files that were not written for this many seconds belong to interrupted downloads
+#define STALE_TEMP_FILE_AGE 3600
+
+bool HTTPCache::Entry::isFresh() const
+{
+	return expires > HTTPCache::now();
+}
+
+HTTPCache::Writer::~Writer()
+{
+	if(file.is_open())
+		file.close();
+	if(!tempFile.empty())
+		g_unlink(tempFile.raw_buf());
+}
+
+void HTTPCache::Writer::append(const uint8_t* buffer, uint32_t len)
+{
+	if(failed)
+		return;
+	length+=len;
+	if(length>HTTPCache::maxEntrySize)
+	{
+		failed=true;
+		return;
+	}
+	file.write((const char*)buffer,len);
+	if(file.fail())
+		failed=true;
+}
+
+HTTPCache::HTTPCache():enabled(false),maxSize(Config::getConfig()->getHTTPCacheSize()),usedSize(0),usedSizeKnown(false)
+{
+	std::string dir=Config::getConfig()->getCacheDirectory()+G_DIR_SEPARATOR_S+"http";
+	directory=tiny_string(dir);
+	//Without a writable directory every lookup is a miss
+	enabled=g_mkdir_with_parents(dir.c_str(),S_IRUSR | S_IWUSR | S_IXUSR)==0;
+	if(enabled)
+		removeStaleTempFiles();
+}
+
+void HTTPCache::removeStaleTempFiles()
+{
+	GDir* dir=g_dir_open(directory.raw_buf(),0,nullptr);
+	if(dir==nullptr)
+		return;
+	//Other instances may share the cache directory, so recent files are left alone
+	int64_t limit=now()-STALE_TEMP_FILE_AGE;
+	const gchar* name;
+	while((name=g_dir_read_name(dir))!=nullptr)
+	{
+		//Bodies are written to "bodyXXXXXX" and metadata to "<key>.meta.tmp" before they are renamed
+		bool isTemp=(strncmp(name,"body",4)==0 && strchr(name,'.')==nullptr) || g_str_has_suffix(name,".meta.tmp");
+		if(!isTemp)
+			continue;
+		std::string path=std::string(directory.raw_buf())+G_DIR_SEPARATOR_S+name;
+		GStatBuf st_buf;
+		if(g_stat(path.c_str(),&st_buf)==0 && (int64_t)st_buf.st_mtime<limit)
+			g_unlink(path.c_str());
+	}
+	g_dir_close(dir);
+}
+
+int64_t HTTPCache::now()
+{
+	return g_get_real_time()/G_USEC_PER_SEC;
+}
+
+int64_t HTTPCache::parseDate(const tiny_string& date)
+{
+#ifdef ENABLE_CURL
+	return curl_getdate(date.raw_buf(),nullptr);
+#else
+	return -1;
+#endif
+}
+
+/*
+ * The files of an entry are named after the FNV-1a hash of the URL,
+ * the metadata stores the full URL to detect collisions
+ */
+tiny_string HTTPCache::keyPath(const tiny_string& url) const
+{
+	uint64_t hash=0xcbf29ce484222325ULL;
+	const char* s=url.raw_buf();
+	for(uint32_t i=0;i<url.numBytes();i++)
+	{
+		hash^=(uint8_t)s[i];
+		hash*=0x100000001b3ULL;
+	}
+	char name[17];
+	snprintf(name,17,"%016" PRIx64,hash);
+	return directory+G_DIR_SEPARATOR_S+name;
+}
+
+bool HTTPCache::computeExpiration(const std::map<tiny_string, tiny_string>& headers, int64_t& expires)
+{
+	int64_t current=now();
+	expires=0;
+	auto it=headers.find("vary");
+	if(it!=headers.end() && it->second.find("*")!=tiny_string::npos)
+		return false;
+	it=headers.find("pragma");
+	if(it!=headers.end() && it->second.lowercase().find("no-cache")!=tiny_string::npos)
+		return true;
+	int64_t maxAge=-1;
+	it=headers.find("cache-control");
+	if(it!=headers.end())
+	{
+		std::string directives=it->second.lowercase().raw_buf();
+		std::istringstream tokens(directives);
+		std::string token;
+		while(std::getline(tokens,token,','))
+		{
+			token.erase(0,token.find_first_not_of(" \t"));
+			if(token.compare(0,8,"no-store")==0)
+				return false;
+			if(token.compare(0,8,"no-cache")==0)
+				return true;
+			if(token.compare(0,8,"max-age=")==0)
+				maxAge=atoll(token.c_str()+8);
+		}
+	}
+	if(maxAge>=0)
+	{
+		it=headers.find("age");
+		if(it!=headers.end())
+			maxAge-=atoll(it->second.raw_buf());
+		expires=current+maxAge;
+		return true;
+	}
+	it=headers.find("expires");
+	if(it!=headers.end())
+	{
+		int64_t date=parseDate(it->second);
+		expires=date>0 ? date : 0;
+		return true;
+	}
+	it=headers.find("last-modified");
+	if(it!=headers.end())
+	{
+		int64_t date=parseDate(it->second);
+		if(date>0 && date<current)
+			expires=current+min<int64_t>((current-date)/10,HEURISTIC_MAX_AGE);
+	}
+	return true;
+}
+
+bool HTTPCache::lookup(const tiny_string& url, Entry& entry)
+{
+	if(!enabled)
+		return false;
+	tiny_string path=keyPath(url);
+	Locker l(mutex);
+	std::ifstream meta((path+".meta").raw_buf());
+	if(!meta.is_open())
+		return false;
+	bool sameURL=false;
+	std::string line;
+	while(std::getline(meta,line))
+	{
+		size_t space=line.find(' ');
+		if(space==std::string::npos)
+			continue;
+		std::string key=line.substr(0,space);
+		std::string value=line.substr(space+1);
+		if(key=="url")
+			sameURL=(value==url.raw_buf());
+		else if(key=="length")
+			entry.length=strtoul(value.c_str(),nullptr,10);
+		else if(key=="expires")
+			entry.expires=atoll(value.c_str());
+		else if(key=="etag")
+			entry.etag=value;
+		else if(key=="last-modified")
+			entry.lastModified=value;
+		else if(key=="content-type")
+			entry.contentType=value;
+	}
+	if(!sameURL)
+		return false;
+	entry.bodyFile=path+".body";
+	//The body may have been replaced or truncated by another process
+	GStatBuf st_buf;
+	if(g_stat(entry.bodyFile.raw_buf(),&st_buf)!=0 || (uint64_t)st_buf.st_size!=entry.length)
+		return false;
+	//Mark the entry as recently used
+	g_utime(entry.bodyFile.raw_buf(),nullptr);
+	return true;
+}
+
+void HTTPCache::prune()
+{
+	struct bodyFile
+	{
+		std::string path;
+		uint64_t size;
+		int64_t lastUse;
+		bool operator<(const bodyFile& r) const { return lastUse<r.lastUse; }
+	};
+	GDir* dir=g_dir_open(directory.raw_buf(),0,nullptr);
+	if(dir==nullptr)
+		return;
+	std::vector<bodyFile> bodies;
+	usedSize=0;
+	const gchar* name;
+	while((name=g_dir_read_name(dir))!=nullptr)
+	{
+		if(!g_str_has_suffix(name,".body"))
+			continue;
+		std::string path=std::string(directory.raw_buf())+G_DIR_SEPARATOR_S+name;
+		GStatBuf st_buf;
+		if(g_stat(path.c_str(),&st_buf)!=0)
+			continue;
+		bodies.push_back(bodyFile{path,(uint64_t)st_buf.st_size,(int64_t)st_buf.st_mtime});
+		usedSize+=st_buf.st_size;
+	}
+	g_dir_close(dir);
+	usedSizeKnown=true;
+	if(maxSize==0 || usedSize<=maxSize)
+		return;
+	std::sort(bodies.begin(),bodies.end());
+	uint64_t target=maxSize/100*PRUNE_TARGET_PERCENT;
+	for(auto it=bodies.begin();it!=bodies.end() && usedSize>target;++it)
+	{
+		//The metadata goes first, so that a lookup never finds an entry without its body
+		std::string meta=it->path.substr(0,it->path.size()-5)+".meta";
+		g_unlink(meta.c_str());
+		if(g_unlink(it->path.c_str())==0)
+			usedSize-=it->size;
+	}
+}
+
+bool HTTPCache::writeMeta(const tiny_string& url, const Entry& entry)
+{
+	tiny_string path=keyPath(url);
+	tiny_string tmp=path+".meta.tmp";
+	{
+		std::ofstream meta(tmp.raw_buf(),std::ios::out|std::ios::trunc);
+		if(!meta.is_open())
+			return false;
+		meta << "url " << url << "\n";
+		meta << "length " << entry.length << "\n";
+		meta << "expires " << entry.expires << "\n";
+		if(!entry.etag.empty())
+			meta << "etag " << entry.etag << "\n";
+		if(!entry.lastModified.empty())
+			meta << "last-modified " << entry.lastModified << "\n";
+		if(!entry.contentType.empty())
+			meta << "content-type " << entry.contentType << "\n";
+		if(meta.fail())
+			return false;
+	}
+	return g_rename(tmp.raw_buf(),(path+".meta").raw_buf())==0;
+}
+
+HTTPCache::Writer* HTTPCache::startWriting(const std::map<tiny_string, tiny_string>& headers, uint32_t expectedLength)
+{
+	if(!enabled || expectedLength>maxEntrySize)
+		return nullptr;
+	int64_t expires;
+	if(!computeExpiration(headers,expires))
+		return nullptr;
+	//An entry that is already stale and cannot be revalidated is useless
+	if(expires<=now() && headers.find("etag")==headers.end() && headers.find("last-modified")==headers.end())
+		return nullptr;
+	std::string tmp=std::string(directory.raw_buf())+G_DIR_SEPARATOR_S+"bodyXXXXXX";
+	int fd=g_mkstemp(&tmp[0]);
+	if(fd==-1)
+		return nullptr;
+	close(fd);
+	Writer* writer=new Writer();
+	writer->tempFile=tiny_string(tmp);
+	writer->file.open(tmp.c_str(),std::ios::out|std::ios::binary|std::ios::trunc);
+	if(!writer->file.is_open())
+	{
+		delete writer;
+		return nullptr;
+	}
+	return writer;
+}
+
+void HTTPCache::commit(const tiny_string& url, Writer* writer, const std::map<tiny_string, tiny_string>& headers)
+{
+	writer->file.close();
+	Entry entry;
+	if(!writer->failed && !writer->file.fail() && computeExpiration(headers,entry.expires))
+	{
+		entry.length=writer->length;
+		auto it=headers.find("etag");
+		if(it!=headers.end())
+			entry.etag=it->second;
+		it=headers.find("last-modified");
+		if(it!=headers.end())
+			entry.lastModified=it->second;
+		it=headers.find("content-type");
+		if(it!=headers.end())
+			entry.contentType=it->second;
+		tiny_string path=keyPath(url);
+		Locker l(mutex);
+		if(g_rename(writer->tempFile.raw_buf(),(path+".body").raw_buf())==0)
+		{
+			writer->tempFile="";
+			if(!writeMeta(url,entry))
+				g_unlink((path+".meta").raw_buf());
+			//A replaced entry is counted twice, prune corrects the estimate
+			usedSize+=entry.length;
+			if(!usedSizeKnown || (maxSize!=0 && usedSize>maxSize))
+				prune();
+		}
+	}
+	delete writer;
+}
+
+void HTTPCache::refresh(const tiny_string& url, Entry& entry, const std::map<tiny_string, tiny_string>& headers)
+{
+	int64_t expires;
+	Locker l(mutex);
+	if(!computeExpiration(headers,expires))
+	{
+		l.release();
+		remove(url);
+		return;
+	}
+	entry.expires=expires;
+	auto it=headers.find("etag");
+	if(it!=headers.end())
+		entry.etag=it->second;
+	it=headers.find("last-modified");
+	if(it!=headers.end())
+		entry.lastModified=it->second;
+	writeMeta(url,entry);
+}
+
+void HTTPCache::remove(const tiny_string& url)
+{
+	tiny_string path=keyPath(url);
+	Locker l(mutex);
+	g_unlink((path+".meta").raw_buf());
+	g_unlink((path+".body").raw_buf());
+}
@@ -0,0 +1,112 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2026  Lightspark Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef BACKENDS_HTTPCACHE_H
+#define BACKENDS_HTTPCACHE_H 1
+
+#include "compat.h"
+#include <fstream>
+#include <map>
+#include "threading.h"
+#include "tiny_string.h"
+
+namespace lightspark
+{
+
+/*
+ * On-disk cache of HTTP responses, keyed by URL.
+ *
+ * Every entry is a body file and a metadata file in the "http" subdirectory
+ * of the cache directory. The metadata holds the validators (ETag and
+ * Last-Modified) and the expiration time computed from Cache-Control,
+ * Expires or, as a fallback, the age of the resource.
+ * The body file is complete and can be handed to FileStreamCache::useExistingFile.
+ * The modification time of a body file is its last use: when the bodies grow
+ * beyond the configured size, the least recently used entries are removed.
+ */
+class DLL_PUBLIC HTTPCache
+{
+public:
+	class Entry
+	{
+	public:
+		tiny_string bodyFile;
+		tiny_string etag;
+		tiny_string lastModified;
+		tiny_string contentType;
+		//Expiration time in seconds since the epoch, 0 means that the entry must be revalidated
+		int64_t expires;
+		uint32_t length;
+		Entry():expires(0),length(0){}
+		bool isFresh() const;
+		bool canRevalidate() const { return !etag.empty() || !lastModified.empty(); }
+	};
+	/*
+	 * Collects the body of a response while it is downloaded.
+	 * The entry only becomes visible when it is committed
+	 */
+	class DLL_PUBLIC Writer
+	{
+	friend class HTTPCache;
+	private:
+		tiny_string tempFile;
+		std::ofstream file;
+		uint32_t length;
+		bool failed;
+		Writer():length(0),failed(false){}
+	public:
+		~Writer();
+		void append(const uint8_t* buffer, uint32_t len);
+	};
+private:
+	Mutex mutex;
+	tiny_string directory;
+	bool enabled;
+	//Maximum total size of the bodies, 0 means unlimited
+	uint64_t maxSize;
+	//Estimated total size of the bodies, only exact after prune
+	uint64_t usedSize;
+	bool usedSizeKnown;
+	tiny_string keyPath(const tiny_string& url) const;
+	//Recomputes usedSize and removes the least recently used entries if it exceeds maxSize, must be called with the mutex held
+	void prune();
+	//Removes the temporary files left behind by interrupted downloads
+	void removeStaleTempFiles();
+	bool writeMeta(const tiny_string& url, const Entry& entry);
+	static int64_t now();
+	static int64_t parseDate(const tiny_string& date);
+	//Computes the expiration time of a response, returns false if it must not be stored
+	static bool computeExpiration(const std::map<tiny_string, tiny_string>& headers, int64_t& expires);
+public:
+	//Responses larger than this are not stored
+	static const uint32_t maxEntrySize = 16*1024*1024;
+	HTTPCache();
+	//Fills entry with the cached response for url, returns false on a miss
+	bool lookup(const tiny_string& url, Entry& entry);
+	//Returns a writer for a response that may be stored, or nullptr
+	Writer* startWriting(const std::map<tiny_string, tiny_string>& headers, uint32_t expectedLength);
+	//Makes the collected body the cached response for url and deletes the writer
+	void commit(const tiny_string& url, Writer* writer, const std::map<tiny_string, tiny_string>& headers);
+	//Updates the expiration and the validators of an entry after a 304 answer
+	void refresh(const tiny_string& url, Entry& entry, const std::map<tiny_string, tiny_string>& headers);
+	void remove(const tiny_string& url);
+};
+
+}
+#endif /* BACKENDS_HTTPCACHE_H */
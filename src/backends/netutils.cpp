@@ -38,6 +38,49 @@
 
 using namespace lightspark;
 
+#ifdef ENABLE_CURL
+/**
+ * \brief Wrapper of a curl share handle
+ *
+ * Lets the easy handles of concurrent downloads share DNS results, TLS sessions
+ * and (on curl >= 7.57) open connections, so that keep-alive works across loads.
+ */
+class lightspark::CurlShare
+{
+private:
+	Mutex locks[CURL_LOCK_DATA_LAST];
+	static void lock(CURL*, curl_lock_data data, curl_lock_access, void* userp)
+	{
+		static_cast<CurlShare*>(userp)->locks[data].lock();
+	}
+	static void unlock(CURL*, curl_lock_data data, void* userp)
+	{
+		static_cast<CurlShare*>(userp)->locks[data].unlock();
+	}
+public:
+	CURLSH* handle;
+	CurlShare()
+	{
+		handle=curl_share_init();
+		if(!handle)
+			return;
+		curl_share_setopt(handle, CURLSHOPT_LOCKFUNC, lock);
+		curl_share_setopt(handle, CURLSHOPT_UNLOCKFUNC, unlock);
+		curl_share_setopt(handle, CURLSHOPT_USERDATA, this);
+		curl_share_setopt(handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+		curl_share_setopt(handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900
+		curl_share_setopt(handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+	}
+	~CurlShare()
+	{
+		if(handle)
+			curl_share_cleanup(handle);
+	}
+};
+#endif
+
 /**
  * \brief Download manager constructor
  *
@@ -103,8 +146,14 @@ void StandaloneDownloadManager::destroy(Downloader* downloader)
 	//If the downloader was still in the active-downloader list, delete it
 	if(removeDownloader(downloader))
 	{
-		downloader->waitForTermination();
 		ThreadedDownloader* thd=dynamic_cast<ThreadedDownloader*>(downloader);
+		//A download that never started will not terminate by itself
+		if(thd && scheduler.cancel(thd))
+		{
+			thd->stop();
+			thd->jobFence();
+		}
+		downloader->waitForTermination();
 		if(thd)
 			thd->waitFencing();
 		delete downloader;
@@ -148,14 +197,21 @@ bool DownloadManager::removeDownloader(Downloader* downloader)
  * The standalone download manager produces \c ThreadedDownloader-type \c Downloaders.
  * It should only be used in the standalone version of LS.
  */
-StandaloneDownloadManager::StandaloneDownloadManager()
+StandaloneDownloadManager::StandaloneDownloadManager():curlShare(nullptr)
 {
 	type = STANDALONE;
+#ifdef ENABLE_CURL
+	curlShare = new CurlShare();
+#endif
 }
 
 StandaloneDownloadManager::~StandaloneDownloadManager()
 {
 	cleanUp();
+	//All the easy handles using the share are gone now
+#ifdef ENABLE_CURL
+	delete curlShare;
+#endif
 }
 
 /**
@@ -192,7 +248,11 @@ Downloader* StandaloneDownloadManager::download(const URLInfo& url, _R<StreamCac
 	else
 	{
 		LOG(LOG_INFO, _("NET: STANDALONE: DownloadManager: remote file"));
-		downloader=new CurlDownloader(url.getParsedURL(), cache, owner);
+		downloader=new CurlDownloader(url.getParsedURL(), cache, owner, curlShare, &httpCache);
+		downloader->enableFencingWaiting();
+		addDownloader(downloader);
+		scheduler.enqueue(downloader, url);
+		return downloader;
 	}
 	downloader->enableFencingWaiting();
 	addDownloader(downloader);
@@ -226,7 +286,11 @@ Downloader* StandaloneDownloadManager::downloadWithData(const URLInfo& url, _R<S
 	else
 	{
 		LOG(LOG_INFO, _("NET: STANDALONE: DownloadManager: remote file"));
-		downloader=new CurlDownloader(url.getParsedURL(), cache, data, headers, owner);
+		downloader=new CurlDownloader(url.getParsedURL(), cache, data, headers, owner, curlShare);
+		downloader->enableFencingWaiting();
+		addDownloader(downloader);
+		scheduler.enqueue(downloader, url);
+		return downloader;
 	}
 	downloader->enableFencingWaiting();
 	addDownloader(downloader);
@@ -234,6 +298,138 @@ Downloader* StandaloneDownloadManager::downloadWithData(const URLInfo& url, _R<S
 	return downloader;
 }
 
+DownloadScheduler::DownloadScheduler():runningMedia(0),dispatching(false)
+{
+}
+
+/**
+ * \brief Guesses the priority class of a download from its URL
+ *
+ * Policy files and the main movie block the content, so they come first.
+ * Unknown resources (SWFs, XML, JSON and other data) are treated as code.
+ */
+DownloadScheduler::PRIORITY DownloadScheduler::classify(const URLInfo& url)
+{
+	SystemState* sys=getSys();
+	if(sys && sys->mainClip && url==sys->mainClip->getOrigin())
+		return PRIORITY_MAIN;
+	tiny_string file=url.getPathFile().lowercase();
+	if(file=="crossdomain.xml")
+		return PRIORITY_MAIN;
+	uint32_t dot=file.rfind(".");
+	if(dot==tiny_string::npos)
+		return PRIORITY_CODE;
+	tiny_string ext=file.substr(dot+1,file.numChars()-dot-1);
+	if(ext=="png" || ext=="jpg" || ext=="jpeg" || ext=="gif")
+		return PRIORITY_IMAGE;
+	if(ext=="flv" || ext=="f4v" || ext=="mp4" || ext=="m4v" || ext=="mp3" || ext=="m4a" || ext=="aac")
+		return PRIORITY_MEDIA;
+	return PRIORITY_CODE;
+}
+
+/**
+ * \brief Queues a download, it starts as soon as the limits allow it
+ */
+void DownloadScheduler::enqueue(ThreadedDownloader* downloader, const URLInfo& url)
+{
+	Locker l(mutex);
+	PRIORITY p=classify(url);
+	downloader->scheduler=this;
+	queues[p].push_back(Job(downloader,url.getHostname(),p));
+	dispatch(l);
+}
+
+bool DownloadScheduler::cancel(ThreadedDownloader* downloader)
+{
+	Locker l(mutex);
+	for(uint32_t p=0;p<PRIORITY_COUNT;p++)
+	{
+		for(auto it=queues[p].begin();it!=queues[p].end();++it)
+		{
+			if(it->downloader==downloader)
+			{
+				queues[p].erase(it);
+				downloader->scheduler=nullptr;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/**
+ * \brief Releases the slot of a download, called from the job fence
+ */
+void DownloadScheduler::jobFinished(ThreadedDownloader* downloader)
+{
+	Locker l(mutex);
+	downloader->scheduler=nullptr;
+	for(auto it=running.begin();it!=running.end();++it)
+	{
+		if(it->downloader==downloader)
+		{
+			if(--runningPerHost[it->host]==0)
+				runningPerHost.erase(it->host);
+			if(it->priority==PRIORITY_MEDIA)
+				runningMedia--;
+			running.erase(it);
+			break;
+		}
+	}
+	dispatch(l);
+}
+
+/**
+ * \brief Starts queued downloads until a limit is reached
+ *
+ * The mutex is released while handing a job to the thread pool, as the pool may
+ * fence it right away (and so call jobFinished) when it is stopping.
+ */
+void DownloadScheduler::dispatch(Locker& l)
+{
+	if(dispatching)
+		return;
+	dispatching=true;
+	while(running.size()<maxRunning)
+	{
+		std::list<Job>::iterator next;
+		bool found=false;
+		for(uint32_t p=0;p<PRIORITY_COUNT && !found;p++)
+		{
+			if(p==PRIORITY_MEDIA && runningMedia>=maxRunningMedia)
+				continue;
+			uint32_t leastRunning=maxRunningPerHost;
+			for(auto it=queues[p].begin();it!=queues[p].end();++it)
+			{
+				auto host=runningPerHost.find(it->host);
+				uint32_t hostRunning=host==runningPerHost.end() ? 0 : host->second;
+				if(hostRunning<leastRunning)
+				{
+					leastRunning=hostRunning;
+					next=it;
+					found=true;
+					if(hostRunning==0)
+						break;
+				}
+			}
+			if(found)
+			{
+				running.splice(running.end(),queues[p],next);
+				runningPerHost[next->host]++;
+				if(next->priority==PRIORITY_MEDIA)
+					runningMedia++;
+			}
+		}
+		if(!found)
+			break;
+		ThreadedDownloader* downloader=next->downloader;
+		l.release();
+		getSys()->addDownloadJob(downloader);
+		l.acquire();
+	}
+	dispatching=false;
+}
+
 /**
  * \brief Downloader constructor.
  *
@@ -244,7 +440,7 @@ Downloader* StandaloneDownloadManager::downloadWithData(const URLInfo& url, _R<S
 Downloader::Downloader(const tiny_string& _url, _R<StreamCache> _cache, ILoadable* o):
 	url(_url),originalURL(url),                                   //PROPERTIES
 	cache(_cache),                                                //CACHING
-	owner(o),                                                     //PROGRESS
+	owner(o),lastProgressTime(0),progressPending(false),          //PROGRESS
 	redirected(false),requestStatus(0),                           //HTTP REDIR, STATUS & HEADERS
 	length(0),                                                    //DOWNLOADED DATA
 	emptyanswer(false)
@@ -261,7 +457,7 @@ Downloader::Downloader(const tiny_string& _url, _R<StreamCache> _cache, ILoadabl
 Downloader::Downloader(const tiny_string& _url, _R<StreamCache> _cache, const std::vector<uint8_t>& _data, const std::list<tiny_string>& h, ILoadable* o):
 	url(_url),originalURL(url),                                      //PROPERTIES
 	cache(_cache),                                                   //CACHING
-	owner(o),                                                        //PROGRESS
+	owner(o),lastProgressTime(0),progressPending(false),             //PROGRESS
 	redirected(false),requestStatus(0),requestHeaders(h),data(_data),//HTTP REDIR, STATUS & HEADERS
 	length(0),                                                       //DOWNLOADED DATA
 	emptyanswer(false)
@@ -304,6 +500,11 @@ void Downloader::setFailed()
  */
 void Downloader::setFinished()
 {
+	if(progressPending)
+	{
+		progressPending=false;
+		notifyOwnerAboutBytesLoaded();
+	}
 	length = cache->markFinished();
 	LOG(LOG_INFO,"download finished:"<<url<<" "<<length);
 }
@@ -334,6 +535,8 @@ void Downloader::setLength(uint32_t _length)
  * Waits for mutex at start and releases mutex when finished.
  * \post \c buffer/cache contains the added data
  * \post \c length = \c receivedLength + \c added
+ * Progress is reported to the owner at most once per frame, the last update is
+ * flushed by \c setFinished().
  * \see Downloader::setLength()
  */
 void Downloader::append(uint8_t* buf, uint32_t added)
@@ -347,6 +550,18 @@ void Downloader::append(uint8_t* buf, uint32_t added)
 	if (cache->getReceivedLength() > length)
 		setLength(cache->getReceivedLength());
 
+	uint64_t interval=1000/24;
+	SystemState* sys=getSys();
+	if(sys && sys->mainClip && sys->mainClip->getFrameRate()>0)
+		interval=uint64_t(1000/sys->mainClip->getFrameRate());
+	uint64_t now=compat_msectiming();
+	if(now-lastProgressTime<interval)
+	{
+		progressPending=true;
+		return;
+	}
+	lastProgressTime=now;
+	progressPending=false;
 	notifyOwnerAboutBytesLoaded();
 }
 
@@ -486,6 +701,8 @@ void ThreadedDownloader::enableFencingWaiting()
  */
 void ThreadedDownloader::jobFence()
 {
+	if(scheduler)
+		scheduler->jobFinished(this);
 	RELEASE_WRITE(fenceState,false);
 }
 
@@ -502,7 +719,7 @@ void ThreadedDownloader::waitFencing()
  * \param[in] _cached Whether or not to cache this download.
  */
 ThreadedDownloader::ThreadedDownloader(const tiny_string& url, _R <StreamCache> cache, ILoadable* o):
-	Downloader(url, cache, o),fenceState(false)
+	Downloader(url, cache, o),fenceState(false),scheduler(nullptr)
 {
 }
 
@@ -516,7 +733,7 @@ ThreadedDownloader::ThreadedDownloader(const tiny_string& url, _R <StreamCache>
 ThreadedDownloader::ThreadedDownloader(const tiny_string& url, _R<StreamCache> cache,
 				       const std::vector<uint8_t>& data,
 				       const std::list<tiny_string>& headers, ILoadable* o):
-	Downloader(url, cache, data, headers, o),fenceState(false)
+	Downloader(url, cache, data, headers, o),fenceState(false),scheduler(nullptr)
 {
 }
 
@@ -538,8 +755,9 @@ ThreadedDownloader::~ThreadedDownloader()
  * \param[in] _url The URL for the Downloader.
  * \param[in] _cached Whether or not to cache this download.
  */
-CurlDownloader::CurlDownloader(const tiny_string& _url, _R<StreamCache> _cache, ILoadable* o):
-	ThreadedDownloader(_url, _cache, o)
+CurlDownloader::CurlDownloader(const tiny_string& _url, _R<StreamCache> _cache, ILoadable* o,
+			       CurlShare* _share, HTTPCache* _httpCache):
+	ThreadedDownloader(_url, _cache, o),share(_share),httpCache(_httpCache),cacheWriter(nullptr),cacheable(false)
 {
 }
 
@@ -551,9 +769,14 @@ CurlDownloader::CurlDownloader(const tiny_string& _url, _R<StreamCache> _cache,
  */
 CurlDownloader::CurlDownloader(const tiny_string& _url, _R<StreamCache> _cache,
 			       const std::vector<uint8_t>& _data,
-			       const std::list<tiny_string>& _headers, ILoadable* o):
-	ThreadedDownloader(_url, _cache, _data, _headers, o)
+			       const std::list<tiny_string>& _headers, ILoadable* o, CurlShare* _share):
+	ThreadedDownloader(_url, _cache, _data, _headers, o),share(_share),httpCache(nullptr),cacheWriter(nullptr),cacheable(false)
+{
+}
+
+CurlDownloader::~CurlDownloader()
 {
+	delete cacheWriter;
 }
 
 /**
@@ -578,12 +801,25 @@ void CurlDownloader::execute()
 	}
 	LOG(LOG_INFO, _("NET: CurlDownloader::execute: reading remote file: ") << url.raw_buf());
 #ifdef ENABLE_CURL
+	//Only plain GET requests are cached
+	cacheable = httpCache && data.empty() && requestHeaders.empty();
+	HTTPCache::Entry cachedEntry;
+	bool hasCachedEntry = cacheable && httpCache->lookup(originalURL, cachedEntry);
+	if(hasCachedEntry)
+	{
+		if(cachedEntry.isFresh() && serveFromHTTPCache(cachedEntry))
+			return;
+		//A stale entry without validators can't be reused
+		hasCachedEntry = cachedEntry.canRevalidate();
+	}
 	CURL *curl;
 	CURLcode res;
 	curl = curl_easy_init();
 	if(curl)
 	{
 		curl_easy_setopt(curl, CURLOPT_URL, url.raw_buf());
+		if(share && share->handle)
+			curl_easy_setopt(curl, CURLOPT_SHARE, share->handle);
 		//Needed for thread-safety reasons.
 		//This makes CURL not respect DNS resolving timeouts.
 		//TODO: openssl needs locking callbacks. We should implement these.
@@ -623,6 +859,14 @@ void CurlDownloader::execute()
 				hasContentType |= it->lowercase().startsWith("content-type:");
 			}
 		}
+		//Ask the server to answer 304 if our copy is still valid
+		if(hasCachedEntry)
+		{
+			if(!cachedEntry.etag.empty())
+				headerList=curl_slist_append(headerList, (tiny_string("If-None-Match: ")+cachedEntry.etag).raw_buf());
+			if(!cachedEntry.lastModified.empty())
+				headerList=curl_slist_append(headerList, (tiny_string("If-Modified-Since: ")+cachedEntry.lastModified).raw_buf());
+		}
 
 		if(!data.empty())
 		{
@@ -649,6 +893,24 @@ void CurlDownloader::execute()
 			setFailed();
 			return;
 		}
+		if(hasCachedEntry && getRequestStatus() == 304)
+		{
+			httpCache->refresh(originalURL, cachedEntry, headers);
+			if(serveFromHTTPCache(cachedEntry))
+				return;
+			httpCache->remove(originalURL);
+			setFailed();
+			return;
+		}
+		if(cacheWriter)
+		{
+			//Redirected answers are not stored, as the loader needs to know the final URL
+			if(getRequestStatus() == 200 && !redirected && !cache->hasFailed())
+				httpCache->commit(originalURL, cacheWriter, headers);
+			else
+				delete cacheWriter;
+			cacheWriter=nullptr;
+		}
 	}
 	else
 	{
@@ -665,6 +927,47 @@ void CurlDownloader::execute()
 	setFinished();
 }
 
+/**
+ * \brief Completes the download with a response stored in the HTTP cache
+ *
+ * A FileStreamCache reads the cached body in place, other caches get a copy.
+ * \return false if the cached body could not be read, nothing has been appended in that case
+ */
+bool CurlDownloader::serveFromHTTPCache(const HTTPCache::Entry& entry)
+{
+	LOG(LOG_INFO, _("NET: CurlDownloader: using cached response for ") << originalURL);
+	FileStreamCache *fileCache = dynamic_cast<FileStreamCache *>(cache.getPtr());
+	std::ifstream file;
+	if(!fileCache)
+	{
+		file.open(entry.bodyFile.raw_buf(), std::ios::in|std::ios::binary);
+		if(!file.is_open())
+			return false;
+	}
+	requestStatus = 200;
+	if(!entry.contentType.empty())
+		headers.insert(std::make_pair(tiny_string("content-type"), entry.contentType));
+	if(entry.length == 0)
+		emptyanswer = true;
+	if(fileCache)
+	{
+		fileCache->useExistingFile(entry.bodyFile);
+		length = fileCache->getReceivedLength();
+		notifyOwnerAboutBytesLoaded();
+		notifyOwnerAboutBytesTotal();
+		return true;
+	}
+	setLength(entry.length);
+	char buffer[8192];
+	while(file && !cache->hasFailed())
+	{
+		file.read(buffer, sizeof(buffer));
+		append((uint8_t *) buffer, file.gcount());
+	}
+	setFinished();
+	return true;
+}
+
 /**
  * \brief Progress callback for CURL
  *
@@ -688,6 +991,17 @@ size_t CurlDownloader::write_data(void *buffer, size_t size, size_t nmemb, void
 	size_t added=size*nmemb;
 	if(th->getRequestStatus()/100 == 2 || th->getRequestStatus()/100 == 3)
 		th->append((uint8_t*)buffer,added);
+	if(th->cacheable && th->getRequestStatus() == 200)
+	{
+		//The headers are complete once the body starts
+		if(th->cacheWriter==nullptr)
+		{
+			th->cacheWriter=th->httpCache->startWriting(th->headers, th->length);
+			th->cacheable=th->cacheWriter!=nullptr;
+		}
+		if(th->cacheWriter)
+			th->cacheWriter->append((uint8_t*)buffer,added);
+	}
 	return added;
 }
 
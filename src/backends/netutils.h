@@ -30,12 +30,15 @@
 #include "thread_pool.h"
 #include "backends/urlutils.h"
 #include "backends/streamcache.h"
+#include "backends/httpcache.h"
 #include "smartrefs.h"
 
 namespace lightspark
 {
 
 class Downloader;
+class ThreadedDownloader;
+class CurlShare;
 
 class ILoadable
 {
@@ -69,8 +72,55 @@ public:
 	MANAGERTYPE type;
 };
 
+/*
+ * Orders the remote downloads of a StandaloneDownloadManager.
+ *
+ * Queued downloads start by priority class, with at most maxRunningPerHost
+ * downloads for each host and maxRunning overall. Media may only use
+ * maxRunningMedia of the slots, so long transfers can't hold back the small
+ * assets the content is waiting for. In a class, the host with the fewest
+ * running downloads goes first.
+ */
+class DownloadScheduler
+{
+public:
+	enum PRIORITY { PRIORITY_MAIN=0, PRIORITY_CODE, PRIORITY_IMAGE, PRIORITY_MEDIA, PRIORITY_COUNT };
+	static const uint32_t maxRunning=16;
+	static const uint32_t maxRunningPerHost=6;
+	static const uint32_t maxRunningMedia=8;
+private:
+	class Job
+	{
+	public:
+		ThreadedDownloader* downloader;
+		tiny_string host;
+		PRIORITY priority;
+		Job(ThreadedDownloader* d, const tiny_string& h, PRIORITY p):downloader(d),host(h),priority(p){}
+	};
+	Mutex mutex;
+	std::list<Job> queues[PRIORITY_COUNT];
+	std::list<Job> running;
+	std::map<tiny_string, uint32_t> runningPerHost;
+	uint32_t runningMedia;
+	//Set while jobs are being handed to the thread pool, the loop picks up slots freed meanwhile
+	bool dispatching;
+	void dispatch(Locker& l);
+public:
+	DownloadScheduler();
+	static PRIORITY classify(const URLInfo& url);
+	void enqueue(ThreadedDownloader* downloader, const URLInfo& url);
+	//Removes a download that has not started yet, returns false if it is not queued
+	bool cancel(ThreadedDownloader* downloader);
+	void jobFinished(ThreadedDownloader* downloader);
+};
+
 class DLL_PUBLIC StandaloneDownloadManager:public DownloadManager
 {
+private:
+	DownloadScheduler scheduler;
+	//Shared by all the CurlDownloaders to reuse connections, DNS lookups and TLS sessions
+	CurlShare* curlShare;
+	HTTPCache httpCache;
 public:
 	StandaloneDownloadManager();
 	~StandaloneDownloadManager();
@@ -106,6 +156,9 @@ protected:
 	ILoadable* owner;
 	void notifyOwnerAboutBytesTotal() const;
 	void notifyOwnerAboutBytesLoaded() const;
+	//Progress of appended data is reported at most once per frame
+	uint64_t lastProgressTime;
+	bool progressPending;
 
 	//-- HTTP REDIRECTION, STATUS & HEADERS
 	bool redirected:1;
@@ -172,8 +225,11 @@ public:
 
 class ThreadedDownloader : public Downloader, public IThreadJob
 {
+friend class DownloadScheduler;
 private:
 	ACQUIRE_RELEASE_FLAG(fenceState);
+	//Set while the download is queued or running in the scheduler
+	DownloadScheduler* scheduler;
 public:
 	void enableFencingWaiting();
 	void jobFence();
@@ -197,10 +253,18 @@ private:
 	static int progress_callback(void *clientp, double dltotal, double dlnow, double ultotal, double ulnow);
 	void execute();
 	void threadAbort();
+	CurlShare* share;
+	HTTPCache* httpCache;
+	//Receives the body of a response that will be stored in httpCache
+	HTTPCache::Writer* cacheWriter;
+	bool cacheable;
+	bool serveFromHTTPCache(const HTTPCache::Entry& entry);
 public:
-	CurlDownloader(const tiny_string& _url, _R<StreamCache> cache, ILoadable* o);
+	CurlDownloader(const tiny_string& _url, _R<StreamCache> cache, ILoadable* o,
+		       CurlShare* _share=nullptr, HTTPCache* _httpCache=nullptr);
 	CurlDownloader(const tiny_string& _url, _R<StreamCache> cache, const std::vector<uint8_t>& data,
-		       const std::list<tiny_string>& headers, ILoadable* o);
+		       const std::list<tiny_string>& headers, ILoadable* o, CurlShare* _share=nullptr);
+	~CurlDownloader();
 };
 
 //LocalDownloader can be used as a thread job, standalone or as a streambuf
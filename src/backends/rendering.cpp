@@ -107,8 +107,10 @@ void RenderThread::finalizeUpload()
 	ITextureUploadable* u=prevUploadJob;
 	uint32_t w,h;
 	u->sizeNeeded(w,h);
+	uint32_t rx,ry,rw,rh;
+	u->uploadRegion(rx,ry,rw,rh);
 	const TextureChunk& tex=u->getTexture();
-	loadChunkBGRA(tex, w, h, engineData->getCurrentPixBuf());
+	loadChunkBGRA(tex, w, h, engineData->getCurrentPixBuf(), rx, ry, rw, rh);
 	u->uploadFence();
 	prevUploadJob=nullptr;
 }
@@ -1103,7 +1105,7 @@ TextureChunk RenderThread::allocateTexture(uint32_t w, uint32_t h, bool compact)
 	return ret;
 }
 
-void RenderThread::loadChunkBGRA(const TextureChunk& chunk, uint32_t w, uint32_t h, uint8_t* data)
+void RenderThread::loadChunkBGRA(const TextureChunk& chunk, uint32_t w, uint32_t h, uint8_t* data, uint32_t rx, uint32_t ry, uint32_t rw, uint32_t rh)
 {
 	//Fast bailout if the TextureChunk is not valid
 	if(chunk.chunks==nullptr)
@@ -1122,6 +1124,9 @@ void RenderThread::loadChunkBGRA(const TextureChunk& chunk, uint32_t w, uint32_t
 		uint32_t curY=(i/blocksW)*CHUNKSIZE_REAL;
 		if (curX > w || curY > h)
 			break;
+		//Skip chunks that are not part of the changed region
+		if (curX >= rx+rw || curX+CHUNKSIZE_REAL <= rx || curY >= ry+rh || curY+CHUNKSIZE_REAL <= ry)
+			continue;
 		uint32_t sizeX=min(int(w-curX),CHUNKSIZE_REAL)+2;
 		uint32_t sizeY=min(int(h-curY),CHUNKSIZE_REAL)+2;
 		const uint32_t blockX=((chunk.chunks[i]%blocksPerSide)*CHUNKSIZE);
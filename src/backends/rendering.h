@@ -155,7 +155,8 @@ public:
 	/**
 		Load the given data in the given texture chunk
 	*/
-	void loadChunkBGRA(const TextureChunk& chunk, uint32_t w, uint32_t h, uint8_t* data);
+	/* only the chunks intersecting the region (rx,ry,rw,rh) are loaded */
+	void loadChunkBGRA(const TextureChunk& chunk, uint32_t w, uint32_t h, uint8_t* data, uint32_t rx, uint32_t ry, uint32_t rw, uint32_t rh);
 	/**
 		Enqueue something to be uploaded to texture
 	*/
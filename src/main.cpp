@@ -252,6 +252,7 @@ int main(int argc, char* argv[])
 #ifdef PROFILING_SUPPORT
 	char* profilingFileName=nullptr;
 #endif
+	char* samplingFileName=nullptr;
 	char *HTTPcookie=nullptr;
 	SecurityManager::SANDBOXTYPE sandboxType=SecurityManager::LOCAL_WITH_FILE;
 	bool useInterpreter=true;
@@ -334,6 +335,16 @@ int main(int argc, char* argv[])
 			profilingFileName=argv[i];
 		}
 #endif
+		else if(strcmp(argv[i],"--sampling-output")==0)
+		{
+			i++;
+			if(i==argc)
+			{
+				fileName=NULL;
+				break;
+			}
+			samplingFileName=argv[i];
+		}
 		else if(strcmp(argv[i],"-s")==0 || 
 			strcmp(argv[i],"--security-sandbox")==0)
 		{
@@ -400,6 +411,7 @@ int main(int argc, char* argv[])
 #ifdef PROFILING_SUPPORT
 			" [--profiling-output|-o profiling-file]" <<
 #endif
+			" [--sampling-output sampling-file]" <<
 			" [--ignore-unhandled-exceptions|-ne]"
 			" [--version|-v]" <<
 			" <file.swf>");
@@ -482,6 +494,8 @@ int main(int argc, char* argv[])
 	if(profilingFileName)
 		sys->setProfilingOutput(profilingFileName);
 #endif
+	if(samplingFileName)
+		sys->setSamplingOutput(samplingFileName);
 	if(HTTPcookie)
 		sys->setCookies(HTTPcookie);
 
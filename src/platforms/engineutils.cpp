@@ -1133,6 +1133,14 @@ void EngineData::exec_glBufferData_GL_ARRAY_BUFFER_GL_DYNAMIC_DRAW(int32_t size,
 {
 	glBufferData(GL_ARRAY_BUFFER,size, data,GL_DYNAMIC_DRAW);
 }
+void EngineData::exec_glBufferSubData_GL_ELEMENT_ARRAY_BUFFER(int32_t offset,int32_t size,const void* data)
+{
+	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER,offset,size,data);
+}
+void EngineData::exec_glBufferSubData_GL_ARRAY_BUFFER(int32_t offset,int32_t size,const void* data)
+{
+	glBufferSubData(GL_ARRAY_BUFFER,offset,size,data);
+}
 
 void EngineData::exec_glTexParameteri_GL_TEXTURE_2D_GL_TEXTURE_MIN_FILTER_GL_LINEAR()
 {
@@ -1363,6 +1371,22 @@ bool EngineData::audio_ManagerOpenMixer()
 #endif
 }
 
+static void mixer_hook_cb(void* udata, Uint8* stream, int len)
+{
+	((AudioManager*)udata)->mixStreams((int16_t*)stream,len);
+}
+
+bool EngineData::audio_ManagerHookMixer(AudioManager* manager)
+{
+	Mix_HookMusic(mixer_hook_cb,manager);
+	return true;
+}
+
+void EngineData::audio_ManagerUnhookMixer()
+{
+	Mix_HookMusic(nullptr,nullptr);
+}
+
 void EngineData::audio_ManagerDeinit()
 {
 	SDL_QuitSubSystem ( SDL_INIT_AUDIO );
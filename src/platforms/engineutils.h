@@ -44,6 +44,7 @@ namespace lightspark
 class SystemState;
 class StreamCache;
 class AudioStream;
+class AudioManager;
 class ITickJob;
 
 enum DEPTH_FUNCTION { ALWAYS, EQUAL, GREATER, GREATER_EQUAL, LESS, LESS_EQUAL, NEVER, NOT_EQUAL };
@@ -263,6 +264,8 @@ public:
 	virtual void exec_glBufferData_GL_ELEMENT_ARRAY_BUFFER_GL_DYNAMIC_DRAW(int32_t size, const void* data);
 	virtual void exec_glBufferData_GL_ARRAY_BUFFER_GL_STATIC_DRAW(int32_t size, const void* data);
 	virtual void exec_glBufferData_GL_ARRAY_BUFFER_GL_DYNAMIC_DRAW(int32_t size, const void* data);
+	virtual void exec_glBufferSubData_GL_ELEMENT_ARRAY_BUFFER(int32_t offset, int32_t size, const void* data);
+	virtual void exec_glBufferSubData_GL_ARRAY_BUFFER(int32_t offset, int32_t size, const void* data);
 	virtual void exec_glTexParameteri_GL_TEXTURE_2D_GL_TEXTURE_MIN_FILTER_GL_LINEAR();
 	virtual void exec_glTexParameteri_GL_TEXTURE_2D_GL_TEXTURE_MAG_FILTER_GL_LINEAR();
 	virtual void exec_glTexParameteri_GL_TEXTURE_2D_GL_TEXTURE_MIN_FILTER_GL_NEAREST();
@@ -297,6 +300,10 @@ public:
 	virtual bool audio_ManagerInit();
 	virtual void audio_ManagerCloseMixer();
 	virtual bool audio_ManagerOpenMixer();
+	/* install a single callback that mixes all streams through AudioManager::mixStreams()
+	 * returns false if the engine mixes every stream itself */
+	virtual bool audio_ManagerHookMixer(AudioManager* manager);
+	virtual void audio_ManagerUnhookMixer();
 	virtual void audio_ManagerDeinit();
 	virtual int audio_getSampleRate();
 	
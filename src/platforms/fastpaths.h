@@ -28,16 +28,89 @@ namespace lightspark
 
 /**
 	Packing of YUV channels in a single buffer (YUVA). Full aligned version
+	The conversion to RGB is done afterwards by the fragment shader (lightspark.frag)
 
 	@param y Planar Y buffer
 	@param u Planar U buffer
-	@param u Planar V buffer
+	@param v Planar V buffer
 	@param out Destination YUV0 buffer
 	@param width Frame width in pixels
-	@param height Frame width in pixels
+	@param height Frame height in pixels
 	@param All the buffers must be 16 bytes aligned.
 */
 void fastYUV420ChannelsToYUV0Buffer(uint8_t* y, uint8_t* u, uint8_t* v, uint8_t* out, uint32_t width, uint32_t height);
 
+/**
+	Scale interleaved stereo 16 bit samples and add them to a 32 bit mixing accumulator
+
+	@param acc Accumulator, one 32 bit slot per sample
+	@param src Interleaved L/R 16 bit samples
+	@param samples Number of samples (not frames) in src
+	@param leftgain Gain for the left channel in Q15 format (32767 is unity)
+	@param rightgain Gain for the right channel in Q15 format (32767 is unity)
+*/
+void fastMixS16StereoIntoS32(int32_t* acc, const int16_t* src, uint32_t samples, int16_t leftgain, int16_t rightgain);
+
+/**
+	Saturate a 32 bit mixing accumulator down to 16 bit samples
+
+	@param dest Destination 16 bit samples
+	@param acc Accumulator filled by fastMixS16StereoIntoS32
+	@param samples Number of samples in acc
+*/
+void fastSaturateS32ToS16(int16_t* dest, const int32_t* acc, uint32_t samples);
+
+/**
+	Blend a row of premultiplied BGRA pixels over another one (source over destination)
+	SSE2, AVX2 or NEON are used when available, AVX2 is detected at runtime
+
+	@param dst Destination row, modified in place
+	@param src Source row, must not overlap with dst
+	@param pixels Number of pixels in the row
+*/
+void fastBlendOverBGRA(uint8_t* dst, const uint8_t* src, uint32_t pixels);
+
+/**
+	Fill a row of BGRA pixels with a single color
+
+	@param dst Destination row
+	@param color Native-endian 32 bit ARGB value
+	@param pixels Number of pixels in the row
+*/
+void fastFillBGRA(uint8_t* dst, uint32_t color, uint32_t pixels);
+
+/**
+	Apply multipliers and offsets to the channels of a row of BGRA pixels, the results are truncated and clamped to 0-255
+
+	@param data Row, modified in place
+	@param pixels Number of pixels in the row
+	@param mult Multipliers in B, G, R, A order
+	@param offset Offsets in B, G, R, A order
+*/
+void fastColorTransformBGRA(uint8_t* data, uint32_t pixels, const double mult[4], const double offset[4]);
+
+/**
+	Find the first and last pixel of a row for which (pixel & mask) == color (or != color)
+
+	@param data Row of BGRA pixels
+	@param pixels Number of pixels in the row
+	@param mask Mask applied to the native-endian 32 bit ARGB value
+	@param color Value to compare with
+	@param findColor Search for matching pixels if true, for differing pixels otherwise
+	@param first Set to the index of the first pixel found
+	@param last Set to the index of the last pixel found
+	@return true if at least one pixel was found, first and last are not modified otherwise
+*/
+bool fastFindColorBGRA(const uint8_t* data, uint32_t pixels, uint32_t mask, uint32_t color, bool findColor, uint32_t& first, uint32_t& last);
+
+/**
+	Add the channel values of a row of BGRA pixels to per channel histograms
+
+	@param data Row of BGRA pixels
+	@param pixels Number of pixels in the row
+	@param counts Histograms in B, G, R, A order
+*/
+void fastHistogramBGRA(const uint8_t* data, uint32_t pixels, uint32_t counts[4][256]);
+
 };
 #endif /* PLATFORMS_FASTPATHS_H */
@@ -0,0 +1,86 @@
+/**************************************************************************
+  Lightspark, a free flash player implementation
+
+  Copyright (C) 2026  Lightspark Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#include "platforms/fastpaths.h"
+#include <cinttypes>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define LS_AUDIO_NEON 1
+#endif
+
+using namespace lightspark;
+
+void lightspark::fastMixS16StereoIntoS32(int32_t* acc, const int16_t* src, uint32_t samples, int16_t leftgain, int16_t rightgain)
+{
+	uint32_t i=0;
+#if defined(__SSE2__)
+	//Even lanes are left samples, odd lanes are right samples
+	const __m128i gain=_mm_set_epi16(rightgain,leftgain,rightgain,leftgain,rightgain,leftgain,rightgain,leftgain);
+	for(;i+8<=samples;i+=8)
+	{
+		__m128i s=_mm_loadu_si128((const __m128i*)(src+i));
+		//Build the full 32 bit products from the low and high halves
+		__m128i lo=_mm_mullo_epi16(s,gain);
+		__m128i hi=_mm_mulhi_epi16(s,gain);
+		__m128i p0=_mm_srai_epi32(_mm_unpacklo_epi16(lo,hi),15);
+		__m128i p1=_mm_srai_epi32(_mm_unpackhi_epi16(lo,hi),15);
+		__m128i a0=_mm_loadu_si128((const __m128i*)(acc+i));
+		__m128i a1=_mm_loadu_si128((const __m128i*)(acc+i+4));
+		_mm_storeu_si128((__m128i*)(acc+i),_mm_add_epi32(a0,p0));
+		_mm_storeu_si128((__m128i*)(acc+i+4),_mm_add_epi32(a1,p1));
+	}
+#elif defined(LS_AUDIO_NEON)
+	const int16_t g[4]={leftgain,rightgain,leftgain,rightgain};
+	const int16x4_t gain=vld1_s16(g);
+	for(;i+4<=samples;i+=4)
+	{
+		int32x4_t p=vshrq_n_s32(vmull_s16(vld1_s16(src+i),gain),15);
+		vst1q_s32(acc+i,vaddq_s32(vld1q_s32(acc+i),p));
+	}
+#endif
+	for(;i<samples;i++)
+		acc[i]+=(int32_t(src[i])*((i&1) ? rightgain : leftgain))>>15;
+}
+
+void lightspark::fastSaturateS32ToS16(int16_t* dest, const int32_t* acc, uint32_t samples)
+{
+	uint32_t i=0;
+#if defined(__SSE2__)
+	for(;i+8<=samples;i+=8)
+	{
+		__m128i a0=_mm_loadu_si128((const __m128i*)(acc+i));
+		__m128i a1=_mm_loadu_si128((const __m128i*)(acc+i+4));
+		_mm_storeu_si128((__m128i*)(dest+i),_mm_packs_epi32(a0,a1));
+	}
+#elif defined(LS_AUDIO_NEON)
+	for(;i+4<=samples;i+=4)
+		vst1_s16(dest+i,vqmovn_s32(vld1q_s32(acc+i)));
+#endif
+	for(;i<samples;i++)
+	{
+		int32_t v=acc[i];
+		if(v>INT16_MAX)
+			v=INT16_MAX;
+		else if(v<INT16_MIN)
+			v=INT16_MIN;
+		dest[i]=v;
+	}
+}
@@ -0,0 +1,280 @@
+/**************************************************************************
+  Lightspark, a free flash player implementation
+
+  Copyright (C) 2026  Lightspark Team
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+#include "platforms/fastpaths.h"
+#include <cinttypes>
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define LS_BITMAP_AVX2 1
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define LS_BITMAP_NEON 1
+#endif
+
+using namespace lightspark;
+
+/*
+	Source over destination for premultiplied pixels: d = s + d*(255-sa)/255
+	The division is rounded like pixman does, so the results are the same as the cairo blits used before
+*/
+static inline uint32_t blendOverScalar(uint32_t s, uint32_t d)
+{
+	uint32_t ia=255-(s>>24);
+	uint32_t res=0;
+	for(uint32_t shift=0;shift<32;shift+=8)
+	{
+		uint32_t t=((d>>shift)&0xff)*ia+0x80;
+		t=((t+(t>>8))>>8)+((s>>shift)&0xff);
+		res|=(t>255 ? 255 : t)<<shift;
+	}
+	return res;
+}
+
+#if defined(__SSE2__)
+static uint32_t blendOverSSE2(uint8_t* dst, const uint8_t* src, uint32_t pixels)
+{
+	const __m128i zero=_mm_setzero_si128();
+	const __m128i c255=_mm_set1_epi16(255);
+	const __m128i c128=_mm_set1_epi16(128);
+	uint32_t j=0;
+	for(;j+4<=pixels;j+=4)
+	{
+		__m128i s=_mm_loadu_si128((const __m128i*)(src+j*4));
+		__m128i d=_mm_loadu_si128((const __m128i*)(dst+j*4));
+		//Broadcast the inverted source alpha to the four channels of each pixel
+		__m128i slo=_mm_unpacklo_epi8(s,zero);
+		__m128i shi=_mm_unpackhi_epi8(s,zero);
+		__m128i ialo=_mm_sub_epi16(c255,_mm_shufflehi_epi16(_mm_shufflelo_epi16(slo,_MM_SHUFFLE(3,3,3,3)),_MM_SHUFFLE(3,3,3,3)));
+		__m128i iahi=_mm_sub_epi16(c255,_mm_shufflehi_epi16(_mm_shufflelo_epi16(shi,_MM_SHUFFLE(3,3,3,3)),_MM_SHUFFLE(3,3,3,3)));
+		__m128i tlo=_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d,zero),ialo),c128);
+		__m128i thi=_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d,zero),iahi),c128);
+		tlo=_mm_srli_epi16(_mm_add_epi16(tlo,_mm_srli_epi16(tlo,8)),8);
+		thi=_mm_srli_epi16(_mm_add_epi16(thi,_mm_srli_epi16(thi,8)),8);
+		_mm_storeu_si128((__m128i*)(dst+j*4),_mm_adds_epu8(s,_mm_packus_epi16(tlo,thi)));
+	}
+	return j;
+}
+#endif
+
+#if defined(LS_BITMAP_AVX2)
+//Same as blendOverSSE2 with 8 pixels at a time, unpacking and packing work per 128 bit lane so the order is kept
+__attribute__((target("avx2")))
+static uint32_t blendOverAVX2(uint8_t* dst, const uint8_t* src, uint32_t pixels)
+{
+	const __m256i zero=_mm256_setzero_si256();
+	const __m256i c255=_mm256_set1_epi16(255);
+	const __m256i c128=_mm256_set1_epi16(128);
+	uint32_t j=0;
+	for(;j+8<=pixels;j+=8)
+	{
+		__m256i s=_mm256_loadu_si256((const __m256i*)(src+j*4));
+		__m256i d=_mm256_loadu_si256((const __m256i*)(dst+j*4));
+		__m256i slo=_mm256_unpacklo_epi8(s,zero);
+		__m256i shi=_mm256_unpackhi_epi8(s,zero);
+		__m256i ialo=_mm256_sub_epi16(c255,_mm256_shufflehi_epi16(_mm256_shufflelo_epi16(slo,_MM_SHUFFLE(3,3,3,3)),_MM_SHUFFLE(3,3,3,3)));
+		__m256i iahi=_mm256_sub_epi16(c255,_mm256_shufflehi_epi16(_mm256_shufflelo_epi16(shi,_MM_SHUFFLE(3,3,3,3)),_MM_SHUFFLE(3,3,3,3)));
+		__m256i tlo=_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d,zero),ialo),c128);
+		__m256i thi=_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d,zero),iahi),c128);
+		tlo=_mm256_srli_epi16(_mm256_add_epi16(tlo,_mm256_srli_epi16(tlo,8)),8);
+		thi=_mm256_srli_epi16(_mm256_add_epi16(thi,_mm256_srli_epi16(thi,8)),8);
+		_mm256_storeu_si256((__m256i*)(dst+j*4),_mm256_adds_epu8(s,_mm256_packus_epi16(tlo,thi)));
+	}
+	return j;
+}
+#endif
+
+#if defined(LS_BITMAP_NEON)
+static uint32_t blendOverNEON(uint8_t* dst, const uint8_t* src, uint32_t pixels)
+{
+	uint32_t j=0;
+	for(;j+8<=pixels;j+=8)
+	{
+		uint8x8x4_t s=vld4_u8(src+j*4);
+		uint8x8x4_t d=vld4_u8(dst+j*4);
+		uint8x8_t ia=vmvn_u8(s.val[3]);
+		for(int c=0;c<4;c++)
+		{
+			//(t + ((t+128)>>8) + 128)>>8, the same rounding as the scalar version
+			uint16x8_t t=vmull_u8(d.val[c],ia);
+			d.val[c]=vqadd_u8(s.val[c],vraddhn_u16(t,vrshrq_n_u16(t,8)));
+		}
+		vst4_u8(dst+j*4,d);
+	}
+	return j;
+}
+#endif
+
+typedef uint32_t (*BlendOverFunc)(uint8_t* dst, const uint8_t* src, uint32_t pixels);
+
+#if !defined(__SSE2__) && !defined(LS_BITMAP_NEON)
+static uint32_t blendOverNone(uint8_t*, const uint8_t*, uint32_t)
+{
+	return 0;
+}
+#endif
+
+static BlendOverFunc selectBlendOver()
+{
+#if defined(LS_BITMAP_AVX2)
+	if(__builtin_cpu_supports("avx2"))
+		return blendOverAVX2;
+#endif
+#if defined(__SSE2__)
+	return blendOverSSE2;
+#elif defined(LS_BITMAP_NEON)
+	return blendOverNEON;
+#else
+	return blendOverNone;
+#endif
+}
+
+void lightspark::fastBlendOverBGRA(uint8_t* dst, const uint8_t* src, uint32_t pixels)
+{
+	static const BlendOverFunc blendOver=selectBlendOver();
+	uint32_t j=blendOver(dst,src,pixels);
+	for(;j<pixels;j++)
+	{
+		uint32_t s,d;
+		memcpy(&s,src+j*4,4);
+		memcpy(&d,dst+j*4,4);
+		d=blendOverScalar(s,d);
+		memcpy(dst+j*4,&d,4);
+	}
+}
+
+void lightspark::fastFillBGRA(uint8_t* dst, uint32_t color, uint32_t pixels)
+{
+	uint32_t j=0;
+#if defined(__SSE2__)
+	const __m128i c=_mm_set1_epi32(color);
+	for(;j+4<=pixels;j+=4)
+		_mm_storeu_si128((__m128i*)(dst+j*4),c);
+#elif defined(LS_BITMAP_NEON)
+	const uint32x4_t c=vdupq_n_u32(color);
+	for(;j+4<=pixels;j+=4)
+		vst1q_u8(dst+j*4,vreinterpretq_u8_u32(c));
+#endif
+	for(;j<pixels;j++)
+		memcpy(dst+j*4,&color,4);
+}
+
+static inline uint32_t transformChannel(uint32_t c, double mult, double offset)
+{
+	//Truncate like a conversion to int would, NaN ends up as 0 like in the vectorized version
+	double v=c*mult+offset;
+	return v>0 ? (v<255 ? uint32_t(v) : 255) : 0;
+}
+
+void lightspark::fastColorTransformBGRA(uint8_t* data, uint32_t pixels, const double mult[4], const double offset[4])
+{
+	uint32_t j=0;
+#if defined(__SSE2__)
+	//The computation is done in double precision to get exactly the same results as the scalar version
+	const __m128i zero=_mm_setzero_si128();
+	const __m128d mlo=_mm_set_pd(mult[1],mult[0]);
+	const __m128d mhi=_mm_set_pd(mult[3],mult[2]);
+	const __m128d olo=_mm_set_pd(offset[1],offset[0]);
+	const __m128d ohi=_mm_set_pd(offset[3],offset[2]);
+	const __m128d minval=_mm_setzero_pd();
+	const __m128d maxval=_mm_set1_pd(255.0);
+	for(;j<pixels;j++)
+	{
+		int32_t px;
+		memcpy(&px,data+j*4,4);
+		__m128i p=_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(px),zero),zero);
+		__m128d lo=_mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(p),mlo),olo);
+		__m128d hi=_mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(p,_MM_SHUFFLE(1,0,3,2))),mhi),ohi);
+		//Clamp to 0-255 before the conversion, out of range values would become INT_MIN.
+		//maxpd returns its second operand if the first one is NaN, so NaN becomes 0 like in the scalar version
+		lo=_mm_min_pd(_mm_max_pd(lo,minval),maxval);
+		hi=_mm_min_pd(_mm_max_pd(hi,minval),maxval);
+		__m128i r=_mm_unpacklo_epi64(_mm_cvttpd_epi32(lo),_mm_cvttpd_epi32(hi));
+		r=_mm_packs_epi32(r,r);
+		r=_mm_packus_epi16(r,r);
+		px=_mm_cvtsi128_si32(r);
+		memcpy(data+j*4,&px,4);
+	}
+#endif
+	for(;j<pixels;j++)
+	{
+		uint32_t px;
+		memcpy(&px,data+j*4,4);
+		uint32_t res=0;
+		for(uint32_t c=0;c<4;c++)
+			res|=transformChannel((px>>(c*8))&0xff,mult[c],offset[c])<<(c*8);
+		memcpy(data+j*4,&res,4);
+	}
+}
+
+bool lightspark::fastFindColorBGRA(const uint8_t* data, uint32_t pixels, uint32_t mask, uint32_t color, bool findColor, uint32_t& first, uint32_t& last)
+{
+	bool found=false;
+	uint32_t j=0;
+#if defined(__SSE2__)
+	const __m128i m=_mm_set1_epi32(mask);
+	const __m128i c=_mm_set1_epi32(color);
+	for(;j+4<=pixels;j+=4)
+	{
+		__m128i p=_mm_loadu_si128((const __m128i*)(data+j*4));
+		int bits=_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(p,m),c)));
+		if(!findColor)
+			bits^=0xf;
+		if(bits==0)
+			continue;
+		for(uint32_t k=0;k<4;k++)
+		{
+			if(!(bits&(1<<k)))
+				continue;
+			if(!found)
+				first=j+k;
+			last=j+k;
+			found=true;
+		}
+	}
+#endif
+	for(;j<pixels;j++)
+	{
+		uint32_t px;
+		memcpy(&px,data+j*4,4);
+		if(((px&mask)==color)==findColor)
+		{
+			if(!found)
+				first=j;
+			last=j;
+			found=true;
+		}
+	}
+	return found;
+}
+
+void lightspark::fastHistogramBGRA(const uint8_t* data, uint32_t pixels, uint32_t counts[4][256])
+{
+	//Counting is inherently scalar, but going through the bytes of a row is much cheaper than fetching every pixel
+	for(uint32_t j=0;j<pixels;j++)
+	{
+		counts[0][data[j*4+0]]++;
+		counts[1][data[j*4+1]]++;
+		counts[2][data[j*4+2]]++;
+		counts[3][data[j*4+3]]++;
+	}
+}
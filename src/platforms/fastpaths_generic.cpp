@@ -0,0 +1,82 @@
+/**************************************************************************
+  Lightspark, a free flash player implementation
+
+  Copyright (C) 2010-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ **************************************************************************/
+
+
+#include "platforms/fastpaths.h"
+#include <inttypes.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define LS_YUV_NEON 1
+#endif
+
+//Portable version of the packer, used where the nasm implementation is not built
+void lightspark::fastYUV420ChannelsToYUV0Buffer(uint8_t* y, uint8_t* u, uint8_t* v, uint8_t* out, uint32_t width, uint32_t height)
+{
+	uint32_t texw= (width+15)&0xfffffff0;
+	for(uint32_t i=0;i<height;i++)
+	{
+		const uint8_t* yline=y+i*width;
+		const uint8_t* uline=u+(i/2)*(width/2);
+		const uint8_t* vline=v+(i/2)*(width/2);
+		uint8_t* outline=out+i*texw*4;
+		uint32_t j=0;
+#if defined(__SSE2__)
+		const __m128i ones=_mm_set1_epi8(-1);
+		for(;j+16<=width;j+=16)
+		{
+			__m128i yy=_mm_loadu_si128((const __m128i*)(yline+j));
+			//Duplicate each chroma sample for two horizontal pixels
+			__m128i uu=_mm_loadl_epi64((const __m128i*)(uline+j/2));
+			__m128i vv=_mm_loadl_epi64((const __m128i*)(vline+j/2));
+			uu=_mm_unpacklo_epi8(uu,uu);
+			vv=_mm_unpacklo_epi8(vv,vv);
+			__m128i yulo=_mm_unpacklo_epi8(yy,uu);
+			__m128i yuhi=_mm_unpackhi_epi8(yy,uu);
+			__m128i v1lo=_mm_unpacklo_epi8(vv,ones);
+			__m128i v1hi=_mm_unpackhi_epi8(vv,ones);
+			_mm_storeu_si128((__m128i*)(outline+j*4),_mm_unpacklo_epi16(yulo,v1lo));
+			_mm_storeu_si128((__m128i*)(outline+j*4+16),_mm_unpackhi_epi16(yulo,v1lo));
+			_mm_storeu_si128((__m128i*)(outline+j*4+32),_mm_unpacklo_epi16(yuhi,v1hi));
+			_mm_storeu_si128((__m128i*)(outline+j*4+48),_mm_unpackhi_epi16(yuhi,v1hi));
+		}
+#elif defined(LS_YUV_NEON)
+		for(;j+16<=width;j+=16)
+		{
+			uint8x16x4_t pixels;
+			pixels.val[0]=vld1q_u8(yline+j);
+			//Duplicate each chroma sample for two horizontal pixels
+			uint8x8x2_t uu=vzip_u8(vld1_u8(uline+j/2),vld1_u8(uline+j/2));
+			uint8x8x2_t vv=vzip_u8(vld1_u8(vline+j/2),vld1_u8(vline+j/2));
+			pixels.val[1]=vcombine_u8(uu.val[0],uu.val[1]);
+			pixels.val[2]=vcombine_u8(vv.val[0],vv.val[1]);
+			pixels.val[3]=vdupq_n_u8(0xff);
+			vst4q_u8(outline+j*4,pixels);
+		}
+#endif
+		for(;j<width;j++)
+		{
+			outline[j*4+0]=yline[j];
+			outline[j*4+1]=uline[j/2];
+			outline[j*4+2]=vline[j/2];
+			outline[j*4+3]=0xff;
+		}
+	}
+}
@@ -299,6 +299,8 @@ public:
 	void exec_glBufferData_GL_ELEMENT_ARRAY_BUFFER_GL_DYNAMIC_DRAW(int32_t size, const void* data) override;
 	void exec_glBufferData_GL_ARRAY_BUFFER_GL_STATIC_DRAW(int32_t size, const void* data) override;
 	void exec_glBufferData_GL_ARRAY_BUFFER_GL_DYNAMIC_DRAW(int32_t size, const void* data) override;
+	void exec_glBufferSubData_GL_ELEMENT_ARRAY_BUFFER(int32_t offset, int32_t size, const void* data) override;
+	void exec_glBufferSubData_GL_ARRAY_BUFFER(int32_t offset, int32_t size, const void* data) override;
 	void exec_glTexParameteri_GL_TEXTURE_2D_GL_TEXTURE_MIN_FILTER_GL_LINEAR() override;
 	void exec_glTexParameteri_GL_TEXTURE_2D_GL_TEXTURE_MAG_FILTER_GL_LINEAR() override;
 	void exec_glTexParameteri_GL_TEXTURE_2D_GL_TEXTURE_MIN_FILTER_GL_NEAREST() override;
@@ -333,6 +335,8 @@ public:
 	bool audio_ManagerInit() override;
 	void audio_ManagerCloseMixer() override;
 	bool audio_ManagerOpenMixer() override;
+	bool audio_ManagerHookMixer(AudioManager* manager) override { return false; }
+	void audio_ManagerUnhookMixer() override {}
 	void audio_ManagerDeinit() override;
 	int audio_getSampleRate() override;
 
@@ -242,16 +242,16 @@ void ABCVm::registerClasses()
 void ABCVm::loadFloat(call_context *th)
 {
 	RUNTIME_STACK_POP_CREATE(th,arg1);
-	float addr=asAtomHandler::toNumber(*arg1);
-	ApplicationDomain* appDomain = th->mi->context->root->applicationDomain.getPtr();
+	uint32_t addr=asAtomHandler::toUInt(*arg1);
+	ApplicationDomain* appDomain = th->applicationdomain;
 	number_t ret=appDomain->readFromDomainMemory<float>(addr);
 	ASATOM_DECREF_POINTER(arg1);
 	RUNTIME_STACK_PUSH(th,asAtomHandler::fromNumber(appDomain->getSystemState(),ret,false));
 }
 void ABCVm::loadFloat(call_context *th,asAtom& ret, asAtom& arg1)
 {
-	float addr=asAtomHandler::toNumber(arg1);
-	ApplicationDomain* appDomain = th->mi->context->root->applicationDomain.getPtr();
+	uint32_t addr=asAtomHandler::toUInt(arg1);
+	ApplicationDomain* appDomain = th->applicationdomain;
 	number_t res=appDomain->readFromDomainMemory<float>(addr);
 	ret = asAtomHandler::fromNumber(appDomain->getSystemState(),res,false);
 }
@@ -259,16 +259,16 @@ void ABCVm::loadFloat(call_context *th,asAtom& ret, asAtom& arg1)
 void ABCVm::loadDouble(call_context *th)
 {
 	RUNTIME_STACK_POP_CREATE(th,arg1);
-	double addr=asAtomHandler::toNumber(*arg1);
-	ApplicationDomain* appDomain = th->mi->context->root->applicationDomain.getPtr();
+	uint32_t addr=asAtomHandler::toUInt(*arg1);
+	ApplicationDomain* appDomain = th->applicationdomain;
 	number_t ret=appDomain->readFromDomainMemory<double>(addr);
 	ASATOM_DECREF_POINTER(arg1);
 	RUNTIME_STACK_PUSH(th,asAtomHandler::fromNumber(appDomain->getSystemState(),ret,false));
 }
 void ABCVm::loadDouble(call_context *th,asAtom& ret, asAtom& arg1)
 {
-	float addr=asAtomHandler::toNumber(arg1);
-	ApplicationDomain* appDomain = th->mi->context->root->applicationDomain.getPtr();
+	uint32_t addr=asAtomHandler::toUInt(arg1);
+	ApplicationDomain* appDomain = th->applicationdomain;
 	number_t res=appDomain->readFromDomainMemory<double>(addr);
 	ret = asAtomHandler::fromNumber(appDomain->getSystemState(),res,false);
 }
@@ -277,18 +277,18 @@ void ABCVm::storeFloat(call_context *th)
 {
 	RUNTIME_STACK_POP_CREATE(th,arg1);
 	RUNTIME_STACK_POP_CREATE(th,arg2);
-	number_t addr=asAtomHandler::toNumber(*arg1);
+	uint32_t addr=asAtomHandler::toUInt(*arg1);
 	ASATOM_DECREF_POINTER(arg1);
 	float val=(float)asAtomHandler::toNumber(*arg2);
 	ASATOM_DECREF_POINTER(arg2);
-	ApplicationDomain* appDomain = th->mi->context->root->applicationDomain.getPtr();
+	ApplicationDomain* appDomain = th->applicationdomain;
 	appDomain->writeToDomainMemory<float>(addr, val);
 }
 void ABCVm::storeFloat(call_context *th, asAtom& arg1, asAtom& arg2)
 {
-	number_t addr=asAtomHandler::toNumber(arg1);
+	uint32_t addr=asAtomHandler::toUInt(arg1);
 	float val=(float)asAtomHandler::toNumber(arg2);
-	ApplicationDomain* appDomain = th->mi->context->root->applicationDomain.getPtr();
+	ApplicationDomain* appDomain = th->applicationdomain;
 	appDomain->writeToDomainMemory<float>(addr, val);
 }
 
@@ -296,18 +296,18 @@ void ABCVm::storeDouble(call_context *th)
 {
 	RUNTIME_STACK_POP_CREATE(th,arg1);
 	RUNTIME_STACK_POP_CREATE(th,arg2);
-	number_t addr=asAtomHandler::toNumber(*arg1);
+	uint32_t addr=asAtomHandler::toUInt(*arg1);
 	ASATOM_DECREF_POINTER(arg1);
 	double val=asAtomHandler::toNumber(*arg2);
 	ASATOM_DECREF_POINTER(arg2);
-	ApplicationDomain* appDomain = th->mi->context->root->applicationDomain.getPtr();
+	ApplicationDomain* appDomain = th->applicationdomain;
 	appDomain->writeToDomainMemory<double>(addr, val);
 }
 void ABCVm::storeDouble(call_context *th, asAtom& arg1, asAtom& arg2)
 {
-	number_t addr=asAtomHandler::toNumber(arg1);
+	uint32_t addr=asAtomHandler::toUInt(arg1);
 	double val=asAtomHandler::toNumber(arg2);
-	ApplicationDomain* appDomain = th->mi->context->root->applicationDomain.getPtr();
+	ApplicationDomain* appDomain = th->applicationdomain;
 	appDomain->writeToDomainMemory<double>(addr, val);
 }
 
@@ -919,9 +919,9 @@ void ABCContext::dumpProfilingData(ostream& f) const
 /*
  * nextNamespaceBase is set to 2 since 0 is the empty namespace and 1 is the AS3 namespace
  */
-ABCVm::ABCVm(SystemState* s, MemoryAccount* m):m_sys(s),status(CREATED),isIdle(true),shuttingdown(false),
+ABCVm::ABCVm(SystemState* s, MemoryAccount* m):m_sys(s),status(CREATED),isIdle(true),shuttingdown(false),vmWaiting(false),
 	events_queue(reporter_allocator<eventType>(m)),idleevents_queue(reporter_allocator<eventType>(m)),nextNamespaceBase(2),currentCallContext(NULL),
-	vmDataMemory(m),cur_recursion(0)
+	vmDataMemory(m),cur_recursion(0),sampler(nullptr)
 {
 	limits.max_recursion = 256;
 	limits.script_timeout = 20;
@@ -983,9 +983,17 @@ ABCVm::~ABCVm()
 		delete (*it);
 		it++;
 	}
+	delete sampler;
 	delete[] stacktrace;
 }
 
+Sampler* ABCVm::getSampler()
+{
+	if(sampler==nullptr)
+		sampler=new Sampler(m_sys);
+	return sampler;
+}
+
 int ABCVm::getEventQueueSize()
 {
 	return events_queue.size();
@@ -1360,11 +1368,14 @@ bool ABCVm::prependEvent(_NR<EventDispatcher> obj ,_R<Event> ev, bool force)
 		return true;
 	}
 
-	Locker l(event_queue_mutex);
+	event_queue_mutex.lock();
 
 	//If the system should terminate new events are not accepted
 	if(shuttingdown)
+	{
+		event_queue_mutex.unlock();
 		return false;
+	}
 
 	if (!obj.isNull())
 		obj->onNewEvent(ev.getPtr());
@@ -1373,7 +1384,10 @@ bool ABCVm::prependEvent(_NR<EventDispatcher> obj ,_R<Event> ev, bool force)
 		events_queue.push_front(pair<_NR<EventDispatcher>,_R<Event>>(obj, ev));
 	else
 		events_queue.push_back(pair<_NR<EventDispatcher>,_R<Event>>(obj, ev));
-	sem_event_cond.signal();
+	bool wakeup = vmWaiting;
+	event_queue_mutex.unlock();
+	if (wakeup)
+		sem_event_cond.signal();
 	return true;
 }
 
@@ -1394,20 +1408,30 @@ bool ABCVm::addEvent(_NR<EventDispatcher> obj ,_R<Event> ev)
 	}
 
 
-	Locker l(event_queue_mutex);
+	event_queue_mutex.lock();
 
 	//If the system should terminate new events are not accepted
 	if(shuttingdown)
 	{
+		event_queue_mutex.unlock();
 		if (ev->is<WaitableEvent>())
 			ev->as<WaitableEvent>()->signal();
 		return false;
 	}
+	if (coalesceEvent(events_queue,obj,ev))
+	{
+		event_queue_mutex.unlock();
+		return true;
+	}
 	if (!obj.isNull())
 		obj->onNewEvent(ev.getPtr());
 	events_queue.push_back(pair<_NR<EventDispatcher>,_R<Event>>(obj, ev));
 	RELEASE_WRITE(ev->queued,true);
-	sem_event_cond.signal();
+	// signal outside of the lock, so the vm thread doesn't wake up just to block on the mutex again
+	bool wakeup = vmWaiting;
+	event_queue_mutex.unlock();
+	if (wakeup)
+		sem_event_cond.signal();
 	return true;
 }
 void ABCVm::addIdleEvent(_NR<EventDispatcher> obj ,_R<Event> ev)
@@ -1416,9 +1440,41 @@ void ABCVm::addIdleEvent(_NR<EventDispatcher> obj ,_R<Event> ev)
 	//If the system should terminate new events are not accepted
 	if(shuttingdown)
 		return;
+	if (coalesceEvent(idleevents_queue,obj,ev))
+		return;
 	idleevents_queue.push_back(pair<_NR<EventDispatcher>,_R<Event>>(obj, ev));
 	RELEASE_WRITE(ev->queued,true);
 }
+bool ABCVm::coalesceEvent(std::deque<eventType, reporter_allocator<eventType>>& queue, const _NR<EventDispatcher>& obj, const _R<Event>& ev)
+{
+	// only the last queued event is considered, so the order relative to other events is kept
+	if (queue.empty() || obj.isNull())
+		return false;
+	eventType& last = queue.back();
+	if (last.first != obj || last.second->type != ev->type)
+		return false;
+	if (ev->is<MouseEvent>() && last.second->is<MouseEvent>() && ev->type == "mouseMove")
+	{
+		// the newer event carries the current position and button state
+		// the parent registered for the replaced event has to be released, and the new event has to be registered in its place
+		obj->afterHandleEvent(last.second.getPtr());
+		if (&queue == &events_queue)
+			obj->onNewEvent(ev.getPtr());
+		RELEASE_WRITE(last.second->queued,false);
+		last.second = ev;
+		RELEASE_WRITE(ev->queued,true);
+		return true;
+	}
+	if (ev->is<ProgressEvent>() && last.second->is<ProgressEvent>() && ev->type == "progress" && last.second != ev)
+	{
+		ProgressEvent* queued = last.second->as<ProgressEvent>();
+		Locker l(queued->accesmutex);
+		queued->bytesLoaded = ev->as<ProgressEvent>()->bytesLoaded;
+		queued->bytesTotal = ev->as<ProgressEvent>()->bytesTotal;
+		return true;
+	}
+	return false;
+}
 
 Class_inherit* ABCVm::findClassInherit(const string& s, RootMovieClip* root)
 {
@@ -1778,6 +1834,12 @@ int ABCVm::Run(void* d)
 	if (!th->m_sys->mainClip->usesActionScript3)
 		th->registerClassesAVM1();
 	th->status=STARTED;
+	if(!th->m_sys->getSamplingOutput().empty())
+	{
+		Sampler* s=th->getSampler();
+		s->setOutputFile(th->m_sys->getSamplingOutput());
+		s->start();
+	}
 
 	ThreadProfile* profile=th->m_sys->allocateProfiler(RGB(0,200,0));
 	profile->setTag("VM");
@@ -1795,7 +1857,11 @@ int ABCVm::Run(void* d)
 	{
 		th->event_queue_mutex.lock();
 		while(th->events_queue.empty() && !th->shuttingdown)
+		{
+			th->vmWaiting=true;
 			th->sem_event_cond.wait(th->event_queue_mutex);
+			th->vmWaiting=false;
+		}
 		for (auto it = th->deletableObjects.begin(); it != th->deletableObjects.end(); it++)
 			(*it)->decRef();
 		th->deletableObjects.clear();
@@ -1830,6 +1896,11 @@ int ABCVm::Run(void* d)
 		delete th->module;
 	}
 #endif
+	if(th->sampler)
+	{
+		th->sampler->stop();
+		th->sampler->writeOutput();
+	}
 #ifndef NDEBUG
 	inStartupOrClose= true;
 #endif
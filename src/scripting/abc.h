@@ -31,6 +31,7 @@
 #include "swf.h"
 #include "scripting/abcutils.h"
 #include "scripting/abctypes.h"
+#include "scripting/sampler.h"
 #include "scripting/flash/system/flashsystem.h"
 #include "scripting/toplevel/toplevel.h"
 
@@ -364,8 +365,7 @@ private:
 	{
 		RUNTIME_STACK_POP_CREATE(th,arg1);
 		uint32_t addr=asAtomHandler::toUInt(*arg1);
-		ApplicationDomain* appDomain = th->mi->context->root->applicationDomain.getPtr();
-		T ret=appDomain->readFromDomainMemory<T>(addr);
+		T ret=th->applicationdomain->readFromDomainMemory<T>(addr);
 		ASATOM_DECREF_POINTER(arg1);
 		RUNTIME_STACK_PUSH(th,asAtomHandler::fromInt(ret));
 	}
@@ -378,27 +378,19 @@ private:
 		ASATOM_DECREF_POINTER(arg1);
 		int32_t val=asAtomHandler::toInt(*arg2);
 		ASATOM_DECREF_POINTER(arg2);
-		ApplicationDomain* appDomain = th->mi->context->root->applicationDomain.getPtr();
-		appDomain->writeToDomainMemory<T>(addr, val);
+		th->applicationdomain->writeToDomainMemory<T>(addr, val);
 	}
 	template<class T>
 	static FORCE_INLINE void loadIntN(call_context* th,asAtom& ret, asAtom& arg1)
 	{
-		uint32_t addr=asAtomHandler::toUInt(arg1);
-		ByteArray* dm = th->mi->context->root->applicationDomain->currentDomainMemory;
-		if(dm->getLength() < (addr+sizeof(T)))
-			throwError<RangeError>(kInvalidRangeError);
-		ret = asAtomHandler::fromInt(*reinterpret_cast<T*>(dm->getBufferNoCheck()+addr));
+		ret = asAtomHandler::fromInt(th->applicationdomain->readFromDomainMemory<T>(asAtomHandler::toUInt(arg1)));
 	}
 	template<class T>
 	static FORCE_INLINE void storeIntN(call_context* th, asAtom& arg1, asAtom& arg2)
 	{
 		uint32_t addr=asAtomHandler::toUInt(arg1);
 		int32_t val=asAtomHandler::toInt(arg2);
-		ByteArray* dm = th->mi->context->root->applicationDomain->currentDomainMemory;
-		if(dm->getLength() < (addr+sizeof(T)))
-			throwError<RangeError>(kInvalidRangeError);
-		*reinterpret_cast<T*>(dm->getBufferNoCheck()+addr)=val;
+		th->applicationdomain->writeToDomainMemory<T>(addr, val);
 	}
 	static void loadFloat(call_context* th);
 	static void loadFloat(call_context* th,asAtom& ret, asAtom& arg1);
@@ -592,9 +584,13 @@ private:
 
 	//Event handling
 	volatile bool shuttingdown;
+	// true while the vm thread is blocked on sem_event_cond, producers only signal it in that case
+	bool vmWaiting;
 	typedef std::pair<_NR<EventDispatcher>,_R<Event>> eventType;
 	std::deque<eventType, reporter_allocator<eventType>> events_queue;
 	std::deque<eventType, reporter_allocator<eventType>> idleevents_queue;
+	// merges redundant mouseMove/progress events into the last event queued for the same dispatcher
+	bool coalesceEvent(std::deque<eventType, reporter_allocator<eventType>>& queue, const _NR<EventDispatcher>& obj, const _R<Event>& ev);
 	void handleEvent(std::pair<_NR<EventDispatcher>,_R<Event> > e);
 	void handleFrontEvent();
 	void signalEventWaiters();
@@ -1401,6 +1397,8 @@ public:
 		void set(asAtom o, uint32_t n) { object=o; name=n; }
 	};
 	stacktrace_entry* stacktrace;
+	// created on the first use of flash.sampler or when a sampling output file is set
+	Sampler* sampler;
 	FORCE_INLINE call_context* incStack(asAtom o, uint32_t f)
 	{
 		if(USUALLY_FALSE(cur_recursion == limits.max_recursion))
@@ -1409,8 +1407,17 @@ public:
 		}
 		stacktrace[cur_recursion].set(o,f);
 		++cur_recursion; //increment current recursion depth
+		if(USUALLY_FALSE(sampler!=nullptr) && sampler->isRunning())
+			sampler->functionCalled(this,f);
 		return currentCallContext;
 	}
+	Sampler* getSampler();
+	//Called at backward branches, so time spent in loops without calls is sampled in the right function
+	FORCE_INLINE void pollSampler()
+	{
+		if(USUALLY_FALSE(sampler!=nullptr) && sampler->isRunning())
+			sampler->poll(this);
+	}
 	FORCE_INLINE void decStack(call_context* saved_cc)
 	{
 		currentCallContext = saved_cc;
@@ -91,7 +91,7 @@ void ABCVm::abc_ifnlt(call_context* context)
 	LOG_CALL(_("ifNLT (") << ((cond)?_("taken)"):_("not taken)")));
 
 	if(cond)
-		context->exec_pos += (*context->exec_pos).arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -105,7 +105,7 @@ void ABCVm::abc_ifnle(call_context* context)
 	LOG_CALL(_("ifNLE (") << ((cond)?_("taken)"):_("not taken)")));
 
 	if(cond)
-		context->exec_pos += (*context->exec_pos).arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -119,7 +119,7 @@ void ABCVm::abc_ifngt(call_context* context)
 	LOG_CALL(_("ifNGT (") << ((cond)?_("taken)"):_("not taken)")));
 
 	if(cond)
-		context->exec_pos += (*context->exec_pos).arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -133,14 +133,14 @@ void ABCVm::abc_ifnge(call_context* context)
 	LOG_CALL(_("ifNGE (") << ((cond)?_("taken)"):_("not taken)")));
 
 	if(cond)
-		context->exec_pos += (*context->exec_pos).arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
 void ABCVm::abc_jump(call_context* context)
 {
 	LOG_CALL("jump:"<<(*context->exec_pos).arg3_int);
-	context->exec_pos += (*context->exec_pos).arg3_int;
+	RUNTIME_BRANCH(context);
 }
 void ABCVm::abc_iftrue(call_context* context)
 {
@@ -149,7 +149,7 @@ void ABCVm::abc_iftrue(call_context* context)
 	LOG_CALL(_("ifTrue (") << ((cond)?_("taken)"):_("not taken)"))<<" "<<(*context->exec_pos).arg3_int);
 	ASATOM_DECREF_POINTER(v1);
 	if(cond)
-		context->exec_pos += (*context->exec_pos).arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -160,7 +160,7 @@ void ABCVm::abc_iffalse(call_context* context)
 	LOG_CALL(_("ifFalse (") << ((cond)?_("taken"):_("not taken")) << ')');
 	ASATOM_DECREF_POINTER(v1);
 	if(cond)
-		context->exec_pos += (*context->exec_pos).arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -173,7 +173,7 @@ void ABCVm::abc_ifeq(call_context* context)
 	ASATOM_DECREF_POINTER(v2);
 	ASATOM_DECREF_POINTER(v1);
 	if(cond)
-		context->exec_pos += (*context->exec_pos).arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -186,7 +186,7 @@ void ABCVm::abc_ifne(call_context* context)
 	ASATOM_DECREF_POINTER(v2);
 	ASATOM_DECREF_POINTER(v1);
 	if(cond)
-		context->exec_pos += (*context->exec_pos).arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -200,7 +200,7 @@ void ABCVm::abc_iflt(call_context* context)
 	LOG_CALL(_("ifLT (") << ((cond)?_("taken)"):_("not taken)")));
 
 	if(cond)
-		context->exec_pos += (*context->exec_pos).arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -214,7 +214,7 @@ void ABCVm::abc_ifle(call_context* context)
 	LOG_CALL(_("ifLE (") << ((cond)?_("taken)"):_("not taken)")));
 
 	if(cond)
-		context->exec_pos += (*context->exec_pos).arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -228,7 +228,7 @@ void ABCVm::abc_ifgt(call_context* context)
 	LOG_CALL(_("ifGT (") << ((cond)?_("taken)"):_("not taken)")));
 
 	if(cond)
-		context->exec_pos += (*context->exec_pos).arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -242,7 +242,7 @@ void ABCVm::abc_ifge(call_context* context)
 	LOG_CALL(_("ifGE (") << ((cond)?_("taken)"):_("not taken)")));
 
 	if(cond)
-		context->exec_pos += (*context->exec_pos).arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -256,7 +256,7 @@ void ABCVm::abc_ifstricteq(call_context* context)
 	ASATOM_DECREF_POINTER(v1);
 	ASATOM_DECREF_POINTER(v2);
 	if(cond)
-		context->exec_pos += (*context->exec_pos).arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -270,7 +270,7 @@ void ABCVm::abc_ifstrictne(call_context* context)
 	ASATOM_DECREF_POINTER(v1);
 	ASATOM_DECREF_POINTER(v2);
 	if(cond)
-		context->exec_pos += (*context->exec_pos).arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -1174,7 +1174,13 @@ void ABCVm::abc_add(call_context* context)
 	RUNTIME_STACK_POP_CREATE(context,v2);
 	RUNTIME_STACK_POINTER_CREATE(context,pval);
 	ASObject* o = asAtomHandler::getObject(*pval);
-	if (asAtomHandler::add(*pval,*v2,context->sys,context->exec_pos->local3.flags & ABC_OP_FORCEINT))
+	if (o && o->is<ASString>() && o->isLastRef() && !(context->exec_pos->local3.flags & ABC_OP_FORCEINT))
+	{
+		// the stack holds the only reference to the string (e.g. the result of a previous add), so we can append to it
+		o->as<ASString>()->append(asAtomHandler::toString(*v2,context->sys));
+		ASATOM_DECREF_POINTER(v2);
+	}
+	else if (asAtomHandler::add(*pval,*v2,context->sys,context->exec_pos->local3.flags & ABC_OP_FORCEINT))
 	{
 		ASATOM_DECREF_POINTER(v2);
 		if (o)
@@ -37,7 +37,7 @@ void ABCVm::abc_ifnlt_constant_constant(call_context* context)
 	bool cond=!(asAtomHandler::isLess(*context->exec_pos->arg1_constant,context->sys,*context->exec_pos->arg2_constant) == TTRUE);
 	LOG_CALL(_("ifNLT_cc (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -46,7 +46,7 @@ void ABCVm::abc_ifnlt_local_constant(call_context* context)
 	bool cond=!(asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->sys,*context->exec_pos->arg2_constant) == TTRUE);
 	LOG_CALL(_("ifNLT_lc (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -55,7 +55,7 @@ void ABCVm::abc_ifnlt_constant_local(call_context* context)
 	bool cond=!(asAtomHandler::isLess(*context->exec_pos->arg1_constant,context->sys,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)) == TTRUE);
 	LOG_CALL(_("ifNLT_cl (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -64,7 +64,7 @@ void ABCVm::abc_ifnlt_local_local(call_context* context)
 	bool cond=!(asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->sys,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)) == TTRUE);
 	LOG_CALL(_("ifNLT_ll (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -73,7 +73,7 @@ void ABCVm::abc_ifnge_constant_constant(call_context* context)
 	bool cond=!(asAtomHandler::isLess(*context->exec_pos->arg1_constant,context->sys,*context->exec_pos->arg2_constant) == TFALSE);
 	LOG_CALL("ifNGE_cc (" << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -82,7 +82,7 @@ void ABCVm::abc_ifnge_local_constant(call_context* context)
 	bool cond=!(asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->sys,*context->exec_pos->arg2_constant) == TFALSE);
 	LOG_CALL("ifNGE_lc (" << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -91,7 +91,7 @@ void ABCVm::abc_ifnge_constant_local(call_context* context)
 	bool cond=!(asAtomHandler::isLess(*context->exec_pos->arg1_constant,context->sys,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)) == TFALSE);
 	LOG_CALL("ifNGE_cl (" << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -100,7 +100,7 @@ void ABCVm::abc_ifnge_local_local(call_context* context)
 	bool cond=!(asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->sys,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)) == TFALSE);
 	LOG_CALL("ifNGE_ll (" << ((cond)?_("taken)"):_("not taken)"))<<" "<<asAtomHandler::toDebugString(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1))<<" "<<asAtomHandler::toDebugString(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -109,7 +109,7 @@ void ABCVm::abc_iftrue_constant(call_context* context)
 	bool cond=asAtomHandler::Boolean_concrete(*context->exec_pos->arg1_constant);
 	LOG_CALL(_("ifTrue_c (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -118,7 +118,7 @@ void ABCVm::abc_iftrue_local(call_context* context)
 	bool cond=asAtomHandler::Boolean_concrete(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1));
 	LOG_CALL(_("ifTrue_l (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -128,7 +128,7 @@ void ABCVm::abc_iftrue_dup_constant(call_context* context)
 	bool cond=asAtomHandler::Boolean_concrete(*instrptr->arg1_constant);
 	LOG_CALL(_("ifTrue_dup_c (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 	RUNTIME_STACK_PUSH(context,*instrptr->arg1_constant);
@@ -139,7 +139,7 @@ void ABCVm::abc_iftrue_dup_local(call_context* context)
 	bool cond=asAtomHandler::Boolean_concrete(CONTEXT_GETLOCAL(context,instrptr->local_pos1));
 	LOG_CALL(_("ifTrue_dup_l (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 	ASATOM_INCREF(CONTEXT_GETLOCAL(context,instrptr->local_pos1));
@@ -150,7 +150,7 @@ void ABCVm::abc_iffalse_constant(call_context* context)
 	bool cond=!asAtomHandler::Boolean_concrete(*context->exec_pos->arg1_constant);
 	LOG_CALL(_("ifFalse_c (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -159,7 +159,7 @@ void ABCVm::abc_iffalse_local(call_context* context)
 	bool cond=!asAtomHandler::Boolean_concrete(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1));
 	LOG_CALL(_("ifFalse_l (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -169,7 +169,7 @@ void ABCVm::abc_iffalse_dup_constant(call_context* context)
 	bool cond=!asAtomHandler::Boolean_concrete(*instrptr->arg1_constant);
 	LOG_CALL(_("ifFalse_dup_c (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 	RUNTIME_STACK_PUSH(context,*instrptr->arg1_constant);
@@ -180,7 +180,7 @@ void ABCVm::abc_iffalse_dup_local(call_context* context)
 	bool cond=!asAtomHandler::Boolean_concrete(CONTEXT_GETLOCAL(context,instrptr->local_pos1));
 	LOG_CALL(_("ifFalse_dup_l (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 	ASATOM_INCREF(CONTEXT_GETLOCAL(context,instrptr->local_pos1));
@@ -191,7 +191,7 @@ void ABCVm::abc_ifeq_constant_constant(call_context* context)
 	bool cond=asAtomHandler::isEqual(*context->exec_pos->arg1_constant,context->sys,*context->exec_pos->arg2_constant);
 	LOG_CALL(_("ifEq_cc (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -200,7 +200,7 @@ void ABCVm::abc_ifeq_local_constant(call_context* context)
 	bool cond=asAtomHandler::isEqual(*context->exec_pos->arg2_constant,context->sys,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1));
 	LOG_CALL(_("ifEq_lc (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -209,7 +209,7 @@ void ABCVm::abc_ifeq_constant_local(call_context* context)
 	bool cond=asAtomHandler::isEqual(*context->exec_pos->arg1_constant,context->sys,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
 	LOG_CALL(_("ifEq_cl (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -218,7 +218,7 @@ void ABCVm::abc_ifeq_local_local(call_context* context)
 	bool cond=asAtomHandler::isEqual(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->sys,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
 	LOG_CALL(_("ifEq_ll (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -227,7 +227,7 @@ void ABCVm::abc_ifne_constant_constant(call_context* context)
 	bool cond=!asAtomHandler::isEqual(*context->exec_pos->arg1_constant,context->sys,*context->exec_pos->arg2_constant);
 	LOG_CALL(_("ifNE_cc (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -236,7 +236,7 @@ void ABCVm::abc_ifne_local_constant(call_context* context)
 	bool cond=!asAtomHandler::isEqual(*context->exec_pos->arg2_constant,context->sys,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1));
 	LOG_CALL(_("ifNE_lc (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -245,7 +245,7 @@ void ABCVm::abc_ifne_constant_local(call_context* context)
 	bool cond=!asAtomHandler::isEqual(*context->exec_pos->arg1_constant,context->sys,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
 	LOG_CALL(_("ifNE_cl (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -254,7 +254,7 @@ void ABCVm::abc_ifne_local_local(call_context* context)
 	bool cond=!asAtomHandler::isEqual(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->sys,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
 	LOG_CALL(_("ifNE_ll (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -264,7 +264,7 @@ void ABCVm::abc_iflt_constant_constant(call_context* context)
 	bool cond=asAtomHandler::isLess(*context->exec_pos->arg1_constant,context->sys,*context->exec_pos->arg2_constant) == TTRUE;
 	LOG_CALL(_("ifLT_cc (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -273,7 +273,7 @@ void ABCVm::abc_iflt_local_constant(call_context* context)
 	bool cond=asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->sys,*context->exec_pos->arg2_constant) == TTRUE;
 	LOG_CALL(_("ifLT_lc (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -282,7 +282,7 @@ void ABCVm::abc_iflt_constant_local(call_context* context)
 	bool cond=asAtomHandler::isLess(*context->exec_pos->arg1_constant,context->sys,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)) == TTRUE;
 	LOG_CALL(_("ifLT_cl (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -291,7 +291,7 @@ void ABCVm::abc_iflt_local_local(call_context* context)
 	bool cond=asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->sys,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)) == TTRUE;
 	LOG_CALL(_("ifLT_ll (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -300,7 +300,7 @@ void ABCVm::abc_ifle_constant_constant(call_context* context)
 	bool cond=asAtomHandler::isLess(*context->exec_pos->arg2_constant,context->sys,*context->exec_pos->arg1_constant) == TFALSE;
 	LOG_CALL(_("ifLE_cc (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -309,7 +309,7 @@ void ABCVm::abc_ifle_local_constant(call_context* context)
 	bool cond=asAtomHandler::isLess(*context->exec_pos->arg2_constant,context->sys,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) == TFALSE;
 	LOG_CALL(_("ifLE_lc (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -318,7 +318,7 @@ void ABCVm::abc_ifle_constant_local(call_context* context)
 	bool cond=asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->sys,*context->exec_pos->arg1_constant) == TFALSE;
 	LOG_CALL(_("ifLE_cl (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -327,7 +327,7 @@ void ABCVm::abc_ifle_local_local(call_context* context)
 	bool cond=asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->sys,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) == TFALSE;
 	LOG_CALL(_("ifLE_ll (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -336,7 +336,7 @@ void ABCVm::abc_ifgt_constant_constant(call_context* context)
 	bool cond=asAtomHandler::isLess(*context->exec_pos->arg2_constant,context->sys,*context->exec_pos->arg1_constant) == TTRUE;
 	LOG_CALL(_("ifGT_cc (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -345,7 +345,7 @@ void ABCVm::abc_ifgt_local_constant(call_context* context)
 	bool cond=asAtomHandler::isLess(*context->exec_pos->arg2_constant,context->sys,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) == TTRUE;
 	LOG_CALL(_("ifGT_lc (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -354,7 +354,7 @@ void ABCVm::abc_ifgt_constant_local(call_context* context)
 	bool cond=asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->sys,*context->exec_pos->arg1_constant) == TTRUE;
 	LOG_CALL(_("ifGT_cl (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -363,7 +363,7 @@ void ABCVm::abc_ifgt_local_local(call_context* context)
 	bool cond=asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->sys,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) == TTRUE;
 	LOG_CALL(_("ifGT_ll (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -372,7 +372,7 @@ void ABCVm::abc_ifge_constant_constant(call_context* context)
 	bool cond=asAtomHandler::isLess(*context->exec_pos->arg1_constant,context->sys,*context->exec_pos->arg2_constant) == TFALSE;
 	LOG_CALL(_("ifGE_cc (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -381,7 +381,7 @@ void ABCVm::abc_ifge_local_constant(call_context* context)
 	bool cond=asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->sys,*context->exec_pos->arg2_constant) == TFALSE;
 	LOG_CALL(_("ifGE_lc (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -390,7 +390,7 @@ void ABCVm::abc_ifge_constant_local(call_context* context)
 	bool cond=asAtomHandler::isLess(*context->exec_pos->arg1_constant,context->sys,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)) == TFALSE;
 	LOG_CALL(_("ifGE_cl (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -399,7 +399,7 @@ void ABCVm::abc_ifge_local_local(call_context* context)
 	bool cond=asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->sys,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)) == TFALSE;
 	LOG_CALL(_("ifGE_ll (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -408,7 +408,7 @@ void ABCVm::abc_ifstricteq_constant_constant(call_context* context)
 	bool cond=asAtomHandler::isEqualStrict(*context->exec_pos->arg1_constant,context->sys,*context->exec_pos->arg2_constant);
 	LOG_CALL(_("ifstricteq_cc (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -417,7 +417,7 @@ void ABCVm::abc_ifstricteq_local_constant(call_context* context)
 	bool cond=asAtomHandler::isEqualStrict(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->sys,*context->exec_pos->arg2_constant);
 	LOG_CALL(_("ifstricteq_lc (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -426,7 +426,7 @@ void ABCVm::abc_ifstricteq_constant_local(call_context* context)
 	bool cond=asAtomHandler::isEqualStrict(*context->exec_pos->arg1_constant,context->sys,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
 	LOG_CALL(_("ifstricteq_cl (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -436,7 +436,7 @@ void ABCVm::abc_ifstricteq_local_local(call_context* context)
 	bool cond=asAtomHandler::isEqualStrict(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->sys,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
 	LOG_CALL(_("ifstricteq_ll (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -445,7 +445,7 @@ void ABCVm::abc_ifstrictne_constant_constant(call_context* context)
 	bool cond=!asAtomHandler::isEqualStrict(*context->exec_pos->arg1_constant,context->sys,*context->exec_pos->arg2_constant);
 	LOG_CALL(_("ifstrictne_cc (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -454,7 +454,7 @@ void ABCVm::abc_ifstrictne_local_constant(call_context* context)
 	bool cond=!asAtomHandler::isEqualStrict(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->sys,*context->exec_pos->arg2_constant);
 	LOG_CALL(_("ifstrictne_lc (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -463,7 +463,7 @@ void ABCVm::abc_ifstrictne_constant_local(call_context* context)
 	bool cond=!asAtomHandler::isEqualStrict(*context->exec_pos->arg1_constant,context->sys,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
 	LOG_CALL(_("ifstrictne_cl (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
@@ -472,7 +472,7 @@ void ABCVm::abc_ifstrictne_local_local(call_context* context)
 	bool cond=!asAtomHandler::isEqualStrict(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->sys,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
 	LOG_CALL(_("ifstrictne_ll (") << ((cond)?_("taken)"):_("not taken)")));
 	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+		RUNTIME_BRANCH(context);
 	else
 		++(context->exec_pos);
 }
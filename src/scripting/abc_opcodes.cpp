@@ -1190,6 +1190,14 @@ ASObject* ABCVm::add(ASObject* val2, ASObject* val1)
 		val2->decRef();
 		return res;
 	}
+	else if(val1->is<ASString>() && val1->isLastRef())
+	{
+		// nobody else holds a reference to val1, so we can append to it instead of creating a new string
+		LOG_CALL("add in place " << val1->toString() << '+' << val2->toString());
+		val1->as<ASString>()->append(val2->toString());
+		val2->decRef();
+		return val1;
+	}
 	else if(val1->is<ASString>() || val2->is<ASString>())
 	{
 		tiny_string a = val1->toString();
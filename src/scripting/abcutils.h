@@ -32,6 +32,7 @@ class ASObject;
 class Class_base;
 union asAtom;
 class SyntheticFunction;
+class ApplicationDomain;
 
 struct scope_entry
 {
@@ -68,6 +69,8 @@ struct call_context
 	 * */
 	Class_base* inClass;
 	SystemState* sys;
+	/* ApplicationDomain of the executing code, used by the domain memory opcodes */
+	ApplicationDomain* applicationdomain;
 	/* Current namespace set by 'default xml namespace = ...'.
 	 * Defaults to empty string according to ECMA-357 13.1.1.1
 	 */
@@ -78,7 +81,7 @@ struct call_context
 		max_stackp(nullptr),
 		parent_scope_stack(nullptr),curr_scope_stack(0),argarrayposition(-1),
 		scope_stack(nullptr),scope_stack_dynamic(nullptr),localslots(nullptr),mi(_mi),
-		inClass(nullptr),sys(nullptr),defaultNamespaceUri(0)
+		inClass(nullptr),sys(nullptr),applicationdomain(nullptr),defaultNamespaceUri(0)
 	{
 	}
 	static void handleError(int errorcode);
@@ -104,6 +107,15 @@ else asAtomHandler::set(*(context->stackp++),val)
 	else context->handleError(kStackUnderflowError);
 
 
+// moves exec_pos to the target of a taken branch, backward branches also poll the sampler
+#define RUNTIME_BRANCH(context) \
+	do { \
+		int32_t branchoffset=context->exec_pos->arg3_int; \
+		if(branchoffset<=0) \
+			getVm(context->sys)->pollSampler(); \
+		context->exec_pos += branchoffset; \
+	} while(0)
+
 // this creates a pointer to the element on top of the stack
 // don't use the pointer after something was pushed on the stack
 #define RUNTIME_STACK_POP_CREATE(context,ret) \
@@ -23,12 +23,13 @@
 #include "backends/rendering.h"
 #include "backends/image.h"
 #include "swf.h"
+#include "platforms/fastpaths.h"
 
 using namespace std;
 using namespace lightspark;
 
 BitmapContainer::BitmapContainer(MemoryAccount* m):stride(0),width(0),height(0),
-	data(reporter_allocator<uint8_t>(m))
+	data(reporter_allocator<uint8_t>(m)),dirtyRect(0,0,0,0),uploadRect(0,0,0,0),uploadPending(false),uploaded(false)
 {
 }
 
@@ -136,9 +137,41 @@ void BitmapContainer::clear()
 
 void BitmapContainer::upload(uint8_t *data, uint32_t w, uint32_t h)
 {
+	dirtyMutex.lock();
+	uploadRect=dirtyRect;
+	dirtyRect=RECT(0,0,0,0);
+	uploadPending=false;
+	uploaded=true;
+	dirtyMutex.unlock();
 	memcpy(data, getData(), w*h*4);
 }
 
+void BitmapContainer::uploadRegion(uint32_t& x, uint32_t& y, uint32_t& w, uint32_t& h) const
+{
+	x=uploadRect.Xmin;
+	y=uploadRect.Ymin;
+	w=uploadRect.Xmax-uploadRect.Xmin;
+	h=uploadRect.Ymax-uploadRect.Ymin;
+}
+
+void BitmapContainer::addDirtyRect(const RECT& r)
+{
+	RECT clipped;
+	clipRect(r,clipped);
+	if (clipped.Xmin >= clipped.Xmax || clipped.Ymin >= clipped.Ymax)
+		return;
+	Locker l(dirtyMutex);
+	if (dirtyRect.Xmin >= dirtyRect.Xmax || dirtyRect.Ymin >= dirtyRect.Ymax)
+		dirtyRect=clipped;
+	else
+	{
+		dirtyRect.Xmin=imin(dirtyRect.Xmin,clipped.Xmin);
+		dirtyRect.Xmax=imax(dirtyRect.Xmax,clipped.Xmax);
+		dirtyRect.Ymin=imin(dirtyRect.Ymin,clipped.Ymin);
+		dirtyRect.Ymax=imax(dirtyRect.Ymax,clipped.Ymax);
+	}
+}
+
 const TextureChunk &BitmapContainer::getTexture()
 {
 	return bitmaptexture;
@@ -146,6 +179,12 @@ const TextureChunk &BitmapContainer::getTexture()
 
 void BitmapContainer::uploadFence()
 {
+	dirtyMutex.lock();
+	// the job was dropped without uploading (e.g. the render thread is not running), allow queuing a new one
+	if (!uploaded)
+		uploadPending=false;
+	uploaded=false;
+	dirtyMutex.unlock();
 	decRef();// is increffed in checkTexture
 }
 bool BitmapContainer::checkTexture()
@@ -157,6 +196,13 @@ bool BitmapContainer::checkTexture()
 	if (!bitmaptexture.isValid())
 	{
 		bitmaptexture=getSys()->getRenderThread()->allocateTexture(width, height, true);
+		addDirtyRect(RECT(0,width,0,height));
+	}
+	{
+		Locker l(dirtyMutex);
+		if (uploadPending || dirtyRect.Xmin >= dirtyRect.Xmax || dirtyRect.Ymin >= dirtyRect.Ymax)
+			return false;
+		uploadPending=true;
 	}
 	incRef();// is decreffed in uploadFence
     return true;
@@ -252,22 +298,26 @@ void BitmapContainer::copyRectangle(_R<BitmapContainer> source,
 	}
 	else
 	{
-		uint8_t* sourcedata = &source->data[0];
-		bool needsdeletion = false;
+		const uint8_t* sourcedata = &source->data[0];
+		size_t sourcestride = source->stride;
+		std::vector<uint8_t> tmp;
 		if (sourcedata == &data[0])
 		{
-			// cairo doesn't work if source and destination buffers are the same 
-			sourcedata = new uint8_t[data.size()];
-			memcpy (sourcedata,&data[0],data.size());
-			needsdeletion = true;
+			// source and destination overlap, blend from a copy of the source rectangle
+			tmp.resize(4*copyWidth*copyHeight);
+			for (int i=0; i<copyHeight; i++)
+				memcpy(&tmp[4*copyWidth*i], &data[(sy+i)*stride + 4*sx], 4*copyWidth);
+			sourcedata = &tmp[0];
+			sourcestride = 4*copyWidth;
+			sx = 0;
+			sy = 0;
+		}
+		for (int i=0; i<copyHeight; i++)
+		{
+			fastBlendOverBGRA(&data[(clippedY+i)*stride + 4*clippedX],
+					  sourcedata + (sy+i)*sourcestride + 4*sx,
+					  copyWidth);
 		}
-		//Slow path using Cairo
-		CairoRenderContext ctxt(&data[0], width, height,false);
-		ctxt.simpleBlit(clippedX, clippedY, sourcedata,
-				source->getWidth(), source->getHeight(),
-				sx, sy, copyWidth, copyHeight);
-		if (needsdeletion)
-			delete[] sourcedata;
 	}
 }
 
@@ -276,18 +326,53 @@ void BitmapContainer::fillRectangle(const RECT& inputRect, uint32_t color, bool
 	RECT clippedRect;
 	clipRect(inputRect, clippedRect);
 
+	if (!useAlpha)
+		color = 0xFF000000 | (color & 0xFFFFFF);
+	for(int32_t y=clippedRect.Ymin;y<clippedRect.Ymax;y++)
+		fastFillBGRA(getData()+y*stride + clippedRect.Xmin*4, color, clippedRect.Xmax-clippedRect.Xmin);
+}
+
+void BitmapContainer::colorTransform(const RECT& inputRect, const double mult[4], const double offset[4])
+{
+	RECT clippedRect;
+	clipRect(inputRect, clippedRect);
+	if (clippedRect.Xmax <= clippedRect.Xmin)
+		return;
+
+	for(int32_t y=clippedRect.Ymin;y<clippedRect.Ymax;y++)
+		fastColorTransformBGRA(getData()+y*stride + clippedRect.Xmin*4, clippedRect.Xmax-clippedRect.Xmin, mult, offset);
+}
+
+void BitmapContainer::histogram(const RECT& inputRect, uint32_t counts[4][256]) const
+{
+	RECT clippedRect;
+	clipRect(inputRect, clippedRect);
+	if (clippedRect.Xmax <= clippedRect.Xmin)
+		return;
+
 	for(int32_t y=clippedRect.Ymin;y<clippedRect.Ymax;y++)
+		fastHistogramBGRA(getData()+y*stride + clippedRect.Xmin*4, clippedRect.Xmax-clippedRect.Xmin, counts);
+}
+
+bool BitmapContainer::getColorBounds(uint32_t mask, uint32_t color, bool findColor, RECT& bounds) const
+{
+	bool found = false;
+	for(int32_t y=0;y<height;y++)
 	{
-		for(int32_t x=clippedRect.Xmin;x<clippedRect.Xmax;x++)
+		uint32_t first, last;
+		if (!fastFindColorBGRA(getData()+y*stride, width, mask, color, findColor, first, last))
+			continue;
+		if (!found)
 		{
-			uint32_t offset=y*stride + x*4;
-			uint32_t* ptr=(uint32_t*)(getData()+offset);
-			if (useAlpha)
-				*ptr = color;
-			else
-				*ptr = 0xFF000000 | (color & 0xFFFFFF);
+			bounds = RECT(first, last+1, y, y+1);
+			found = true;
+			continue;
 		}
+		bounds.Xmin = imin(bounds.Xmin, first);
+		bounds.Xmax = imax(bounds.Xmax, last+1);
+		bounds.Ymax = y+1;
 	}
+	return found;
 }
 
 bool BitmapContainer::scroll(int32_t x, int32_t y)
@@ -45,6 +45,17 @@ protected:
 	// buffer to contain the 
 	std::vector<uint8_t> data_colortransformed;
 	uint32_t *getDataNoBoundsChecking(int32_t x, int32_t y) const;
+	/*
+	   Region changed since the last texture upload and the region copied by the running upload.
+	   Access is protected by dirtyMutex, as the uploads happen in the render thread.
+	*/
+	Mutex dirtyMutex;
+	RECT dirtyRect;
+	RECT uploadRect;
+	// an upload job has been queued and has not started yet
+	bool uploadPending;
+	// the data has been uploaded since the last uploadFence
+	bool uploaded;
 public:
 	TextureChunk bitmaptexture;
 	BitmapContainer(MemoryAccount* m);
@@ -81,19 +92,32 @@ public:
 			   int32_t destX, int32_t destY,
 			   bool mergeAlpha);
 	void fillRectangle(const RECT& rect, uint32_t color, bool useAlpha);
+	// mult and offset are in B, G, R, A order
+	void colorTransform(const RECT& rect, const double mult[4], const double offset[4]);
+	void histogram(const RECT& rect, uint32_t counts[4][256]) const;
+	// returns false if no pixel is found
+	bool getColorBounds(uint32_t mask, uint32_t color, bool findColor, RECT& bounds) const;
 	bool scroll(int32_t x, int32_t y);
 	void floodFill(int32_t x, int32_t y, uint32_t color);
 	int getWidth() const { return width; }
 	int getHeight() const { return height; }
+	size_t getStride() const { return stride; }
 	bool isEmpty() const { return data.empty(); }
 	void clear();
+	// adds the (unclipped) rectangle to the region that has to be uploaded to the texture
+	void addDirtyRect(const RECT& r);
 
 	//ITextureUploadable interface
 	void sizeNeeded(uint32_t& w, uint32_t& h) const override { w=width; h=height; }
 	void upload(uint8_t* data, uint32_t w, uint32_t h) override;
+	void uploadRegion(uint32_t& x, uint32_t& y, uint32_t& w, uint32_t& h) const override;
 	const TextureChunk& getTexture() override;
 	void uploadFence() override;
 
+	/*
+	   returns true if an upload job has to be queued, i.e. the bitmap is not empty and no upload is pending
+	   all changes made before the pending upload starts are coalesced into it
+	*/
 	bool checkTexture();
 };
 
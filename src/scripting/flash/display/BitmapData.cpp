@@ -112,6 +112,7 @@ void BitmapData::addUser(Bitmap* b)
 	users.insert(b);
 	if (!pixels.isNull())
 	{
+		pixels->addDirtyRect(RECT(0,pixels->getWidth(),0,pixels->getHeight()));
 		if (pixels->checkTexture())
 		{
 			getSystemState()->getRenderThread()->addUploadJob(this->pixels.getPtr());
@@ -126,6 +127,20 @@ void BitmapData::removeUser(Bitmap* b)
 }
 
 void BitmapData::notifyUsers() const
+{
+	if (!pixels.isNull())
+		pixels->addDirtyRect(RECT(0,pixels->getWidth(),0,pixels->getHeight()));
+	uploadChanges();
+}
+
+void BitmapData::notifyUsers(const RECT& changed) const
+{
+	if (!pixels.isNull())
+		pixels->addDirtyRect(changed);
+	uploadChanges();
+}
+
+void BitmapData::uploadChanges() const
 {
 	if (locked > 0 || users.empty())
 		return;
@@ -352,7 +367,7 @@ ASFUNCTIONBODY_ATOM(BitmapData,setPixel)
 	ARG_UNPACK_ATOM(x)(y)(color);
 
 	th->pixels->setPixel(x, y, color, false,false);
-	th->notifyUsers();
+	th->notifyUsers(RECT(x,x+1,y,y+1));
 }
 
 ASFUNCTIONBODY_ATOM(BitmapData,setPixel32)
@@ -366,7 +381,7 @@ ASFUNCTIONBODY_ATOM(BitmapData,setPixel32)
 	ARG_UNPACK_ATOM(x)(y)(color);
 
 	th->pixels->setPixel(x, y, color, th->transparent,false);
-	th->notifyUsers();
+	th->notifyUsers(RECT(x,x+1,y,y+1));
 }
 
 ASFUNCTIONBODY_ATOM(BitmapData,getRect)
@@ -423,7 +438,7 @@ ASFUNCTIONBODY_ATOM(BitmapData,fillRect)
 		}
 	}
 	th->pixels->fillRectangle(rect->getRect(), color, th->transparent);
-	th->notifyUsers();
+	th->notifyUsers(rect->getRect());
 }
 
 ASFUNCTIONBODY_ATOM(BitmapData,copyPixels)
@@ -449,10 +464,12 @@ ASFUNCTIONBODY_ATOM(BitmapData,copyPixels)
 	if(!alphaBitmapData.isNull())
 		LOG(LOG_NOT_IMPLEMENTED, "BitmapData.copyPixels doesn't support alpha bitmap");
 
-	th->pixels->copyRectangle(source->pixels, sourceRect->getRect(),
+	RECT srcrect = sourceRect->getRect();
+	th->pixels->copyRectangle(source->pixels, srcrect,
 				  destPoint->getX(), destPoint->getY(),
 				  mergeAlpha|| !th->transparent);
-	th->notifyUsers();
+	th->notifyUsers(RECT(destPoint->getX(),destPoint->getX()+srcrect.Xmax-srcrect.Xmin,
+			     destPoint->getY(),destPoint->getY()+srcrect.Ymax-srcrect.Ymin));
 }
 
 ASFUNCTIONBODY_ATOM(BitmapData,generateFilterRect)
@@ -695,18 +712,8 @@ ASFUNCTIONBODY_ATOM(BitmapData,histogram)
 		th->pixels->clipRect(inputRect->getRect(), rect);
 	}
 
-	unsigned int counts[4][256] = {{0}};
-	for (int32_t x=rect.Xmin; x<rect.Xmax; x++)
-	{
-		for (int32_t y=rect.Ymin; y<rect.Ymax; y++)
-		{
-			uint32_t pixel = th->pixels->getPixel(x, y);
-			for (int i=0; i<4; i++)
-			{
-				counts[i][(pixel >> (8*i)) & 0xFF]++;
-			}
-		}
-	}
+	uint32_t counts[4][256] = {{0}};
+	th->pixels->histogram(rect, counts);
 
 	asAtom v=asAtomHandler::invalidAtom;
 	Template<Vector>::getInstanceS(v,sys,Template<Vector>::getTemplateInstance(sys,Class<Number>::getClass(sys),NullRef).getPtr(),NullRef);
@@ -739,37 +746,14 @@ ASFUNCTIONBODY_ATOM(BitmapData,getColorBoundsRect)
 	bool findColor;
 	ARG_UNPACK_ATOM (mask) (color) (findColor, true);
 
-	int xmin = th->getWidth();
-	int xmax = 0;
-	int ymin = th->getHeight();
-	int ymax = 0;
-	for (int32_t x=0; x<th->getWidth(); x++)
-	{
-		for (int32_t y=0; y<th->getHeight(); y++)
-		{
-			uint32_t pixel = th->pixels->getPixel(x, y);
-			if ((findColor && ((pixel & mask) == color)) ||
-			    (!findColor && ((pixel & mask) != color)))
-			{
-				if (x < xmin)
-					xmin = x;
-				if (x > xmax)
-					xmax = x;
-				if (y < ymin)
-					ymin = y;
-				if (y > ymax)
-					ymax = y;
-			}
-		}
-	}
-
+	RECT rect;
 	Rectangle *bounds = Class<Rectangle>::getInstanceS(sys);
-	if ((xmin <= xmax) && (ymin <= ymax))
+	if (th->pixels->getColorBounds(mask, color, findColor, rect))
 	{
-		bounds->x = xmin;
-		bounds->y = ymin;
-		bounds->width = xmax - xmin + 1;
-		bounds->height = ymax - ymin + 1;
+		bounds->x = rect.Xmin;
+		bounds->y = rect.Ymin;
+		bounds->width = rect.Xmax - rect.Xmin;
+		bounds->height = rect.Ymax - rect.Ymin;
 	}
 	ret =asAtomHandler::fromObject(bounds);
 }
@@ -896,39 +880,18 @@ ASFUNCTIONBODY_ATOM(BitmapData,colorTransform)
 	if (inputColorTransform.isNull())
 		throwError<TypeError>(kNullPointerError, "inputVector");
 
-	RECT rect;
-	th->pixels->clipRect(inputRect->getRect(), rect);
-	
-	vector<uint32_t> pixelvec = th->pixels->getPixelVector(rect);
-
-	unsigned int i = 0;
-	for (int32_t y=rect.Ymin; y<rect.Ymax; y++)
+	double mult[4] = { inputColorTransform->blueMultiplier, inputColorTransform->greenMultiplier,
+			   inputColorTransform->redMultiplier, inputColorTransform->alphaMultiplier };
+	double offset[4] = { inputColorTransform->blueOffset, inputColorTransform->greenOffset,
+			     inputColorTransform->redOffset, inputColorTransform->alphaOffset };
+	if (!th->transparent)
 	{
-		for (int32_t x=rect.Xmin; x<rect.Xmax; x++)
-		{
-
-			uint32_t pixel = pixelvec[i];
-
-			int a, r, g, b;
-			a = ((pixel >> 24 )&0xff) * inputColorTransform->alphaMultiplier + inputColorTransform->alphaOffset;
-			if (a > 255) a = 255;
-			if (a < 0) a = 0;
-			r = ((pixel >> 16 )&0xff) * inputColorTransform->redMultiplier + inputColorTransform->redOffset;
-			if (r > 255) r = 255;
-			if (r < 0) r = 0;
-			g = ((pixel >> 8 )&0xff) * inputColorTransform->greenMultiplier + inputColorTransform->greenOffset;
-			if (g > 255) g = 255;
-			if (g < 0) g = 0;
-			b = ((pixel )&0xff) * inputColorTransform->blueMultiplier + inputColorTransform->blueOffset;
-			if (b > 255) b = 255;
-			if (b < 0) b = 0;
-			
-			pixel = (a<<24) | (r<<16) | (g<<8) | b;
-			
-			th->pixels->setPixel(x, y, pixel, th->transparent);
-			i++;
-		}
+		// opaque bitmaps keep their alpha
+		mult[3] = 1.0;
+		offset[3] = 0.0;
 	}
+	th->pixels->colorTransform(inputRect->getRect(), mult, offset);
+	th->notifyUsers(inputRect->getRect());
 }
 ASFUNCTIONBODY_ATOM(BitmapData,compare)
 {
@@ -38,7 +38,9 @@ private:
 	//Avoid cycles by not using automatic references
 	//Bitmap will take care of removing itself when needed
 	std::set<Bitmap*> users;
-	void notifyUsers() const;
+	// only the pixels inside the rectangle have changed
+	void notifyUsers(const RECT& changed) const;
+	void uploadChanges() const;
 public:
 	BitmapData(Class_base* c);
 	BitmapData(Class_base* c, _R<BitmapContainer> b);
@@ -50,6 +52,8 @@ public:
 	int getHeight() const { return pixels->getHeight(); }
 	void addUser(Bitmap* b);
 	void removeUser(Bitmap* b);
+	// the whole bitmap has changed
+	void notifyUsers() const;
 	/*
 	 * Utility method to draw a DisplayObject on the surface
 	 */
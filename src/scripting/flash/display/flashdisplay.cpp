@@ -4070,6 +4070,7 @@ ASFUNCTIONBODY_ATOM(Stage,_getWmodeGPU)
 ASFUNCTIONBODY_ATOM(Stage,_invalidate)
 {
 	LOG(LOG_NOT_IMPLEMENTED,"invalidate not implemented yet");
+	sys->requestRenderEvent();
 	// TODO this crashes lightspark
 	Stage* th=asAtomHandler::as<Stage>(obj);
 	th->incRef();
@@ -5582,7 +5583,11 @@ ASFUNCTIONBODY_ATOM(Stage3D,requestContext3D)
 	ARG_UNPACK_ATOM(context3DRenderMode,"auto")(profile,"baseline");
 	
 	th->context3D = _MR(Class<Context3D>::getInstanceS(sys));
-	th->context3D->driverInfo = sys->getEngineData()->driverInfoString;
+	// the AGAL programs are interpreted on the cpu if requested or if there is no OpenGL engine
+	if (context3DRenderMode == "software" || sys->getEngineData() == nullptr || getenv("LIGHTSPARK_STAGE3D_SOFTWARE"))
+		th->context3D->enableSoftwareRenderer();
+	else
+		th->context3D->driverInfo = sys->getEngineData()->driverInfoString;
 	th->incRef();
 	getVm(sys)->addEvent(_MR(th),_MR(Class<Event>::getInstanceS(sys,"context3DCreate")));
 }
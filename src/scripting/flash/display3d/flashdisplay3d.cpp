@@ -18,6 +18,7 @@
 **************************************************************************/
 
 #include "scripting/flash/display3d/flashdisplay3d.h"
+#include "scripting/flash/display3d/flashdisplay3dsoftware.h"
 #include "scripting/toplevel/Vector.h"
 #include "scripting/flash/geom/flashgeom.h"
 #include "scripting/flash/display/BitmapData.h"
@@ -53,6 +54,176 @@ lightspark::tiny_string SamplerRegister::toGLSL ()
 
 namespace lightspark
 {
+uint32_t Context3D::getProgram(EngineData *engineData, const tiny_string &vertexprogram, const tiny_string &fragmentprogram)
+{
+	// the key contains both sources, separated by a \0 that can't be part of the GLSL code
+	std::string key(vertexprogram.raw_buf(),vertexprogram.numBytes());
+	key.push_back('\0');
+	key.append(fragmentprogram.raw_buf(),fragmentprogram.numBytes());
+	auto it = programcache.find(key);
+	if (it != programcache.end())
+	{
+		it->second.refcount++;
+		it->second.lastuse = ++programcacheusecount;
+		return it->second.id;
+	}
+	char str[1024];
+	int a;
+	int stat;
+	uint32_t f= UINT32_MAX;
+	uint32_t g= UINT32_MAX;
+	if (!vertexprogram.empty())
+	{
+		g = engineData->exec_glCreateShader_GL_VERTEX_SHADER();
+		const char* buf = vertexprogram.raw_buf();
+		engineData->exec_glShaderSource(g, 1, &buf,NULL);
+		engineData->exec_glCompileShader(g);
+		engineData->exec_glGetShaderInfoLog(g,1024,&a,str);
+		engineData->exec_glGetShaderiv_GL_COMPILE_STATUS(g, &stat);
+		if (!stat)
+		{
+			LOG(LOG_ERROR,"Vertex shader:\n" << vertexprogram);
+			LOG(LOG_ERROR,"Vertex shader compilation:" << str);
+			throw RunTimeException("Could not compile vertex shader");
+		}
+	}
+	if (!fragmentprogram.empty())
+	{
+		f = engineData->exec_glCreateShader_GL_FRAGMENT_SHADER();
+		const char* buf = fragmentprogram.raw_buf();
+		engineData->exec_glShaderSource(f, 1, &buf,NULL);
+		engineData->exec_glCompileShader(f);
+		engineData->exec_glGetShaderInfoLog(f,1024,&a,str);
+		engineData->exec_glGetShaderiv_GL_COMPILE_STATUS(f, &stat);
+		if (!stat)
+		{
+			LOG(LOG_ERROR,"Fragment shader:\n" << fragmentprogram);
+			LOG(LOG_ERROR,"Fragment shader compilation:" << str);
+			throw RunTimeException("Could not compile fragment shader");
+		}
+	}
+	uint32_t gpu_program = engineData->exec_glCreateProgram();
+	if (!vertexprogram.empty())
+		engineData->exec_glAttachShader(gpu_program,g);
+	if (!fragmentprogram.empty())
+		engineData->exec_glAttachShader(gpu_program,f);
+	engineData->exec_glLinkProgram(gpu_program);
+	if (!vertexprogram.empty())
+		engineData->exec_glDeleteShader(g);
+	if (!fragmentprogram.empty())
+		engineData->exec_glDeleteShader(f);
+	engineData->exec_glGetProgramInfoLog(gpu_program,1024,&a,str);
+	engineData->exec_glGetProgramiv_GL_LINK_STATUS(gpu_program,&stat);
+	if(!stat)
+	{
+		LOG(LOG_INFO,_("program link ") << str);
+		engineData->exec_glDeleteProgram(gpu_program);
+		throw RunTimeException("Could not link program");
+	}
+	gpuprogram& entry = programcache[key];
+	entry.id = gpu_program;
+	entry.refcount = 1;
+	entry.lastuse = ++programcacheusecount;
+	trimProgramCache(engineData);
+	return gpu_program;
+}
+
+void Context3D::releaseProgram(EngineData *engineData, uint32_t gpu_program)
+{
+	for (auto it = programcache.begin(); it != programcache.end(); it++)
+	{
+		if (it->second.id == gpu_program)
+		{
+			// unused programs are kept linked, so that a Program3D uploading the same sources later doesn't have to relink them
+			if (--it->second.refcount == 0)
+				trimProgramCache(engineData);
+			return;
+		}
+	}
+	engineData->exec_glDeleteProgram(gpu_program);
+}
+
+void Context3D::trimProgramCache(EngineData *engineData)
+{
+	// programs still used by a Program3D are never evicted, so the cache may grow beyond its size until they are released
+	while (programcache.size() > CONTEXT3D_PROGRAM_CACHE_SIZE)
+	{
+		auto lru = programcache.end();
+		for (auto it = programcache.begin(); it != programcache.end(); it++)
+		{
+			if (it->second.refcount == 0 && (lru == programcache.end() || it->second.lastuse < lru->second.lastuse))
+				lru = it;
+		}
+		if (lru == programcache.end())
+			break;
+		engineData->exec_glDeleteProgram(lru->second.id);
+		programcache.erase(lru);
+	}
+}
+
+const Context3D::agalshader& Context3D::getAGALShader(ByteArray *agal, bool isVertexProgram)
+{
+	// vertex and fragment programs are cached separately, as embedded GLSL shaders don't contain the program type
+	std::string key(1,isVertexProgram ? 'v' : 'f');
+	key.append((const char*)agal->getBufferNoCheck(),agal->getLength());
+	auto it = agalcache.find(key);
+	if (it != agalcache.end())
+	{
+		it->second.lastuse = ++agalcacheusecount;
+		return it->second;
+	}
+	// make room before inserting, so the returned reference stays valid
+	while (agalcache.size() >= CONTEXT3D_AGAL_CACHE_SIZE)
+	{
+		auto lru = agalcache.begin();
+		for (auto it2 = agalcache.begin(); it2 != agalcache.end(); it2++)
+		{
+			if (it2->second.lastuse < lru->second.lastuse)
+				lru = it2;
+		}
+		agalcache.erase(lru);
+	}
+	agalshader& shader = agalcache[key];
+	shader.lastuse = ++agalcacheusecount;
+	shader.glsl = AGALtoGLSL(agal,isVertexProgram,shader.samplers,shader.constants,shader.attributes);
+	if (softwarerenderer && !SoftwareRenderer3D::parseAGAL(agal,isVertexProgram,shader.instructions))
+		shader.instructions.clear();
+	return shader;
+}
+
+// stores the constants of a setProgramConstants action, used by the OpenGL and the software renderer
+void Context3D::setProgramConstants(renderaction& action)
+{
+	constantsgeneration++;
+	constantregister* constants = action.udata2 ? vertexConstants : fragmentConstants;
+	uint64_t* stamps = action.udata2 ? vertexConstantsStamp : fragmentConstantsStamp;
+	if (action.action == RENDER_SETPROGRAMCONSTANTS_FROM_MATRIX)
+	{
+		//action.udata1 = firstRegister
+		//action.udata2 = 1, if vertex constants, 0 if fragment constants
+		//action.udata3 = 1, if transposed
+		//action.fdata = matrix (4*4)
+		for (uint32_t i = 0; i < 4 && i < CONTEXT3D_PROGRAM_REGISTERS-action.udata1; i++ )
+		{
+			if (action.udata3)
+				setConstant(constants,stamps,i+action.udata1,action.fdata[i],action.fdata[i+4],action.fdata[i+8],action.fdata[i+12]);
+			else
+				setConstant(constants,stamps,i+action.udata1,action.fdata[i*4],action.fdata[i*4+1],action.fdata[i*4+2],action.fdata[i*4+3]);
+		}
+	}
+	else
+	{
+		//action.udata1 = firstRegister
+		//action.udata2 = 1, if vertex constants, 0 if fragment constants
+		//action.udata3 = numRegisters
+		//action.fdata = vector list (4*numRegisters)
+		for (uint32_t i = 0; i < action.udata3 && i < CONTEXT3D_PROGRAM_REGISTERS-action.udata1; i++ )
+			setConstant(constants,stamps,i+action.udata1,action.fdata[i*4],action.fdata[i*4+1],action.fdata[i*4+2],action.fdata[i*4+3]);
+	}
+	delete[] action.fdata;
+	action.fdata = nullptr;
+}
+
 void Context3D::handleRenderAction(EngineData* engineData, renderaction& action)
 {
 	switch (action.action)
@@ -98,84 +269,37 @@ void Context3D::handleRenderAction(EngineData* engineData, renderaction& action)
 			break;
 		case RENDER_SETPROGRAM:
 		{
-			bool needslink=false;
-			char str[1024];
-			int a;
-			int stat;
 			Program3D* p = action.dataobject->as<Program3D>();
 			//LOG(LOG_INFO,"setProgram:"<<p<<" "<<p->gpu_program);
-			uint32_t f= UINT32_MAX;
-			uint32_t g= UINT32_MAX;
-			if (!p->vertexprogram.empty())
-			{
-				needslink= true;
-				g = engineData->exec_glCreateShader_GL_VERTEX_SHADER();
-				const char* buf = p->vertexprogram.raw_buf();
-				engineData->exec_glShaderSource(g, 1, &buf,NULL);
-				engineData->exec_glCompileShader(g);
-				engineData->exec_glGetShaderInfoLog(g,1024,&a,str);
-				engineData->exec_glGetShaderiv_GL_COMPILE_STATUS(g, &stat);
-				if (!stat)
-				{
-					LOG(LOG_ERROR,"Vertex shader:\n" << p->vertexprogram);
-					LOG(LOG_ERROR,"Vertex shader compilation:" << str);
-					throw RunTimeException("Could not compile vertex shader");
-				}
-			}
-			if (!p->fragmentprogram.empty())
+			bool relinked = false;
+			if (!p->vertexprogram.empty() || !p->fragmentprogram.empty() || p->gpu_program == UINT32_MAX)
 			{
-				needslink=true;
-				f = engineData->exec_glCreateShader_GL_FRAGMENT_SHADER();
-				const char* buf = p->fragmentprogram.raw_buf();
-				engineData->exec_glShaderSource(f, 1, &buf,NULL);
-				engineData->exec_glCompileShader(f);
-				engineData->exec_glGetShaderInfoLog(f,1024,&a,str);
-				engineData->exec_glGetShaderiv_GL_COMPILE_STATUS(f, &stat);
-				if (!stat)
-				{
-					LOG(LOG_ERROR,"Fragment shader:\n" << p->fragmentprogram);
-					LOG(LOG_ERROR,"Fragment shader compilation:" << str);
-					throw RunTimeException("Could not compile fragment shader");
-				}
-			}
-			if (p->gpu_program == UINT32_MAX)
-			{
-				needslink=true;
-				p->gpu_program = engineData->exec_glCreateProgram();
-			}
-			if (!p->vertexprogram.empty())
-				engineData->exec_glAttachShader(p->gpu_program,g);
-			if (!p->fragmentprogram.empty())
-				engineData->exec_glAttachShader(p->gpu_program,f);
-			
-			if (needslink)
-				engineData->exec_glLinkProgram(p->gpu_program);
-			if (!p->vertexprogram.empty())
-				engineData->exec_glDeleteShader(g);
-			if (!p->fragmentprogram.empty())
-				engineData->exec_glDeleteShader(f);
-			engineData->exec_glUseProgram(p->gpu_program);
-			currentprogram = p;
-			if (needslink)
-			{
-				engineData->exec_glGetProgramInfoLog(p->gpu_program,1024,&a,str);
-				engineData->exec_glGetProgramiv_GL_LINK_STATUS(p->gpu_program,&stat);
-				if(!stat)
-				{
-					LOG(LOG_INFO,_("program link ") << str);
-					throw RunTimeException("Could not link program");
-				}
-				for (auto it = currentprogram->samplerState.begin();it != currentprogram->samplerState.end(); it++)
+				relinked = true;
+				uint32_t gpu_program = getProgram(engineData,p->vertexprogram,p->fragmentprogram);
+				if (p->gpu_program != UINT32_MAX)
+					releaseProgram(engineData,p->gpu_program);
+				p->gpu_program = gpu_program;
+				p->vcPositionScale = UINT32_MAX;
+				for (auto it = p->samplerState.begin();it != p->samplerState.end(); it++)
 					it->program_sampler_id = UINT32_MAX;
-				for (auto it = currentprogram->vertexregistermap.begin();it != currentprogram->vertexregistermap.end(); it++)
+				for (auto it = p->vertexregistermap.begin();it != p->vertexregistermap.end(); it++)
 					it->program_register_id = UINT32_MAX;
-				for (auto it = currentprogram->fragmentregistermap.begin();it != currentprogram->fragmentregistermap.end(); it++)
+				for (auto it = p->fragmentregistermap.begin();it != p->fragmentregistermap.end(); it++)
 					it->program_register_id = UINT32_MAX;
-				for (auto it = currentprogram->vertexattributes.begin();it != currentprogram->vertexattributes.end(); it++)
+				for (auto it = p->vertexattributes.begin();it != p->vertexattributes.end(); it++)
 					it->program_register_id = UINT32_MAX;
-				for (auto it = currentprogram->fragmentattributes.begin();it != currentprogram->fragmentattributes.end(); it++)
+				for (auto it = p->fragmentattributes.begin();it != p->fragmentattributes.end(); it++)
 					it->program_register_id = UINT32_MAX;
 			}
+			if (p == currentprogram && !relinked)
+				break;
+			// the GL program may be shared with other Program3D objects that have uploaded different constants
+			for (auto it = p->vertexregistermap.begin();it != p->vertexregistermap.end(); it++)
+				it->uploadedstamp = 0;
+			for (auto it = p->fragmentregistermap.begin();it != p->fragmentregistermap.end(); it++)
+				it->uploadedstamp = 0;
+			engineData->exec_glUseProgram(p->gpu_program);
+			currentprogram = p;
 			p->vertexprogram = "";
 			p->fragmentprogram = "";
 			setPositionScale(engineData);
@@ -209,6 +333,7 @@ void Context3D::handleRenderAction(EngineData* engineData, renderaction& action)
 					textureframebufferID = UINT32_MAX;
 				}
 			}
+			invalidateTextureCache();
 			vcposdata[1] = 1.0;
 			setPositionScale(engineData);
 			renderingToTexture = false;
@@ -263,6 +388,7 @@ void Context3D::handleRenderAction(EngineData* engineData, renderaction& action)
 			}
 			engineData->exec_glViewport(0,0,tex->width,tex->height);
 			engineData->exec_glBindTexture_GL_TEXTURE_2D(0);
+			invalidateTextureCache();
 			vcposdata[1] = -1.0;
 			setPositionScale(engineData);
 			engineData->exec_glFrontFace(true);
@@ -272,8 +398,14 @@ void Context3D::handleRenderAction(EngineData* engineData, renderaction& action)
 		case RENDER_DELETEPROGRAM:
 		{
 			Program3D* p = action.dataobject->as<Program3D>();
-			engineData->exec_glUseProgram(0);
-			engineData->exec_glDeleteProgram(p->gpu_program);
+			if (p == currentprogram)
+			{
+				// the bound program is deleted, so the next setProgram has to bind a program again
+				engineData->exec_glUseProgram(0);
+				currentprogram = nullptr;
+			}
+			if (p->gpu_program != UINT32_MAX)
+				releaseProgram(engineData,p->gpu_program);
 			p->gpu_program = UINT32_MAX;
 			break;
 		}
@@ -288,16 +420,35 @@ void Context3D::handleRenderAction(EngineData* engineData, renderaction& action)
 				VertexBuffer3D* buffer = action.dataobject->as<VertexBuffer3D>();
 				assert_and_throw(buffer->numVertices*buffer->data32PerVertex <= buffer->data.size());
 				if (buffer->bufferID == UINT32_MAX)
+				{
 					engineData->exec_glGenBuffers(1,&(buffer->bufferID));
+					buffer->buffersize = 0;
+				}
 				if (buffer->upload_needed)
 				{
 					engineData->exec_glBindBuffer_GL_ARRAY_BUFFER(buffer->bufferID);
-					if (buffer->bufferUsage == "dynamicDraw")
-						engineData->exec_glBufferData_GL_ARRAY_BUFFER_GL_DYNAMIC_DRAW(buffer->numVertices*buffer->data32PerVertex*sizeof(float),buffer->data.data());
+					// the buffer may have been bound before its first upload, so the storage is allocated here
+					if (buffer->buffersize != buffer->data.size())
+					{
+						if (buffer->bufferUsage == "dynamicDraw")
+							engineData->exec_glBufferData_GL_ARRAY_BUFFER_GL_DYNAMIC_DRAW(buffer->numVertices*buffer->data32PerVertex*sizeof(float),buffer->data.data());
+						else
+							engineData->exec_glBufferData_GL_ARRAY_BUFFER_GL_STATIC_DRAW(buffer->numVertices*buffer->data32PerVertex*sizeof(float),buffer->data.data());
+						buffer->buffersize = buffer->data.size();
+					}
 					else
-						engineData->exec_glBufferData_GL_ARRAY_BUFFER_GL_STATIC_DRAW(buffer->numVertices*buffer->data32PerVertex*sizeof(float),buffer->data.data());
+					{
+						// only the vertices changed since the last upload are transferred
+						uint32_t end = min(buffer->uploadend,buffer->numVertices);
+						if (buffer->uploadstart < end)
+							engineData->exec_glBufferSubData_GL_ARRAY_BUFFER(buffer->uploadstart*buffer->data32PerVertex*sizeof(float),
+																			 (end-buffer->uploadstart)*buffer->data32PerVertex*sizeof(float),
+																			 buffer->data.data()+buffer->uploadstart*buffer->data32PerVertex);
+					}
 					engineData->exec_glBindBuffer_GL_ARRAY_BUFFER(0);
 					buffer->upload_needed=false;
+					buffer->uploadstart = UINT32_MAX;
+					buffer->uploadend = 0;
 				}
 				attribs[action.udata1].bufferID = buffer->bufferID;
 				attribs[action.udata1].data32PerVertex = buffer->data32PerVertex;
@@ -313,7 +464,6 @@ void Context3D::handleRenderAction(EngineData* engineData, renderaction& action)
 			//action.udata2 = numTriangles
 			if (currentprogram)
 			{
-				setPositionScale(engineData);
 				setSamplers(engineData);
 				setRegisters(engineData,currentprogram->vertexregistermap,vertexConstants,true);
 				setRegisters(engineData,currentprogram->fragmentregistermap,fragmentConstants,false);
@@ -327,67 +477,51 @@ void Context3D::handleRenderAction(EngineData* engineData, renderaction& action)
 			if (buffer->bufferID == UINT32_MAX)
 			{
 				engineData->exec_glGenBuffers(1,&(buffer->bufferID));
+				buffer->buffersize = 0;
+			}
+			if (currentindexbuffer != buffer->bufferID)
+			{
 				engineData->exec_glBindBuffer_GL_ELEMENT_ARRAY_BUFFER(buffer->bufferID);
+				currentindexbuffer = buffer->bufferID;
+			}
+			if (buffer->buffersize != buffer->data.size())
+			{
 				if (buffer->bufferUsage == "dynamicDraw")
 					engineData->exec_glBufferData_GL_ELEMENT_ARRAY_BUFFER_GL_DYNAMIC_DRAW(buffer->data.size()*sizeof(uint16_t),buffer->data.data());
 				else
 					engineData->exec_glBufferData_GL_ELEMENT_ARRAY_BUFFER_GL_STATIC_DRAW(buffer->data.size()*sizeof(uint16_t),buffer->data.data());
+				buffer->buffersize = buffer->data.size();
 			}
-			else
-				engineData->exec_glBindBuffer_GL_ELEMENT_ARRAY_BUFFER(buffer->bufferID);
+			else if (buffer->upload_needed && buffer->uploadstart < buffer->uploadend)
+			{
+				// only the indices changed since the last upload are transferred
+				engineData->exec_glBufferSubData_GL_ELEMENT_ARRAY_BUFFER(buffer->uploadstart*sizeof(uint16_t),
+																		 (buffer->uploadend-buffer->uploadstart)*sizeof(uint16_t),
+																		 buffer->data.data()+buffer->uploadstart);
+			}
+			buffer->upload_needed = false;
+			buffer->uploadstart = UINT32_MAX;
+			buffer->uploadend = 0;
+			// the buffers stay bound for the following draw calls, they are unbound at the end of the frame
 			engineData->exec_glDrawElements_GL_TRIANGLES_GL_UNSIGNED_SHORT(count,(void*)(action.udata1*sizeof(uint16_t)));
-			engineData->exec_glBindBuffer_GL_ARRAY_BUFFER(0);
-			engineData->exec_glBindBuffer_GL_ELEMENT_ARRAY_BUFFER(0);
 			break;
 		}
 		case RENDER_DELETEBUFFER:
 			//action.udata1 = bufferID
 			engineData->exec_glDeleteBuffers(1,&action.udata1);
-			break;
-		case RENDER_SETPROGRAMCONSTANTS_FROM_MATRIX:
-		{
-			//action.udata1 = firstRegister
-			//action.udata2 = 1, if vertex constants, 0 if fragment constants
-			//action.udata3 = 1, if transposed
-			//action.fdata = matrix (4*4)
-			for (uint32_t i = 0; i < 4 && i < CONTEXT3D_PROGRAM_REGISTERS-action.udata1; i++ )
+			// the buffer name may be reused by the next created buffer
+			if (currentindexbuffer == action.udata1)
+				currentindexbuffer = UINT32_MAX;
+			for (auto it = currentattribs.begin(); it != currentattribs.end(); it++)
 			{
-				float* data = action.udata2 ? vertexConstants[i+action.udata1].data : fragmentConstants[i+action.udata1].data;
-				if (action.udata3)
-				{
-					data[0] = action.fdata[i];
-					data[1] = action.fdata[i+4];
-					data[2] = action.fdata[i+8];
-					data[3] = action.fdata[i+12];
-				}
-				else
-				{
-					data[0] = action.fdata[i*4];
-					data[1] = action.fdata[i*4+1];
-					data[2] = action.fdata[i*4+2];
-					data[3] = action.fdata[i*4+3];
-				}
+				if (it->bufferID == action.udata1)
+					it->bufferID = UINT32_MAX;
 			}
-			delete[] action.fdata;
 			break;
-		}
+		case RENDER_SETPROGRAMCONSTANTS_FROM_MATRIX:
 		case RENDER_SETPROGRAMCONSTANTS_FROM_VECTOR:
-		{
-			//action.udata1 = firstRegister
-			//action.udata2 = 1, if vertex constants, 0 if fragment constants
-			//action.udata3 = numRegisters
-			//action.fdata = vector list (4*numRegisters)
-			for (uint32_t i = 0; i < action.udata3 && i < CONTEXT3D_PROGRAM_REGISTERS-action.udata1; i++ )
-			{
-				float* data = action.udata2 ? vertexConstants[i+action.udata1].data : fragmentConstants[i+action.udata1].data;
-				data[0] = action.fdata[i*4];
-				data[1] = action.fdata[i*4+1];
-				data[2] = action.fdata[i*4+2];
-				data[3] = action.fdata[i*4+3];
-			}
-			delete[] action.fdata;
+			setProgramConstants(action);
 			break;
-		}
 		case RENDER_SETTEXTUREAT:
 		{
 			//action.dataobject = TextureBase
@@ -397,6 +531,7 @@ void Context3D::handleRenderAction(EngineData* engineData, renderaction& action)
 				//LOG(LOG_INFO,"RENDER_SETTEXTUREAT remove:"<<action.udata1);
 				engineData->exec_glActiveTexture_GL_TEXTURE0(action.udata1);
 				engineData->exec_glBindTexture_GL_TEXTURE_2D(0);
+				currenttextures[action.udata1] = UINT32_MAX;
 			}
 			else
 			{
@@ -415,21 +550,38 @@ void Context3D::handleRenderAction(EngineData* engineData, renderaction& action)
 		{
 			//action.udata1 = sourcefactor
 			//action.udata2 = destinationfactor
-			engineData->exec_glBlendFunc((BLEND_FACTOR)action.udata1,(BLEND_FACTOR)action.udata2);
+			if (currentblendsrc != action.udata1 || currentblenddst != action.udata2)
+			{
+				engineData->exec_glBlendFunc((BLEND_FACTOR)action.udata1,(BLEND_FACTOR)action.udata2);
+				currentblendsrc = action.udata1;
+				currentblenddst = action.udata2;
+			}
 			break;
 		}
 		case RENDER_SETDEPTHTEST:
 		{
 			//action.udata1 = depthMask ? 1:0
 			//action.udata2 = passCompareMode
-			engineData->exec_glDepthMask(action.udata1);
-			engineData->exec_glDepthFunc((DEPTH_FUNCTION)action.udata2);
+			if (currentdepthmask != action.udata1)
+			{
+				engineData->exec_glDepthMask(action.udata1);
+				currentdepthmask = action.udata1;
+			}
+			if (currentdepthfunc != action.udata2)
+			{
+				engineData->exec_glDepthFunc((DEPTH_FUNCTION)action.udata2);
+				currentdepthfunc = action.udata2;
+			}
 			break;
 		}
 		case RENDER_SETCULLING:
 		{
 			//action.udata1 = mode
-			engineData->exec_glCullFace((TRIANGLE_FACE)action.udata1);
+			if (currentculling != action.udata1)
+			{
+				engineData->exec_glCullFace((TRIANGLE_FACE)action.udata1);
+				currentculling = action.udata1;
+			}
 			break;
 		}
 		case RENDER_LOADTEXTURE:
@@ -445,13 +597,30 @@ void Context3D::handleRenderAction(EngineData* engineData, renderaction& action)
 			break;
 		case RENDER_SETCOLORMASK:
 			// action.udata1 = red | green | blue | alpha
-			engineData->exec_glColorMask(action.udata1&0x01,action.udata1&0x02,action.udata1&0x04,action.udata1&0x08);
+			if (currentcolormask != action.udata1)
+			{
+				engineData->exec_glColorMask(action.udata1&0x01,action.udata1&0x02,action.udata1&0x04,action.udata1&0x08);
+				currentcolormask = action.udata1;
+			}
 			break;
 	}
 }
 
+void Context3D::setConstant(constantregister* constants, uint64_t* stamps, uint32_t n, float x, float y, float z, float w)
+{
+	float* data = constants[n].data;
+	if (data[0] == x && data[1] == y && data[2] == z && data[3] == w)
+		return;
+	data[0] = x;
+	data[1] = y;
+	data[2] = z;
+	data[3] = w;
+	stamps[n] = constantsgeneration;
+}
+
 void Context3D::setRegisters(EngineData* engineData,std::vector<RegisterMapEntry>& registermap,constantregister* constants, bool isVertex)
 {
+	uint64_t* stamps = isVertex ? vertexConstantsStamp : fragmentConstantsStamp;
 	auto it = registermap.begin();
 	while (it != registermap.end())
 	{
@@ -465,9 +634,16 @@ void Context3D::setRegisters(EngineData* engineData,std::vector<RegisterMapEntry
 					char buf[100];
 					sprintf(buf,"%cc%d",isVertex?'v':'f',it->number);
 					it->program_register_id = engineData->exec_glGetUniformLocation(currentprogram->gpu_program,buf);
+					it->uploadedstamp = 0;
 				}
+				// constants that didn't change since the last upload to this program are skipped
+				if (stamps[it->number] <= it->uploadedstamp)
+					break;
 				if (it->program_register_id != UINT32_MAX)
+				{
 					engineData->exec_glUniform4fv(it->program_register_id,1, data);
+					it->uploadedstamp = constantsgeneration;
+				}
 				else
 					LOG(LOG_ERROR,"setRegisters vector no location:"<<it->number);
 				break;
@@ -479,7 +655,13 @@ void Context3D::setRegisters(EngineData* engineData,std::vector<RegisterMapEntry
 				{
 					sprintf(buf,"%cc%d",isVertex?'v':'f',it->number);
 					it->program_register_id = engineData->exec_glGetUniformLocation(currentprogram->gpu_program,buf);
+					it->uploadedstamp = 0;
 				}
+				bool changed = false;
+				for (uint32_t i = 0; i < 4 && it->number+i < CONTEXT3D_PROGRAM_REGISTERS; i++)
+					changed |= stamps[it->number+i] > it->uploadedstamp;
+				if (!changed)
+					break;
 				float data2[4*4];
 				for (uint32_t i =0; i < 4; i++)
 				{
@@ -490,7 +672,10 @@ void Context3D::setRegisters(EngineData* engineData,std::vector<RegisterMapEntry
 					data2[i*4+3] = data[3];
 				}
 				if (it->program_register_id != UINT32_MAX)
+				{
 					engineData->exec_glUniformMatrix4fv(it->program_register_id,1,false, data2);
+					it->uploadedstamp = constantsgeneration;
+				}
 				else
 					LOG(LOG_ERROR,"setRegisters no location:"<<it->number);
 				break;
@@ -518,9 +703,19 @@ void Context3D::setAttribs(EngineData *engineData,std::vector<RegisterMapEntry>&
 			}
 			if (it->program_register_id != UINT32_MAX)
 			{
-				engineData->exec_glEnableVertexAttribArray(it->program_register_id);
-				engineData->exec_glBindBuffer_GL_ARRAY_BUFFER(attribs[it->number].bufferID);
-				engineData->exec_glVertexAttribPointer(it->program_register_id, attribs[it->number].data32PerVertex*sizeof(float), (const void*)(size_t)(attribs[it->number].offset*4),attribs[it->number].format);
+				// the attribute pointers are global state, so they only have to be set if they point to a different buffer or layout
+				if (it->program_register_id >= currentattribs.size())
+					currentattribs.resize(it->program_register_id+1);
+				attribregister& current = currentattribs[it->program_register_id];
+				const attribregister& reg = attribs[it->number];
+				if (current.bufferID != reg.bufferID || current.data32PerVertex != reg.data32PerVertex
+						|| current.offset != reg.offset || current.format != reg.format)
+				{
+					engineData->exec_glEnableVertexAttribArray(it->program_register_id);
+					engineData->exec_glBindBuffer_GL_ARRAY_BUFFER(reg.bufferID);
+					engineData->exec_glVertexAttribPointer(it->program_register_id, reg.data32PerVertex*sizeof(float), (const void*)(size_t)(reg.offset*4),reg.format);
+					current = reg;
+				}
 			}
 		}
 		it++;
@@ -531,22 +726,39 @@ void Context3D::setSamplers(EngineData *engineData)
 {
 	for (uint32_t i = 0; i < currentprogram->samplerState.size();i++)
 	{
-		uint32_t sampid = currentprogram->samplerState[i].program_sampler_id;
+		SamplerRegister& state = currentprogram->samplerState[i];
+		uint32_t sampid = state.program_sampler_id;
+		bool newlocation = false;
 		if (sampid == UINT32_MAX)
 		{
 			char buf[100];
-			sprintf(buf,"sampler%d",currentprogram->samplerState[i].n);
+			sprintf(buf,"sampler%d",state.n);
 			sampid = engineData->exec_glGetUniformLocation(currentprogram->gpu_program,buf);
+			newlocation = true;
 		}
-		if (sampid != UINT32_MAX && samplers[currentprogram->samplerState[i].n] != UINT32_MAX)
+		if (sampid != UINT32_MAX && samplers[state.n] != UINT32_MAX)
 		{
-			currentprogram->samplerState[i].program_sampler_id = sampid;
-			engineData->exec_glActiveTexture_GL_TEXTURE0(currentprogram->samplerState[i].n);
-			engineData->exec_glBindTexture_GL_TEXTURE_2D(samplers[currentprogram->samplerState[i].n]);
-			if (currentprogram->samplerState[i].m) // mipmaps
-				engineData->exec_glGenerateMipmap_GL_TEXTURE_2D();
-			engineData->exec_glSetTexParameters(currentprogram->samplerState[i].b,currentprogram->samplerState[i].d,currentprogram->samplerState[i].f,currentprogram->samplerState[i].m,currentprogram->samplerState[i].w);
-			engineData->exec_glUniform1i(sampid, currentprogram->samplerState[i].n);
+			state.program_sampler_id = sampid;
+			uint32_t samplerkey = ((state.b&0xff)<<16) | ((state.d&0xf)<<12) | ((state.f&0xf)<<8) | ((state.m&0xf)<<4) | (state.w&0xf);
+			if (currenttextures[state.n] != samplers[state.n] || currentsamplerstate[state.n] != samplerkey)
+			{
+				// the texture parameters are stored in the texture, so other units using the same texture have to be set again
+				for (uint32_t j = 0; j < CONTEXT3D_SAMPLER_COUNT; j++)
+				{
+					if (currenttextures[j] == samplers[state.n])
+						currenttextures[j] = UINT32_MAX;
+				}
+				engineData->exec_glActiveTexture_GL_TEXTURE0(state.n);
+				engineData->exec_glBindTexture_GL_TEXTURE_2D(samplers[state.n]);
+				if (state.m) // mipmaps
+					engineData->exec_glGenerateMipmap_GL_TEXTURE_2D();
+				engineData->exec_glSetTexParameters(state.b,state.d,state.f,state.m,state.w);
+				currenttextures[state.n] = samplers[state.n];
+				currentsamplerstate[state.n] = samplerkey;
+			}
+			// the sampler uniform only has to be set once per program
+			if (newlocation)
+				engineData->exec_glUniform1i(sampid, state.n);
 		}
 		else
 			LOG(LOG_ERROR,"sampler not found in program:"<<currentprogram->samplerState[i].n);
@@ -565,10 +777,18 @@ void Context3D::setPositionScale(EngineData *engineData)
 
 bool Context3D::renderImpl(RenderContext &ctxt)
 {
+	if (softwarerenderer)
+	{
+		// without an engine the frame is only available through drawToBitmapData
+		EngineData* engineData = getSystemState()->getEngineData();
+		return engineData ? softwarerenderer->renderFrame(engineData) : false;
+	}
 	Locker l(rendermutex);
 	if (!swapbuffers || actions[1-currentactionvector].size() == 0)
 		return false;
 	EngineData* engineData = getSystemState()->getEngineData();
+	// the state may have been changed by the stage renderer since the last frame
+	resetStateCache();
 	if (currentprogram)
 		engineData->exec_glUseProgram(currentprogram->gpu_program);
 	
@@ -607,11 +827,35 @@ bool Context3D::renderImpl(RenderContext &ctxt)
 	return true;
 }
 
+void Context3D::resetStateCache()
+{
+	currentblendsrc = UINT32_MAX;
+	currentblenddst = UINT32_MAX;
+	currentdepthmask = UINT32_MAX;
+	currentdepthfunc = UINT32_MAX;
+	currentculling = UINT32_MAX;
+	currentcolormask = UINT32_MAX;
+	currentindexbuffer = UINT32_MAX;
+	currentattribs.clear();
+	invalidateTextureCache();
+}
+
+void Context3D::invalidateTextureCache()
+{
+	for (uint32_t i = 0; i < CONTEXT3D_SAMPLER_COUNT; i++)
+	{
+		currenttextures[i] = UINT32_MAX;
+		currentsamplerstate[i] = UINT32_MAX;
+	}
+}
+
 void Context3D::loadTexture(TextureBase *tex)
 {
 	EngineData* engineData = getSystemState()->getEngineData();
 	if (tex->textureID == UINT32_MAX || tex->needrefresh)
 	{
+		// the texture is bound to the active texture unit while loading
+		invalidateTextureCache();
 		if (tex->textureID == UINT32_MAX)
 			engineData->exec_glGenTextures(1, &(tex->textureID));
 		engineData->exec_glBindTexture_GL_TEXTURE_2D(tex->textureID);
@@ -638,6 +882,7 @@ void Context3D::loadCubeTexture(CubeTexture *tex)
 	EngineData* engineData = getSystemState()->getEngineData();
 	if (tex->textureID == UINT32_MAX || tex->needrefresh)
 	{
+		invalidateTextureCache();
 		if (tex->textureID == UINT32_MAX)
 			engineData->exec_glGenTextures(1, &(tex->textureID));
 		engineData->exec_glBindTexture_GL_TEXTURE_CUBE_MAP(tex->textureID);
@@ -672,15 +917,38 @@ void Context3D::loadCubeTexture(CubeTexture *tex)
 
 Context3D::Context3D(Class_base *c):EventDispatcher(c),samplers{UINT32_MAX,UINT32_MAX,UINT32_MAX,UINT32_MAX,UINT32_MAX,UINT32_MAX,UINT32_MAX,UINT32_MAX},currentactionvector(0)
   ,textureframebuffer(UINT32_MAX),textureframebufferID(UINT32_MAX),depthRenderBuffer(UINT32_MAX),stencilRenderBuffer(UINT32_MAX),currentprogram(NULL)
-  ,renderingToTexture(false),enableDepthAndStencilBackbuffer(true),enableDepthAndStencilTextureBuffer(true),swapbuffers(false),backBufferHeight(0),backBufferWidth(0),enableErrorChecking(false)
+  ,renderingToTexture(false),enableDepthAndStencilBackbuffer(true),enableDepthAndStencilTextureBuffer(true),swapbuffers(false),constantsgeneration(0),agalcacheusecount(0),programcacheusecount(0),softwarerenderer(nullptr),backBufferHeight(0),backBufferWidth(0),enableErrorChecking(false)
   ,maxBackBufferHeight(16384),maxBackBufferWidth(16384)
 {
 	subtype = SUBTYPE_CONTEXT3D;
 	memset(vertexConstants,0,4 * CONTEXT3D_PROGRAM_REGISTERS * sizeof(float));
 	memset(fragmentConstants,0,4 * CONTEXT3D_PROGRAM_REGISTERS * sizeof(float));
+	memset(vertexConstantsStamp,0,CONTEXT3D_PROGRAM_REGISTERS * sizeof(uint64_t));
+	memset(fragmentConstantsStamp,0,CONTEXT3D_PROGRAM_REGISTERS * sizeof(uint64_t));
+	resetStateCache();
 	driverInfo = "Disposed";
 }
 
+Context3D::~Context3D()
+{
+	delete softwarerenderer;
+}
+
+void Context3D::enableSoftwareRenderer()
+{
+	if (!softwarerenderer)
+		softwarerenderer = new SoftwareRenderer3D(this);
+	driverInfo = "Software";
+}
+
+void Context3D::renderSoftware()
+{
+	for (auto it = actions[currentactionvector].begin(); it != actions[currentactionvector].end(); it++)
+		softwarerenderer->handleRenderAction(*it);
+	softwarerenderer->flush();
+	actions[currentactionvector].clear();
+}
+
 void Context3D::addAction(RENDER_ACTION type, ASObject *dataobject)
 {
 	renderaction action;
@@ -777,6 +1045,8 @@ ASFUNCTIONBODY_ATOM(Context3D,configureBackBuffer)
 	renderaction action;
 	action.action = RENDER_ACTION::RENDER_CONFIGUREBACKBUFFER;
 	action.udata1 = th->enableDepthAndStencilBackbuffer ? 1:0;
+	action.udata2 = th->backBufferWidth;
+	action.udata3 = th->backBufferHeight;
 	th->addAction(action);
 }
 ASFUNCTIONBODY_ATOM(Context3D,createCubeTexture)
@@ -867,9 +1137,20 @@ ASFUNCTIONBODY_ATOM(Context3D,clear)
 
 ASFUNCTIONBODY_ATOM(Context3D,drawToBitmapData)
 {
-	LOG(LOG_NOT_IMPLEMENTED,"Context3D.drawToBitmapData does nothing");
+	Context3D* th = asAtomHandler::as<Context3D>(obj);
 	_NR<BitmapData> destination;
 	ARG_UNPACK_ATOM(destination);
+	if (destination.isNull())
+		throwError<TypeError>(kNullPointerError, "destination");
+	if (destination->getBitmapContainer().isNull())
+		throw Class<ArgumentError>::getInstanceS(sys,"Disposed BitmapData", 2015);
+	if (!th->softwarerenderer)
+	{
+		LOG(LOG_NOT_IMPLEMENTED,"Context3D.drawToBitmapData is only implemented for the software renderer");
+		return;
+	}
+	th->renderSoftware();
+	th->softwarerenderer->drawToBitmapData(destination.getPtr());
 }
 
 ASFUNCTIONBODY_ATOM(Context3D,drawTriangles)
@@ -1136,6 +1417,12 @@ ASFUNCTIONBODY_ATOM(Context3D,setSamplerStateAt)
 ASFUNCTIONBODY_ATOM(Context3D,present)
 {
 	Context3D* th = asAtomHandler::as<Context3D>(obj);
+	if (th->softwarerenderer)
+	{
+		th->renderSoftware();
+		th->softwarerenderer->present();
+		return;
+	}
 	Locker l(th->rendermutex);
 	if (th->swapbuffers)
 	{
@@ -1353,11 +1640,23 @@ void Context3DWrapMode::sinit(Class_base *c)
 }
 
 IndexBuffer3D::IndexBuffer3D(Class_base *c, Context3D* ctx,int numVertices, tiny_string _bufferUsage)
-	:ASObject(c,T_OBJECT,SUBTYPE_INDEXBUFFER3D),context(ctx),bufferID(UINT32_MAX),bufferUsage(_bufferUsage)
+	:ASObject(c,T_OBJECT,SUBTYPE_INDEXBUFFER3D),context(ctx),bufferID(UINT32_MAX),bufferUsage(_bufferUsage),upload_needed(false),uploadstart(UINT32_MAX),uploadend(0),buffersize(0)
 {
 	data.resize(numVertices);
 }
 
+void IndexBuffer3D::setData(uint32_t startOffset, uint32_t count, const std::vector<uint16_t>& values)
+{
+	// the render thread uploads data and resets the changed range while holding the rendermutex
+	Locker l(context->rendermutex);
+	if (data.size() < count+startOffset)
+		data.resize(count+startOffset);
+	std::copy(values.begin(),values.end(),data.begin()+startOffset);
+	upload_needed = true;
+	uploadstart = min(uploadstart,startOffset);
+	uploadend = max(uploadend,startOffset+count);
+}
+
 IndexBuffer3D::~IndexBuffer3D()
 {
 	if (context && bufferID != UINT32_MAX)
@@ -1401,17 +1700,19 @@ ASFUNCTIONBODY_ATOM(IndexBuffer3D,uploadFromByteArray)
 		throwError<TypeError>(kNullPointerError);
 	if (data->getLength() < byteArrayOffset+count*2)
 		throwError<RangeError>(kParamRangeError);
-	if (th->data.size() < count+startOffset)
-		th->data.resize(count+startOffset);
+	std::vector<uint16_t> values;
+	values.reserve(count);
 	uint32_t origpos = data->getPosition();
 	data->setPosition(byteArrayOffset);
 	for (uint32_t i = 0; i< count; i++)
 	{
 		uint16_t d;
-		if (data->readShort(d))
-			th->data[startOffset+i] = d;
+		if (!data->readShort(d))
+			break;
+		values.push_back(d);
 	}
 	data->setPosition(origpos);
+	th->setData(startOffset,count,values);
 }
 ASFUNCTIONBODY_ATOM(IndexBuffer3D,uploadFromVector)
 {
@@ -1420,13 +1721,14 @@ ASFUNCTIONBODY_ATOM(IndexBuffer3D,uploadFromVector)
 	uint32_t startOffset;
 	uint32_t count;
 	ARG_UNPACK_ATOM(data)(startOffset)(count);
-	if (th->data.size() < count+startOffset)
-		th->data.resize(count+startOffset);
+	// the values are converted before the rendermutex is taken, as the conversion may call into ActionScript
+	std::vector<uint16_t> values(count);
 	for (uint32_t i = 0; i< count; i++)
 	{
 		asAtom a = data->at(i);
-		th->data[startOffset+i] = asAtomHandler::toUInt(a);
+		values[i] = asAtomHandler::toUInt(a);
 	}
+	th->setData(startOffset,count,values);
 }
 
 void Program3D::sinit(Class_base *c)
@@ -1449,17 +1751,43 @@ ASFUNCTIONBODY_ATOM(Program3D,upload)
 	ARG_UNPACK_ATOM(vertexProgram)(fragmentProgram);
 	th->samplerState.clear();
 	if (!vertexProgram.isNull())
-		th->vertexprogram = AGALtoGLSL(vertexProgram.getPtr(),true,th->samplerState,th->vertexregistermap,th->vertexattributes);
+	{
+		const Context3D::agalshader& shader = th->context3D->getAGALShader(vertexProgram.getPtr(),true);
+		th->vertexprogram = shader.glsl;
+		th->samplerState.insert(th->samplerState.end(),shader.samplers.begin(),shader.samplers.end());
+		th->vertexregistermap = shader.constants;
+		th->vertexattributes = shader.attributes;
+		th->vertexinstructions = shader.instructions;
+	}
 	if (!fragmentProgram.isNull())
-		th->fragmentprogram = AGALtoGLSL(fragmentProgram.getPtr(),false,th->samplerState,th->fragmentregistermap,th->fragmentattributes);
+	{
+		const Context3D::agalshader& shader = th->context3D->getAGALShader(fragmentProgram.getPtr(),false);
+		th->fragmentprogram = shader.glsl;
+		th->samplerState.insert(th->samplerState.end(),shader.samplers.begin(),shader.samplers.end());
+		th->fragmentregistermap = shader.constants;
+		th->fragmentattributes = shader.attributes;
+		th->fragmentinstructions = shader.instructions;
+	}
 }
 
 VertexBuffer3D::VertexBuffer3D(Class_base *c, Context3D *ctx, int _numVertices, int32_t _data32PerVertex, tiny_string _bufferUsage)
-	:ASObject(c,T_OBJECT,SUBTYPE_VERTEXBUFFER3D),context(ctx),bufferID(UINT32_MAX),numVertices(_numVertices),data32PerVertex(_data32PerVertex),bufferUsage(_bufferUsage),upload_needed(false)
+	:ASObject(c,T_OBJECT,SUBTYPE_VERTEXBUFFER3D),context(ctx),bufferID(UINT32_MAX),numVertices(_numVertices),data32PerVertex(_data32PerVertex),bufferUsage(_bufferUsage),upload_needed(false),uploadstart(UINT32_MAX),uploadend(0),buffersize(0)
 {
 	data.resize(numVertices*data32PerVertex);
 }
 
+void VertexBuffer3D::setData(uint32_t startVertex, uint32_t count, const std::vector<float>& values)
+{
+	// the render thread uploads data and resets the changed range while holding the rendermutex
+	Locker l(context->rendermutex);
+	if (data.size() < (count+startVertex)*data32PerVertex)
+		data.resize((count+startVertex)*data32PerVertex);
+	std::copy(values.begin(),values.end(),data.begin()+startVertex*data32PerVertex);
+	upload_needed = true;
+	uploadstart = min(uploadstart,startVertex);
+	uploadend = max(uploadend,startVertex+count);
+}
+
 VertexBuffer3D::~VertexBuffer3D()
 {
 	if (context && bufferID != UINT32_MAX)
@@ -1503,9 +1831,8 @@ ASFUNCTIONBODY_ATOM(VertexBuffer3D,uploadFromByteArray)
 		throwError<TypeError>(kNullPointerError);
 	if (data->getLength() < byteArrayOffset+numVertices*th->data32PerVertex*4)
 		throwError<RangeError>(kParamRangeError);
-	th->upload_needed = true;
-	if (th->data.size() < (numVertices+startVertex)* th->data32PerVertex)
-		th->data.resize((numVertices+startVertex)* th->data32PerVertex);
+	std::vector<float> values;
+	values.reserve(numVertices* th->data32PerVertex);
 	uint32_t origpos = data->getPosition();
 	data->setPosition(byteArrayOffset);
 	for (uint32_t i = 0; i< numVertices* th->data32PerVertex; i++)
@@ -1514,10 +1841,12 @@ ASFUNCTIONBODY_ATOM(VertexBuffer3D,uploadFromByteArray)
 			float f;
 			uint32_t u;
 		} d;
-		if (data->readUnsignedInt(d.u))
-			th->data[startVertex*th->data32PerVertex+i] = d.f;
+		if (!data->readUnsignedInt(d.u))
+			break;
+		values.push_back(d.f);
 	}
 	data->setPosition(origpos);
+	th->setData(startVertex,numVertices,values);
 }
 ASFUNCTIONBODY_ATOM(VertexBuffer3D,uploadFromVector)
 {
@@ -1526,14 +1855,14 @@ ASFUNCTIONBODY_ATOM(VertexBuffer3D,uploadFromVector)
 	uint32_t startVertex;
 	uint32_t numVertices;
 	ARG_UNPACK_ATOM(data)(startVertex)(numVertices);
-	th->upload_needed = true;
-	if (th->data.size() < (numVertices+startVertex)* th->data32PerVertex)
-		th->data.resize((numVertices+startVertex)* th->data32PerVertex);
+	// the values are converted before the rendermutex is taken, as the conversion may call into ActionScript
+	std::vector<float> values(numVertices* th->data32PerVertex);
 	for (uint32_t i = 0; i< numVertices* th->data32PerVertex; i++)
 	{
 		asAtom a = data->at(i);
-		th->data[startVertex*th->data32PerVertex+i] = asAtomHandler::toNumber(a);
+		values[i] = asAtomHandler::toNumber(a);
 	}
+	th->setData(startVertex,numVertices,values);
 }
 
 }
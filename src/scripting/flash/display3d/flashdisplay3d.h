@@ -25,6 +25,7 @@
 #include "scripting/flash/events/flashevents.h"
 #include "scripting/flash/display3d/flashdisplay3dtextures.h"
 #include <map>
+#include <unordered_map>
 #include "platforms/engineutils.h"
 
 enum RegisterType {
@@ -70,14 +71,39 @@ struct RegisterMapEntry
 	RegisterType type;
 	RegisterUsage usage;
 	uint32_t arraycount;
-	RegisterMapEntry():program_register_id(UINT32_MAX) {}
+	uint64_t uploadedstamp; // value of Context3D::constantsgeneration when the constant was last uploaded to the program
+	RegisterMapEntry():program_register_id(UINT32_MAX),uploadedstamp(0) {}
+};
+// decoded AGAL source register, used by the software renderer
+struct AGALSourceRegister
+{
+	RegisterType type;
+	uint32_t n; // register number, for indirect addressing this is the base register
+	uint32_t swizzle[4];
+	bool indirect;
+	RegisterType indextype;
+	uint32_t indexn;
+	uint32_t indexcomponent;
+};
+// decoded AGAL instruction, used by the software renderer
+struct AGALInstruction
+{
+	uint32_t opcode;
+	RegisterType desttype;
+	uint32_t destn;
+	uint32_t destmask;
+	AGALSourceRegister source1;
+	AGALSourceRegister source2;
+	SamplerRegister sampler; // only used by tex
 };
 
 namespace lightspark
 {
 class RenderContext;
 class VertexBuffer3D;
+class ByteArray;
 class Program3D;
+class SoftwareRenderer3D;
 
 enum RENDER_ACTION { RENDER_CLEAR,RENDER_CONFIGUREBACKBUFFER,RENDER_SETPROGRAM,RENDER_RENDERTOBACKBUFFER,RENDER_TOTEXTURE,RENDER_DELETEPROGRAM,
 					 RENDER_SETVERTEXBUFFER,RENDER_DRAWTRIANGLES,RENDER_DELETEBUFFER,
@@ -109,10 +135,15 @@ struct attribregister
 #define CONTEXT3D_SAMPLER_COUNT 8
 #define CONTEXT3D_ATTRIBUTE_COUNT 8
 #define CONTEXT3D_PROGRAM_REGISTERS 128
+// maximum number of entries kept in the AGAL and GL program caches before the least recently used ones are evicted
+#define CONTEXT3D_AGAL_CACHE_SIZE 256
+#define CONTEXT3D_PROGRAM_CACHE_SIZE 64
 
 class Context3D: public EventDispatcher
 {
 friend class Stage3D;
+friend class Program3D;
+friend class SoftwareRenderer3D;
 private:
 	std::vector<renderaction> actions[2];
 	constantregister vertexConstants[CONTEXT3D_PROGRAM_REGISTERS];
@@ -130,11 +161,60 @@ private:
 	bool enableDepthAndStencilBackbuffer;
 	bool enableDepthAndStencilTextureBuffer;
 	bool swapbuffers;
+	// generation of the last change of every constant register, so that only changed constants are uploaded
+	uint64_t constantsgeneration;
+	uint64_t vertexConstantsStamp[CONTEXT3D_PROGRAM_REGISTERS];
+	uint64_t fragmentConstantsStamp[CONTEXT3D_PROGRAM_REGISTERS];
+	// GL state last set by the render thread, used to skip redundant state changes (UINT32_MAX means unknown)
+	uint32_t currentblendsrc;
+	uint32_t currentblenddst;
+	uint32_t currentdepthmask;
+	uint32_t currentdepthfunc;
+	uint32_t currentculling;
+	uint32_t currentcolormask;
+	uint32_t currentindexbuffer;
+	uint32_t currenttextures[CONTEXT3D_SAMPLER_COUNT];
+	uint32_t currentsamplerstate[CONTEXT3D_SAMPLER_COUNT];
+	std::vector<attribregister> currentattribs; // indexed by attribute location
+	struct agalshader
+	{
+		tiny_string glsl;
+		std::vector<SamplerRegister> samplers;
+		std::vector<RegisterMapEntry> constants;
+		std::vector<RegisterMapEntry> attributes;
+		// only decoded if the software renderer is used
+		std::vector<AGALInstruction> instructions;
+		uint64_t lastuse;
+	};
+	struct gpuprogram
+	{
+		uint32_t id;
+		uint32_t refcount;
+		uint64_t lastuse;
+	};
+	// AGAL bytecode already converted to GLSL, keyed by the bytecode (only used in the vm thread)
+	std::unordered_map<std::string,agalshader> agalcache;
+	uint64_t agalcacheusecount;
+	// linked GL programs shared between all Program3D objects with the same GLSL sources (only used in the render thread)
+	// programs that are not used by any Program3D stay linked until they are evicted
+	std::unordered_map<std::string,gpuprogram> programcache;
+	uint64_t programcacheusecount;
+	// renders on the CPU instead of using OpenGL, nullptr if OpenGL is used
+	SoftwareRenderer3D* softwarerenderer;
+	void renderSoftware();
+	uint32_t getProgram(EngineData *engineData, const tiny_string& vertexprogram, const tiny_string& fragmentprogram);
+	void releaseProgram(EngineData *engineData, uint32_t gpu_program);
+	void trimProgramCache(EngineData *engineData);
+	const agalshader& getAGALShader(ByteArray* agal, bool isVertexProgram);
 	void handleRenderAction(EngineData *engineData, renderaction &action);
+	void setProgramConstants(renderaction& action);
 	void setRegisters(EngineData *engineData, std::vector<RegisterMapEntry> &registermap, constantregister *constants, bool isVertex);
 	void setAttribs(EngineData* engineData, std::vector<RegisterMapEntry> &attributes);
 	void setSamplers(EngineData* engineData);
 	void setPositionScale(EngineData *engineData);
+	void resetStateCache();
+	void invalidateTextureCache();
+	void setConstant(constantregister* constants, uint64_t* stamps, uint32_t n, float x, float y, float z, float w);
 protected:
 	bool renderImpl(RenderContext &ctxt);
 	void loadTexture(TextureBase* tex);
@@ -142,7 +222,9 @@ protected:
 public:
 	Mutex rendermutex;
 	Context3D(Class_base* c);
+	~Context3D();
 	static void sinit(Class_base* c);
+	void enableSoftwareRenderer();
 
 	void addAction(RENDER_ACTION type, ASObject* dataobject);
 	void addAction(renderaction action);
@@ -286,13 +368,21 @@ public:
 class IndexBuffer3D: public ASObject
 {
 friend class Context3D;
+friend class SoftwareRenderer3D;
 protected:
 	Context3D* context;
 	uint32_t bufferID;
 	vector<uint16_t> data;
 	tiny_string bufferUsage;
+	bool upload_needed;
+	// range of indices changed since the last upload
+	uint32_t uploadstart;
+	uint32_t uploadend;
+	uint32_t buffersize; // number of indices allocated in the GL buffer
+	// stores the values at startOffset and adds them to the range that has to be uploaded
+	void setData(uint32_t startOffset, uint32_t count, const std::vector<uint16_t>& values);
 public:
-	IndexBuffer3D(Class_base* c):ASObject(c,T_OBJECT,SUBTYPE_INDEXBUFFER3D),bufferID(UINT32_MAX){}
+	IndexBuffer3D(Class_base* c):ASObject(c,T_OBJECT,SUBTYPE_INDEXBUFFER3D),bufferID(UINT32_MAX),upload_needed(false),uploadstart(UINT32_MAX),uploadend(0),buffersize(0){}
 	IndexBuffer3D(Class_base* c, Context3D* ctx,int _numVertices,tiny_string _bufferUsage);
 	~IndexBuffer3D();
 	static void sinit(Class_base* c);
@@ -304,6 +394,7 @@ public:
 class Program3D: public ASObject
 {
 friend class Context3D;
+friend class SoftwareRenderer3D;
 private:
 	_NR<Context3D> context3D;
 	uint32_t gpu_program;
@@ -316,6 +407,8 @@ protected:
 	std::vector<RegisterMapEntry> vertexattributes;
 	std::vector<RegisterMapEntry> fragmentregistermap;
 	std::vector<RegisterMapEntry> fragmentattributes;
+	std::vector<AGALInstruction> vertexinstructions;
+	std::vector<AGALInstruction> fragmentinstructions;
 public:
 	Program3D(Class_base* c):ASObject(c,T_OBJECT,SUBTYPE_PROGRAM3D),gpu_program(UINT32_MAX),vcPositionScale(UINT32_MAX){}
 	Program3D(Class_base* c,_NR<Context3D> _ct):ASObject(c,T_OBJECT,SUBTYPE_PROGRAM3D),context3D(_ct),gpu_program(UINT32_MAX),vcPositionScale(UINT32_MAX){}
@@ -326,6 +419,7 @@ public:
 class VertexBuffer3D: public ASObject
 {
 friend class Context3D;
+friend class SoftwareRenderer3D;
 protected:
 	Context3D* context;
 	uint32_t bufferID;
@@ -334,8 +428,14 @@ protected:
 	vector<float> data;
 	tiny_string bufferUsage;
 	bool upload_needed;
+	// range of vertices changed since the last upload
+	uint32_t uploadstart;
+	uint32_t uploadend;
+	uint32_t buffersize; // number of floats allocated in the GL buffer
+	// stores the values at startVertex and adds the vertices to the range that has to be uploaded
+	void setData(uint32_t startVertex, uint32_t count, const std::vector<float>& values);
 public:
-	VertexBuffer3D(Class_base* c):ASObject(c,T_OBJECT,SUBTYPE_VERTEXBUFFER3D),context(NULL),bufferID(UINT32_MAX),numVertices(0),data32PerVertex(0),upload_needed(false){}
+	VertexBuffer3D(Class_base* c):ASObject(c,T_OBJECT,SUBTYPE_VERTEXBUFFER3D),context(NULL),bufferID(UINT32_MAX),numVertices(0),data32PerVertex(0),upload_needed(false),uploadstart(UINT32_MAX),uploadend(0),buffersize(0){}
 	VertexBuffer3D(Class_base* c, Context3D* ctx,int _numVertices,int32_t _data32PerVertex,tiny_string _bufferUsage);
 	~VertexBuffer3D();
 	static void sinit(Class_base* c);
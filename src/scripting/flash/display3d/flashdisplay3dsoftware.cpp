@@ -0,0 +1,1237 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2017 Ludger Krämer <dbluelle@onlinehome.de>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "scripting/flash/display3d/flashdisplay3dsoftware.h"
+#include "scripting/flash/display/BitmapData.h"
+#include "scripting/flash/utils/ByteArray.h"
+#include "platforms/engineutils.h"
+#include "swf.h"
+#include <SDL2/SDL_cpuinfo.h>
+#include <cmath>
+#include <atomic>
+
+// number of rows rasterized by one thread at a time
+#define RASTER_BAND_HEIGHT 32
+// minimum w of a vertex after clipping, to avoid divisions by zero
+#define CLIP_EPSILON 1e-6f
+
+using namespace lightspark;
+
+namespace lightspark
+{
+/*
+ * The bands of one flush, shared by the calling thread and the worker jobs.
+ * It is refcounted, so jobs that only start after all bands are taken can exit without touching the renderer.
+ */
+class SoftwareRasterizerBatch
+{
+private:
+	SoftwareRenderer3D* renderer;
+	uint32_t height;
+	uint32_t numbands;
+	std::atomic<uint32_t> nextband;
+	std::atomic<uint32_t> finishedbands;
+	std::atomic<int32_t> refcount;
+public:
+	// signaled once the last band is finished
+	Semaphore done;
+	SoftwareRasterizerBatch(SoftwareRenderer3D* r, uint32_t _height)
+		:renderer(r),height(_height),numbands((_height+RASTER_BAND_HEIGHT-1)/RASTER_BAND_HEIGHT),nextband(0),finishedbands(0),refcount(1),done(0) {}
+	void incRef() { ++refcount; }
+	void decRef()
+	{
+		if (--refcount == 0)
+			delete this;
+	}
+	// rasterizes bands until all of them are taken
+	void run()
+	{
+		SoftwareRenderer3D::registerset regs;
+		while (true)
+		{
+			uint32_t band = nextband++;
+			if (band >= numbands)
+				break;
+			renderer->rasterizeBand(band*RASTER_BAND_HEIGHT,min(height,(band+1)*RASTER_BAND_HEIGHT),regs);
+			if (++finishedbands == numbands)
+				done.signal();
+		}
+	}
+};
+
+class SoftwareRasterizerJob: public IThreadJob
+{
+private:
+	SoftwareRasterizerBatch* batch;
+public:
+	SoftwareRasterizerJob(SoftwareRasterizerBatch* b):batch(b) { batch->incRef(); }
+	void execute() { batch->run(); }
+	void jobFence()
+	{
+		batch->decRef();
+		delete this;
+	}
+};
+}
+
+static float zeroregister[4] = { 0.0, 0.0, 0.0, 0.0 };
+
+static inline bool usesSource2(uint32_t opcode)
+{
+	switch (opcode)
+	{
+		case 0x01: // add
+		case 0x02: // sub
+		case 0x03: // mul
+		case 0x04: // div
+		case 0x06: // min
+		case 0x07: // max
+		case 0x0b: // pow
+		case 0x11: // crs
+		case 0x12: // dp3
+		case 0x13: // dp4
+		case 0x17: // m33
+		case 0x18: // m44
+		case 0x19: // m34
+		case 0x29: // sge
+		case 0x2a: // slt
+		case 0x2c: // seq
+		case 0x2d: // sne
+			return true;
+		default:
+			return false;
+	}
+}
+static inline uint32_t registerCount(RegisterType type, bool isVertexProgram)
+{
+	switch (type)
+	{
+		case RegisterType::ATTRIBUTE: return isVertexProgram ? CONTEXT3D_ATTRIBUTE_COUNT : 0;
+		case RegisterType::CONSTANT: return CONTEXT3D_PROGRAM_REGISTERS;
+		case RegisterType::TEMPORARY: return CONTEXT3D_TEMPORARY_COUNT;
+		case RegisterType::OUTPUT: return 1;
+		case RegisterType::VARYING: return CONTEXT3D_VARYING_COUNT;
+		case RegisterType::SAMPLER: return isVertexProgram ? 0 : CONTEXT3D_SAMPLER_COUNT;
+		default: return 0;
+	}
+}
+static inline void decodeSource(uint64_t v, AGALSourceRegister& sr)
+{
+	sr.indirect = ((v >> 63) & 1);
+	sr.indexcomponent = ((v >> 48) & 0x3);
+	sr.indextype = (RegisterType) ((v >> 40) & 0xF);
+	sr.type = (RegisterType) ((v >> 32) & 0xF);
+	uint32_t s = ((v >> 24) & 0xFF);
+	for (uint32_t i = 0; i < 4; i++)
+		sr.swizzle[i] = (s >> (i*2)) & 3;
+	if (sr.indirect)
+	{
+		// the register number is the base offset, the index register is stored in the lower bits
+		sr.n = ((v >> 16) & 0xFF);
+		sr.indexn = (v & 0xFFFF);
+	}
+	else
+	{
+		sr.n = (v & 0xFFFF);
+		sr.indexn = 0;
+	}
+}
+
+bool SoftwareRenderer3D::parseAGAL(ByteArray* agal, bool isVertexProgram, std::vector<AGALInstruction>& instructions)
+{
+	instructions.clear();
+	agal->setPosition(0);
+	uint8_t by;
+	if (!agal->readByte(by) || by != 0xA0)
+	{
+		LOG(LOG_NOT_IMPLEMENTED,"software renderer can only handle AGAL bytecode");
+		return false;
+	}
+	uint32_t version;
+	if (!agal->readUnsignedInt(version) || version != 1)
+	{
+		LOG(LOG_ERROR,"invalid version for AGAL:"<<version);
+		return false;
+	}
+	if (!agal->readByte(by) || by != 0xA1)
+	{
+		LOG(LOG_ERROR,"invalid shaderTypeID for AGAL:"<<hex<<(uint32_t)by);
+		return false;
+	}
+	agal->readByte(by);
+	while (agal->getPosition()+24 <= agal->getLength())
+	{
+		uint32_t opcode, dest, low, high;
+		agal->readUnsignedInt(opcode);
+		agal->readUnsignedInt(dest);
+		agal->readUnsignedInt(low);
+		agal->readUnsignedInt(high);
+		uint64_t source1 = ((uint64_t)high)<<32 | low;
+		agal->readUnsignedInt(low);
+		agal->readUnsignedInt(high);
+		uint64_t source2 = ((uint64_t)high)<<32 | low;
+
+		AGALInstruction ins;
+		ins.opcode = opcode;
+		ins.desttype = (RegisterType)((dest >> 24) & 0xF);
+		ins.destmask = (dest >> 16) & 0xF;
+		ins.destn = (dest & 0xFFFF);
+		decodeSource(source1,ins.source1);
+		decodeSource(source2,ins.source2);
+		if (opcode > 0x19 && opcode != 0x27 && opcode != 0x28 && opcode != 0x29 && opcode != 0x2a && opcode != 0x2c && opcode != 0x2d)
+		{
+			LOG(LOG_NOT_IMPLEMENTED,"software renderer: AGAL opcode not supported:"<<hex<<opcode);
+			return false;
+		}
+		if (opcode != 0x27 && (ins.desttype == RegisterType::ATTRIBUTE || ins.desttype == RegisterType::CONSTANT || ins.desttype == RegisterType::SAMPLER
+				|| (ins.desttype == RegisterType::VARYING && !isVertexProgram)
+				|| ins.destn >= registerCount(ins.desttype,isVertexProgram)))
+		{
+			LOG(LOG_ERROR,"AGAL: invalid destination register:"<<ins.desttype<<" "<<ins.destn);
+			return false;
+		}
+		if (!ins.source1.indirect && ins.source1.n >= registerCount(ins.source1.type,isVertexProgram))
+		{
+			LOG(LOG_ERROR,"AGAL: invalid source register:"<<ins.source1.type<<" "<<ins.source1.n);
+			return false;
+		}
+		if (opcode == 0x28) // tex
+		{
+			if (isVertexProgram)
+			{
+				LOG(LOG_ERROR,"AGAL: texture sampling in vertex program");
+				return false;
+			}
+			ins.sampler = SamplerRegister::parse(source2,isVertexProgram);
+			if (ins.sampler.n >= CONTEXT3D_SAMPLER_COUNT)
+			{
+				LOG(LOG_ERROR,"AGAL: invalid sampler:"<<ins.sampler.n);
+				return false;
+			}
+		}
+		else if (usesSource2(opcode) && !ins.source2.indirect && ins.source2.n >= registerCount(ins.source2.type,isVertexProgram))
+		{
+			LOG(LOG_ERROR,"AGAL: invalid source register:"<<ins.source2.type<<" "<<ins.source2.n);
+			return false;
+		}
+		instructions.push_back(ins);
+	}
+	return true;
+}
+
+static inline const float* readRegister(const float (*regs)[4], uint32_t count, uint32_t n)
+{
+	return n < count ? regs[n] : zeroregister;
+}
+SoftwareRenderer3D::SoftwareRenderer3D(Context3D *ctx):context(ctx),backbufferhasdepth(false),backbufferwidth(0),backbufferheight(0),texturehasdepth(false)
+  ,targetcolor(nullptr),targetdepth(nullptr),targetwidth(0),targetheight(0),programattributes(0),programvaryings(0)
+  ,blendsrc(BLEND_ONE),blenddst(BLEND_ZERO),depthfunc(LESS),depthmask(true),culling(FACE_NONE),colormask(0xf),fragmentconstantsdirty(true)
+  ,vertexcachegeneration(0),framewidth(0),frameheight(0),newframe(false),frametexture(UINT32_MAX),frameprogram(UINT32_MAX)
+{
+	for (uint32_t i = 0; i < CONTEXT3D_ATTRIBUTE_COUNT; i++)
+	{
+		vertexbufferoffsets[i] = 0;
+		vertexbufferformats[i] = FLOAT_4;
+	}
+}
+
+void SoftwareRenderer3D::handleRenderAction(renderaction& action)
+{
+	switch (action.action)
+	{
+		case RENDER_CLEAR:
+		{
+			drawcommand cmd;
+			cmd.isclear = true;
+			for (uint32_t i = 0; i < 4; i++)
+				cmd.clearcolor[i] = max(0.0f,min(1.0f,action.fdata[i]));
+			cmd.cleardepth = max(0.0f,min(1.0f,action.fdata[4]));
+			cmd.clearmask = action.udata2;
+			cmd.colormask = colormask;
+			commands.push_back(cmd);
+			delete[] action.fdata;
+			break;
+		}
+		case RENDER_CONFIGUREBACKBUFFER:
+			//action.udata1 = enableDepthAndStencil
+			//action.udata2 = width
+			//action.udata3 = height
+			flush();
+			backbufferhasdepth = action.udata1;
+			backbufferwidth = action.udata2;
+			backbufferheight = action.udata3;
+			backbuffer.assign(backbufferwidth*backbufferheight*4,0);
+			if (backbufferhasdepth)
+				backbufferdepth.assign(backbufferwidth*backbufferheight,1.0);
+			else
+				backbufferdepth.clear();
+			updateTarget();
+			break;
+		case RENDER_SETPROGRAM:
+		{
+			program = action.dataobject.cast<Program3D>();
+			if (program.isNull())
+				break;
+			// find out which attributes have to be fetched and how many varyings have to be interpolated
+			programattributes = 0;
+			programvaryings = 0;
+			for (auto it = program->vertexinstructions.begin(); it != program->vertexinstructions.end(); it++)
+			{
+				if (it->source1.type == RegisterType::ATTRIBUTE && !it->source1.indirect)
+					programattributes |= 1<<it->source1.n;
+				else if (it->source1.type == RegisterType::ATTRIBUTE || (it->source1.indirect && it->source1.indextype == RegisterType::ATTRIBUTE))
+					programattributes = (1<<CONTEXT3D_ATTRIBUTE_COUNT)-1;
+				if (usesSource2(it->opcode))
+				{
+					if (it->source2.type == RegisterType::ATTRIBUTE && !it->source2.indirect)
+						programattributes |= 1<<it->source2.n;
+					else if (it->source2.type == RegisterType::ATTRIBUTE || (it->source2.indirect && it->source2.indextype == RegisterType::ATTRIBUTE))
+						programattributes = (1<<CONTEXT3D_ATTRIBUTE_COUNT)-1;
+				}
+				if (it->desttype == RegisterType::VARYING)
+					programvaryings = max(programvaryings,it->destn+1);
+			}
+			break;
+		}
+		case RENDER_RENDERTOBACKBUFFER:
+			setRenderTarget(nullptr,false);
+			break;
+		case RENDER_TOTEXTURE:
+			//action.dataobject = TextureBase
+			//action.udata1 = enableDepthAndStencil
+			setRenderTarget(action.dataobject->as<TextureBase>(),action.udata1);
+			break;
+		case RENDER_DELETEPROGRAM:
+			if (program == action.dataobject)
+				program.reset();
+			break;
+		case RENDER_SETVERTEXBUFFER:
+			//action.dataobject = VertexBuffer3D
+			//action.udata1 = index
+			//action.udata2 = bufferOffset
+			//action.udata3 = format
+			vertexbuffers[action.udata1] = action.dataobject.cast<VertexBuffer3D>();
+			vertexbufferoffsets[action.udata1] = action.udata2;
+			vertexbufferformats[action.udata1] = (VERTEXBUFFER_FORMAT)action.udata3;
+			break;
+		case RENDER_DRAWTRIANGLES:
+		{
+			//action.dataobject = IndexBuffer3D
+			//action.udata1 = firstIndex
+			//action.udata2 = numTriangles
+			if (action.dataobject.isNull())
+				break;
+			IndexBuffer3D* buffer = action.dataobject->as<IndexBuffer3D>();
+			uint32_t count = (action.udata2 == UINT32_MAX) ? buffer->data.size() : (action.udata2 * 3);
+			if (uint64_t(count) + action.udata1 > buffer->data.size())
+			{
+				LOG(LOG_ERROR,"software renderer: drawTriangles exceeds index buffer:"<<action.udata1<<" "<<count<<" "<<buffer->data.size());
+				break;
+			}
+			drawTriangles(buffer,action.udata1,count);
+			break;
+		}
+		case RENDER_SETPROGRAMCONSTANTS_FROM_MATRIX:
+		case RENDER_SETPROGRAMCONSTANTS_FROM_VECTOR:
+			//action.udata2 = 1, if vertex constants, 0 if fragment constants
+			// fragment constants are copied for every draw call that uses them, so the old values are kept for the rasterizer
+			if (!action.udata2)
+				fragmentconstantsdirty = true;
+			context->setProgramConstants(action);
+			break;
+		case RENDER_SETTEXTUREAT:
+			//action.dataobject = TextureBase
+			//action.udata1 = sampler
+			textures[action.udata1] = action.dataobject.cast<TextureBase>();
+			break;
+		case RENDER_SETBLENDFACTORS:
+			blendsrc = (BLEND_FACTOR)action.udata1;
+			blenddst = (BLEND_FACTOR)action.udata2;
+			break;
+		case RENDER_SETDEPTHTEST:
+			depthmask = action.udata1;
+			depthfunc = (DEPTH_FUNCTION)action.udata2;
+			break;
+		case RENDER_SETCULLING:
+			culling = (TRIANGLE_FACE)action.udata1;
+			break;
+		case RENDER_SETSCISSORRECTANGLE:
+			// the scissor test is not enabled in the OpenGL renderer either
+			delete[] action.fdata;
+			break;
+		case RENDER_SETCOLORMASK:
+			colormask = action.udata1;
+			break;
+		case RENDER_DELETEBUFFER:
+		case RENDER_LOADTEXTURE:
+		case RENDER_LOADCUBETEXTURE:
+			// the rasterizer reads buffers and textures directly
+			break;
+	}
+}
+
+void SoftwareRenderer3D::setRenderTarget(TextureBase* tex, bool enabledepth)
+{
+	// the commands recorded so far are drawn into the previous target
+	flush();
+	if (tex)
+	{
+		tex->incRef();
+		targettexture = _MR(tex);
+	}
+	else
+		targettexture.reset();
+	texturehasdepth = enabledepth;
+	updateTarget();
+}
+
+void SoftwareRenderer3D::updateTarget()
+{
+	if (targettexture.isNull())
+	{
+		targetcolor = backbuffer.empty() ? nullptr : backbuffer.data();
+		targetdepth = backbufferhasdepth && !backbufferdepth.empty() ? backbufferdepth.data() : nullptr;
+		targetwidth = backbufferwidth;
+		targetheight = backbufferheight;
+		return;
+	}
+	TextureBase* tex = targettexture.getPtr();
+	// render textures are always stored as RGBA in the first mip level
+	if (tex->bitmaparray.empty())
+		tex->bitmaparray.resize(1);
+	uint32_t size = tex->width*tex->height*4;
+	if (!tex->hasalpha || tex->bitmaparray[0].size() != size)
+	{
+		tex->bitmaparray[0].assign(size,0);
+		tex->hasalpha = true;
+	}
+	tex->needrefresh = true;
+	targetcolor = size ? tex->bitmaparray[0].data() : nullptr;
+	targetwidth = tex->width;
+	targetheight = tex->height;
+	if (texturehasdepth)
+	{
+		if (texturedepth.size() != tex->width*tex->height)
+			texturedepth.assign(tex->width*tex->height,1.0);
+		targetdepth = texturedepth.data();
+	}
+	else
+		targetdepth = nullptr;
+}
+
+void SoftwareRenderer3D::shadeVertex(uint32_t index, registerset& regs, clipvertex& out)
+{
+	for (uint32_t i = 0; i < CONTEXT3D_ATTRIBUTE_COUNT; i++)
+	{
+		if (!(programattributes & (1<<i)))
+			continue;
+		float* attr = regs.attributes[i];
+		attr[0] = attr[1] = attr[2] = 0.0;
+		attr[3] = 1.0;
+		VertexBuffer3D* buffer = vertexbuffers[i].getPtr();
+		if (!buffer)
+			continue;
+		uint64_t pos = uint64_t(index)*buffer->data32PerVertex + vertexbufferoffsets[i];
+		switch (vertexbufferformats[i])
+		{
+			case BYTES_4:
+				if (pos < buffer->data.size())
+				{
+					// the bytes were uploaded into the float vector unchanged
+					uint8_t bytes[4];
+					memcpy(bytes,&buffer->data[pos],4);
+					for (uint32_t j = 0; j < 4; j++)
+						attr[j] = bytes[j]/255.0f;
+				}
+				break;
+			case FLOAT_4:
+				if (pos+3 < buffer->data.size())
+					attr[3] = buffer->data[pos+3];
+				// fall through
+			case FLOAT_3:
+				if (pos+2 < buffer->data.size())
+					attr[2] = buffer->data[pos+2];
+				// fall through
+			case FLOAT_2:
+				if (pos+1 < buffer->data.size())
+					attr[1] = buffer->data[pos+1];
+				// fall through
+			case FLOAT_1:
+				if (pos < buffer->data.size())
+					attr[0] = buffer->data[pos];
+				break;
+		}
+	}
+	memset(regs.output,0,sizeof(regs.output));
+	memset(regs.varyings,0,programvaryings*4*sizeof(float));
+	runProgram(program->vertexinstructions,regs,nullptr);
+	memcpy(out.pos,regs.output,sizeof(out.pos));
+	memcpy(out.varyings,regs.varyings,programvaryings*4*sizeof(float));
+}
+
+void SoftwareRenderer3D::drawTriangles(IndexBuffer3D* buffer, uint32_t firstindex, uint32_t count)
+{
+	if (program.isNull() || program->vertexinstructions.empty() || program->fragmentinstructions.empty()
+			|| !targetcolor || culling == FACE_FRONT_AND_BACK || count < 3)
+		return;
+	if (fragmentconstantsdirty)
+	{
+		fragmentconstantsnapshots.insert(fragmentconstantsnapshots.end(),context->fragmentConstants,context->fragmentConstants+CONTEXT3D_PROGRAM_REGISTERS);
+		fragmentconstantsdirty = false;
+	}
+	drawcommand cmd;
+	cmd.isclear = false;
+	cmd.program = program;
+	cmd.firstvertex = rastervertices.size();
+	cmd.vertexsize = 4+programvaryings*4;
+	cmd.fragmentconstants = fragmentconstantsnapshots.size()-CONTEXT3D_PROGRAM_REGISTERS;
+	for (uint32_t i = 0; i < CONTEXT3D_SAMPLER_COUNT; i++)
+		cmd.textures[i] = textures[i];
+	cmd.blendsrc = blendsrc;
+	cmd.blenddst = blenddst;
+	cmd.depthfunc = depthfunc;
+	cmd.depthmask = depthmask;
+	cmd.colormask = colormask;
+
+	// every vertex is only transformed once per draw call, even if it is used by several triangles
+	const uint16_t* indices = buffer->data.data()+firstindex;
+	uint16_t maxindex = 0;
+	for (uint32_t i = 0; i < count; i++)
+		maxindex = max(maxindex,indices[i]);
+	if (vertexcache.size() <= maxindex)
+	{
+		vertexcache.resize(maxindex+1);
+		vertexcachestamp.resize(maxindex+1,0);
+	}
+	if (++vertexcachegeneration == 0)
+	{
+		std::fill(vertexcachestamp.begin(),vertexcachestamp.end(),0);
+		vertexcachegeneration = 1;
+	}
+	registerset regs;
+	regs.constants = context->vertexConstants;
+	for (uint32_t i = 0; i+2 < count; i+=3)
+	{
+		const clipvertex* v[3];
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			uint16_t index = indices[i+j];
+			if (vertexcachestamp[index] != vertexcachegeneration)
+			{
+				shadeVertex(index,regs,vertexcache[index]);
+				vertexcachestamp[index] = vertexcachegeneration;
+			}
+			v[j] = &vertexcache[index];
+		}
+		addTriangle(v[0],v[1],v[2]);
+	}
+	cmd.numtriangles = (rastervertices.size()-cmd.firstvertex)/(cmd.vertexsize*3);
+	if (cmd.numtriangles)
+		commands.push_back(cmd);
+}
+
+// distance of a vertex in clip space to one of the clipping planes, negative if it is outside
+static inline float clipDistance(const float* pos, uint32_t plane)
+{
+	switch (plane)
+	{
+		case 0: return pos[3]-CLIP_EPSILON; // w > 0
+		case 1: return pos[2]; // z >= 0
+		case 2: return pos[3]-pos[2]; // z <= w
+		case 3: return pos[3]+pos[0]; // x >= -w
+		case 4: return pos[3]-pos[0]; // x <= w
+		case 5: return pos[3]+pos[1]; // y >= -w
+		default: return pos[3]-pos[1]; // y <= w
+	}
+}
+#define CLIP_PLANE_COUNT 7
+
+void SoftwareRenderer3D::addTriangle(const clipvertex* v0, const clipvertex* v1, const clipvertex* v2)
+{
+	// clip the triangle against the view volume (Sutherland-Hodgman), every plane adds at most one vertex
+	clipvertex clipped[2][3+CLIP_PLANE_COUNT];
+	const clipvertex* polygon[3+CLIP_PLANE_COUNT] = { v0, v1, v2 };
+	uint32_t count = 3;
+	uint32_t current = 0;
+	for (uint32_t plane = 0; plane < CLIP_PLANE_COUNT; plane++)
+	{
+		float dist[3+CLIP_PLANE_COUNT];
+		bool allinside = true;
+		bool alloutside = true;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			dist[i] = clipDistance(polygon[i]->pos,plane);
+			if (dist[i] < 0)
+				allinside = false;
+			else
+				alloutside = false;
+		}
+		if (alloutside)
+			return;
+		if (allinside)
+			continue;
+		uint32_t newcount = 0;
+		clipvertex* out = clipped[current];
+		for (uint32_t i = 0; i < count; i++)
+		{
+			uint32_t next = (i+1)%count;
+			if (dist[i] >= 0)
+				out[newcount++] = *polygon[i];
+			if ((dist[i] >= 0) != (dist[next] >= 0))
+			{
+				float t = dist[i]/(dist[i]-dist[next]);
+				clipvertex& v = out[newcount++];
+				for (uint32_t j = 0; j < 4; j++)
+					v.pos[j] = polygon[i]->pos[j] + t*(polygon[next]->pos[j]-polygon[i]->pos[j]);
+				for (uint32_t k = 0; k < programvaryings; k++)
+				{
+					for (uint32_t j = 0; j < 4; j++)
+						v.varyings[k][j] = polygon[i]->varyings[k][j] + t*(polygon[next]->varyings[k][j]-polygon[i]->varyings[k][j]);
+				}
+			}
+		}
+		count = newcount;
+		for (uint32_t i = 0; i < count; i++)
+			polygon[i] = &out[i];
+		current = 1-current;
+		if (count < 3)
+			return;
+	}
+
+	// project to screen coordinates, the varyings are divided by w for perspective correct interpolation
+	uint32_t vertexsize = 4+programvaryings*4;
+	float projected[3+CLIP_PLANE_COUNT][4+CONTEXT3D_VARYING_COUNT*4];
+	for (uint32_t i = 0; i < count; i++)
+	{
+		float invw = 1.0f/polygon[i]->pos[3];
+		float* p = projected[i];
+		p[0] = (polygon[i]->pos[0]*invw+1.0f)*0.5f*targetwidth;
+		p[1] = (1.0f-polygon[i]->pos[1]*invw)*0.5f*targetheight;
+		p[2] = polygon[i]->pos[2]*invw;
+		p[3] = invw;
+		for (uint32_t k = 0; k < programvaryings; k++)
+		{
+			for (uint32_t j = 0; j < 4; j++)
+				p[4+k*4+j] = polygon[i]->varyings[k][j]*invw;
+		}
+	}
+	for (uint32_t i = 1; i+1 < count; i++)
+	{
+		const float* a = projected[0];
+		const float* b = projected[i];
+		const float* c = projected[i+1];
+		// positive area means clockwise on screen, which is the front face
+		float area = (b[0]-a[0])*(c[1]-a[1])-(c[0]-a[0])*(b[1]-a[1]);
+		if (area == 0 || std::isnan(area))
+			continue;
+		if ((culling == FACE_FRONT && area > 0) || (culling == FACE_BACK && area < 0))
+			continue;
+		if (area < 0)
+			std::swap(b,c);
+		rastervertices.insert(rastervertices.end(),a,a+vertexsize);
+		rastervertices.insert(rastervertices.end(),b,b+vertexsize);
+		rastervertices.insert(rastervertices.end(),c,c+vertexsize);
+	}
+}
+
+void SoftwareRenderer3D::flush()
+{
+	if (commands.empty())
+		return;
+	if (targetcolor && targetwidth && targetheight)
+	{
+		uint32_t numbands = (targetheight+RASTER_BAND_HEIGHT-1)/RASTER_BAND_HEIGHT;
+		uint32_t numworkers = min(numbands,(uint32_t)max(1,SDL_GetCPUCount()));
+		// the bands are distributed dynamically, the current thread works on them too
+		// and only waits for bands still being rasterized by other threads, not for jobs that haven't started yet
+		SoftwareRasterizerBatch* batch = new SoftwareRasterizerBatch(this,targetheight);
+		for (uint32_t i = 1; i < numworkers; i++)
+			context->getSystemState()->addJob(new SoftwareRasterizerJob(batch));
+		batch->run();
+		batch->done.wait();
+		batch->decRef();
+	}
+	commands.clear();
+	rastervertices.clear();
+	fragmentconstantsnapshots.clear();
+	fragmentconstantsdirty = true;
+}
+
+void SoftwareRenderer3D::rasterizeBand(uint32_t y0, uint32_t y1, registerset& regs)
+{
+	for (auto it = commands.begin(); it != commands.end(); it++)
+	{
+		if (it->isclear)
+			clearBand(*it,y0,y1);
+		else
+			drawBand(*it,y0,y1,regs);
+	}
+}
+
+void SoftwareRenderer3D::clearBand(const drawcommand& cmd, uint32_t y0, uint32_t y1)
+{
+	if (cmd.clearmask & CLEARMASK::COLOR)
+	{
+		uint8_t color[4];
+		for (uint32_t i = 0; i < 4; i++)
+			color[i] = uint8_t(cmd.clearcolor[i]*255.0f+0.5f);
+		uint8_t* p = targetcolor+y0*targetwidth*4;
+		uint8_t* end = targetcolor+y1*targetwidth*4;
+		if (cmd.colormask == 0xf)
+		{
+			for (; p < end; p+=4)
+				memcpy(p,color,4);
+		}
+		else
+		{
+			for (; p < end; p+=4)
+			{
+				for (uint32_t i = 0; i < 4; i++)
+				{
+					if (cmd.colormask & (1<<i))
+						p[i] = color[i];
+				}
+			}
+		}
+	}
+	if ((cmd.clearmask & CLEARMASK::DEPTH) && targetdepth)
+		std::fill(targetdepth+y0*targetwidth,targetdepth+y1*targetwidth,cmd.cleardepth);
+}
+
+static inline bool depthTest(DEPTH_FUNCTION func, float z, float depth)
+{
+	switch (func)
+	{
+		case ALWAYS: return true;
+		case EQUAL: return z == depth;
+		case GREATER: return z > depth;
+		case GREATER_EQUAL: return z >= depth;
+		case LESS: return z < depth;
+		case LESS_EQUAL: return z <= depth;
+		case NEVER: return false;
+		case NOT_EQUAL: return z != depth;
+	}
+	return true;
+}
+static inline float blendFactor(BLEND_FACTOR factor, const float* src, const float* dst, uint32_t channel)
+{
+	switch (factor)
+	{
+		case BLEND_ONE: return 1.0;
+		case BLEND_ZERO: return 0.0;
+		case BLEND_SRC_ALPHA: return src[3];
+		case BLEND_SRC_COLOR: return src[channel];
+		case BLEND_DST_ALPHA: return dst[3];
+		case BLEND_DST_COLOR: return dst[channel];
+		case BLEND_ONE_MINUS_SRC_ALPHA: return 1.0f-src[3];
+		case BLEND_ONE_MINUS_SRC_COLOR: return 1.0f-src[channel];
+		case BLEND_ONE_MINUS_DST_ALPHA: return 1.0f-dst[3];
+		case BLEND_ONE_MINUS_DST_COLOR: return 1.0f-dst[channel];
+	}
+	return 1.0;
+}
+// top-left fill rule: pixels exactly on an edge are only drawn if the edge is a top or left edge, so shared edges are drawn once
+static inline bool isTopLeft(const float* a, const float* b)
+{
+	float dx = b[0]-a[0];
+	float dy = b[1]-a[1];
+	return dy < 0 || (dy == 0 && dx > 0);
+}
+static inline bool insideEdge(float w, bool topleft)
+{
+	return w > 0 || (w == 0 && topleft);
+}
+
+void SoftwareRenderer3D::drawBand(const drawcommand& cmd, uint32_t y0, uint32_t y1, registerset& regs)
+{
+	samplerdata samplers[CONTEXT3D_SAMPLER_COUNT];
+	for (uint32_t i = 0; i < CONTEXT3D_SAMPLER_COUNT; i++)
+		getSamplerData(cmd.textures[i].getPtr(),samplers[i]);
+	regs.constants = &fragmentconstantsnapshots[cmd.fragmentconstants];
+	const std::vector<AGALInstruction>& instructions = cmd.program->fragmentinstructions;
+	uint32_t numvaryings = (cmd.vertexsize-4)/4;
+	bool simpleblend = cmd.blendsrc == BLEND_ONE && cmd.blenddst == BLEND_ZERO;
+
+	const float* vertices = &rastervertices[cmd.firstvertex];
+	for (uint32_t t = 0; t < cmd.numtriangles; t++, vertices += cmd.vertexsize*3)
+	{
+		const float* a = vertices;
+		const float* b = vertices+cmd.vertexsize;
+		const float* c = vertices+cmd.vertexsize*2;
+		float miny = min(a[1],min(b[1],c[1]));
+		float maxy = max(a[1],max(b[1],c[1]));
+		if (maxy < y0 || miny >= y1)
+			continue;
+		float minx = min(a[0],min(b[0],c[0]));
+		float maxx = max(a[0],max(b[0],c[0]));
+		int32_t startx = max(0,int32_t(floorf(minx)));
+		int32_t endx = min(int32_t(targetwidth)-1,int32_t(ceilf(maxx)));
+		int32_t starty = max(int32_t(y0),int32_t(floorf(miny)));
+		int32_t endy = min(int32_t(y1)-1,int32_t(ceilf(maxy)));
+		if (startx > endx || starty > endy)
+			continue;
+		float invarea = 1.0f/((b[0]-a[0])*(c[1]-a[1])-(c[0]-a[0])*(b[1]-a[1]));
+		bool topleft0 = isTopLeft(b,c);
+		bool topleft1 = isTopLeft(c,a);
+		bool topleft2 = isTopLeft(a,b);
+		for (int32_t py = starty; py <= endy; py++)
+		{
+			float cy = py+0.5f;
+			float cx = startx+0.5f;
+			// edge functions at the first pixel of the row, they change linearly along the row
+			float w0 = (c[0]-b[0])*(cy-b[1])-(c[1]-b[1])*(cx-b[0]);
+			float w1 = (a[0]-c[0])*(cy-c[1])-(a[1]-c[1])*(cx-c[0]);
+			float w2 = (b[0]-a[0])*(cy-a[1])-(b[1]-a[1])*(cx-a[0]);
+			float dw0 = -(c[1]-b[1]);
+			float dw1 = -(a[1]-c[1]);
+			float dw2 = -(b[1]-a[1]);
+			uint8_t* pixel = targetcolor+(py*targetwidth+startx)*4;
+			float* depth = targetdepth ? targetdepth+py*targetwidth+startx : nullptr;
+			for (int32_t px = startx; px <= endx; px++, w0+=dw0, w1+=dw1, w2+=dw2, pixel+=4, depth+=(depth ? 1 : 0))
+			{
+				if (!insideEdge(w0,topleft0) || !insideEdge(w1,topleft1) || !insideEdge(w2,topleft2))
+					continue;
+				float l0 = w0*invarea;
+				float l1 = w1*invarea;
+				float l2 = w2*invarea;
+				float z = max(0.0f,min(1.0f,l0*a[2]+l1*b[2]+l2*c[2]));
+				// the depth test doesn't depend on the fragment program, so it is done before running it
+				if (depth && !depthTest(cmd.depthfunc,z,*depth))
+					continue;
+				float w = 1.0f/(l0*a[3]+l1*b[3]+l2*c[3]);
+				for (uint32_t k = 0; k < numvaryings; k++)
+				{
+					for (uint32_t j = 0; j < 4; j++)
+						regs.varyings[k][j] = (l0*a[4+k*4+j]+l1*b[4+k*4+j]+l2*c[4+k*4+j])*w;
+				}
+				memset(regs.output,0,sizeof(regs.output));
+				if (!runProgram(instructions,regs,samplers))
+					continue; // killed
+				if (depth && cmd.depthmask)
+					*depth = z;
+				float src[4];
+				for (uint32_t j = 0; j < 4; j++)
+					src[j] = max(0.0f,min(1.0f,regs.output[j]));
+				float result[4];
+				if (simpleblend)
+					memcpy(result,src,sizeof(result));
+				else
+				{
+					float dst[4];
+					for (uint32_t j = 0; j < 4; j++)
+						dst[j] = pixel[j]/255.0f;
+					for (uint32_t j = 0; j < 4; j++)
+						result[j] = max(0.0f,min(1.0f,src[j]*blendFactor(cmd.blendsrc,src,dst,j)+dst[j]*blendFactor(cmd.blenddst,src,dst,j)));
+				}
+				for (uint32_t j = 0; j < 4; j++)
+				{
+					if (cmd.colormask & (1<<j))
+						pixel[j] = uint8_t(result[j]*255.0f+0.5f);
+				}
+			}
+		}
+	}
+}
+
+void SoftwareRenderer3D::getSamplerData(TextureBase* tex, samplerdata& data)
+{
+	for (uint32_t i = 0; i < 6; i++)
+		data.faces[i] = nullptr;
+	data.width = data.height = 0;
+	data.bytesperpixel = 4;
+	if (!tex)
+		return;
+	data.width = tex->width;
+	data.height = tex->height;
+	data.bytesperpixel = tex->hasalpha ? 4 : 3;
+	uint32_t size = tex->width*tex->height*data.bytesperpixel;
+	// only the first mip level is used
+	if (tex->is<CubeTexture>())
+	{
+		uint32_t levels = tex->as<CubeTexture>()->max_miplevel;
+		for (uint32_t i = 0; i < 6; i++)
+		{
+			if (levels*i < tex->bitmaparray.size() && tex->bitmaparray[levels*i].size() >= size)
+				data.faces[i] = tex->bitmaparray[levels*i].data();
+		}
+	}
+	else if (tex->bitmaparray.size() && tex->bitmaparray[0].size() >= size)
+		data.faces[0] = tex->bitmaparray[0].data();
+}
+
+static inline int32_t texelCoordinate(float t, uint32_t size, bool repeat)
+{
+	if (std::isnan(t))
+		return 0;
+	if (repeat)
+		t -= floorf(t/size)*size;
+	int32_t i = int32_t(max(0.0f,min(float(size-1),t)));
+	return i;
+}
+static inline void fetchTexel(const uint8_t* data, uint32_t width, uint32_t bytesperpixel, int32_t x, int32_t y, float* result)
+{
+	const uint8_t* p = data+(y*width+x)*bytesperpixel;
+	result[0] = p[0]/255.0f;
+	result[1] = p[1]/255.0f;
+	result[2] = p[2]/255.0f;
+	result[3] = bytesperpixel == 4 ? p[3]/255.0f : 1.0f;
+}
+
+void SoftwareRenderer3D::sample(const samplerdata& sampler, const SamplerRegister& state, const float* coords, float* result)
+{
+	const uint8_t* data = sampler.faces[0];
+	float u = coords[0];
+	float v = coords[1];
+	bool repeatu = state.w == 1 || state.w == 3;
+	bool repeatv = state.w == 1 || state.w == 2;
+	if (state.d == 1)
+	{
+		// select the cube face by the major axis of the direction, same orientation as in OpenGL
+		float x = coords[0];
+		float y = coords[1];
+		float z = coords[2];
+		float ax = fabsf(x);
+		float ay = fabsf(y);
+		float az = fabsf(z);
+		float ma, sc, tc;
+		uint32_t face;
+		if (ax >= ay && ax >= az)
+		{
+			face = x >= 0 ? 0 : 1;
+			ma = ax;
+			sc = x >= 0 ? -z : z;
+			tc = -y;
+		}
+		else if (ay >= az)
+		{
+			face = y >= 0 ? 2 : 3;
+			ma = ay;
+			sc = x;
+			tc = y >= 0 ? z : -z;
+		}
+		else
+		{
+			face = z >= 0 ? 4 : 5;
+			ma = az;
+			sc = z >= 0 ? x : -x;
+			tc = -y;
+		}
+		data = sampler.faces[face];
+		u = ma > 0 ? (sc/ma+1.0f)*0.5f : 0.5f;
+		v = ma > 0 ? (tc/ma+1.0f)*0.5f : 0.5f;
+		repeatu = repeatv = false;
+	}
+	if (!data || !sampler.width || !sampler.height)
+	{
+		result[0] = result[1] = result[2] = 0.0;
+		result[3] = 1.0;
+		return;
+	}
+	float x = u*sampler.width;
+	float y = v*sampler.height;
+	if (state.f == 0)
+	{
+		fetchTexel(data,sampler.width,sampler.bytesperpixel,texelCoordinate(floorf(x),sampler.width,repeatu),texelCoordinate(floorf(y),sampler.height,repeatv),result);
+		return;
+	}
+	// bilinear filtering
+	x -= 0.5f;
+	y -= 0.5f;
+	float fx = floorf(x);
+	float fy = floorf(y);
+	float ix = x-fx;
+	float iy = y-fy;
+	int32_t x0 = texelCoordinate(fx,sampler.width,repeatu);
+	int32_t x1 = texelCoordinate(fx+1.0f,sampler.width,repeatu);
+	int32_t y0 = texelCoordinate(fy,sampler.height,repeatv);
+	int32_t y1 = texelCoordinate(fy+1.0f,sampler.height,repeatv);
+	float t00[4], t10[4], t01[4], t11[4];
+	fetchTexel(data,sampler.width,sampler.bytesperpixel,x0,y0,t00);
+	fetchTexel(data,sampler.width,sampler.bytesperpixel,x1,y0,t10);
+	fetchTexel(data,sampler.width,sampler.bytesperpixel,x0,y1,t01);
+	fetchTexel(data,sampler.width,sampler.bytesperpixel,x1,y1,t11);
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		float top = t00[i]+(t10[i]-t00[i])*ix;
+		float bottom = t01[i]+(t11[i]-t01[i])*ix;
+		result[i] = top+(bottom-top)*iy;
+	}
+}
+
+const float* SoftwareRenderer3D::sourceRegister(const registerset& regs, RegisterType type, uint32_t n)
+{
+	switch (type)
+	{
+		case RegisterType::ATTRIBUTE: return readRegister(regs.attributes,CONTEXT3D_ATTRIBUTE_COUNT,n);
+		case RegisterType::CONSTANT: return n < CONTEXT3D_PROGRAM_REGISTERS ? regs.constants[n].data : zeroregister;
+		case RegisterType::TEMPORARY: return readRegister(regs.temporaries,CONTEXT3D_TEMPORARY_COUNT,n);
+		case RegisterType::OUTPUT: return regs.output;
+		case RegisterType::VARYING: return readRegister(regs.varyings,CONTEXT3D_VARYING_COUNT,n);
+		default: return zeroregister;
+	}
+}
+void SoftwareRenderer3D::readSource(const registerset& regs, const AGALSourceRegister& s, uint32_t row, float* out)
+{
+	uint32_t n = s.n;
+	if (s.indirect)
+		n += int32_t(sourceRegister(regs,s.indextype,s.indexn)[s.indexcomponent]);
+	const float* r = sourceRegister(regs,s.type,n+row);
+	out[0] = r[s.swizzle[0]];
+	out[1] = r[s.swizzle[1]];
+	out[2] = r[s.swizzle[2]];
+	out[3] = r[s.swizzle[3]];
+}
+
+bool SoftwareRenderer3D::runProgram(const std::vector<AGALInstruction>& instructions, registerset& regs, const samplerdata* samplers)
+{
+	for (auto it = instructions.begin(); it != instructions.end(); it++)
+	{
+		const AGALInstruction& ins = *it;
+		float a[4], b[4], res[4];
+		readSource(regs,ins.source1,0,a);
+		// the matrix opcodes read the rows of source2 themselves
+		if (usesSource2(ins.opcode) && (ins.opcode < 0x17 || ins.opcode > 0x19))
+			readSource(regs,ins.source2,0,b);
+		switch (ins.opcode)
+		{
+			case 0x00: // mov
+				memcpy(res,a,sizeof(res));
+				break;
+			case 0x01: // add
+				for (uint32_t i = 0; i < 4; i++) res[i] = a[i]+b[i];
+				break;
+			case 0x02: // sub
+				for (uint32_t i = 0; i < 4; i++) res[i] = a[i]-b[i];
+				break;
+			case 0x03: // mul
+				for (uint32_t i = 0; i < 4; i++) res[i] = a[i]*b[i];
+				break;
+			case 0x04: // div
+				for (uint32_t i = 0; i < 4; i++) res[i] = a[i]/b[i];
+				break;
+			case 0x05: // rcp
+				for (uint32_t i = 0; i < 4; i++) res[i] = 1.0f/a[i];
+				break;
+			case 0x06: // min
+				for (uint32_t i = 0; i < 4; i++) res[i] = min(a[i],b[i]);
+				break;
+			case 0x07: // max
+				for (uint32_t i = 0; i < 4; i++) res[i] = max(a[i],b[i]);
+				break;
+			case 0x08: // frc
+				for (uint32_t i = 0; i < 4; i++) res[i] = a[i]-floorf(a[i]);
+				break;
+			case 0x09: // sqt
+				for (uint32_t i = 0; i < 4; i++) res[i] = sqrtf(a[i]);
+				break;
+			case 0x0a: // rsq
+				for (uint32_t i = 0; i < 4; i++) res[i] = 1.0f/sqrtf(a[i]);
+				break;
+			case 0x0b: // pow
+				for (uint32_t i = 0; i < 4; i++) res[i] = powf(a[i],b[i]);
+				break;
+			case 0x0c: // log
+				for (uint32_t i = 0; i < 4; i++) res[i] = log2f(a[i]);
+				break;
+			case 0x0d: // exp
+				for (uint32_t i = 0; i < 4; i++) res[i] = exp2f(a[i]);
+				break;
+			case 0x0e: // nrm
+			{
+				float len = sqrtf(a[0]*a[0]+a[1]*a[1]+a[2]*a[2]);
+				float f = len > 0 ? 1.0f/len : 0.0f;
+				res[0] = a[0]*f;
+				res[1] = a[1]*f;
+				res[2] = a[2]*f;
+				res[3] = 0.0;
+				break;
+			}
+			case 0x0f: // sin
+				for (uint32_t i = 0; i < 4; i++) res[i] = sinf(a[i]);
+				break;
+			case 0x10: // cos
+				for (uint32_t i = 0; i < 4; i++) res[i] = cosf(a[i]);
+				break;
+			case 0x11: // crs
+				res[0] = a[1]*b[2]-a[2]*b[1];
+				res[1] = a[2]*b[0]-a[0]*b[2];
+				res[2] = a[0]*b[1]-a[1]*b[0];
+				res[3] = 0.0;
+				break;
+			case 0x12: // dp3
+				res[0] = res[1] = res[2] = res[3] = a[0]*b[0]+a[1]*b[1]+a[2]*b[2];
+				break;
+			case 0x13: // dp4
+				res[0] = res[1] = res[2] = res[3] = a[0]*b[0]+a[1]*b[1]+a[2]*b[2]+a[3]*b[3];
+				break;
+			case 0x14: // abs
+				for (uint32_t i = 0; i < 4; i++) res[i] = fabsf(a[i]);
+				break;
+			case 0x15: // neg
+				for (uint32_t i = 0; i < 4; i++) res[i] = -a[i];
+				break;
+			case 0x16: // sat
+				for (uint32_t i = 0; i < 4; i++) res[i] = max(0.0f,min(1.0f,a[i]));
+				break;
+			case 0x17: // m33
+			case 0x18: // m44
+			case 0x19: // m34
+			{
+				// source2 is the first of 3 or 4 consecutive rows of the matrix
+				uint32_t rows = ins.opcode == 0x18 ? 4 : 3;
+				bool dot4 = ins.opcode != 0x17;
+				res[3] = 0.0;
+				for (uint32_t r = 0; r < rows; r++)
+				{
+					readSource(regs,ins.source2,r,b);
+					res[r] = a[0]*b[0]+a[1]*b[1]+a[2]*b[2];
+					if (dot4)
+						res[r] += a[3]*b[3];
+				}
+				break;
+			}
+			case 0x27: // kil
+				if (a[0] < 0 || a[1] < 0 || a[2] < 0 || a[3] < 0)
+					return false;
+				continue; // no destination register
+			case 0x28: // tex
+				if (samplers)
+					sample(samplers[ins.sampler.n],ins.sampler,a,res);
+				else
+				{
+					res[0] = res[1] = res[2] = 0.0;
+					res[3] = 1.0;
+				}
+				break;
+			case 0x29: // sge
+				for (uint32_t i = 0; i < 4; i++) res[i] = a[i] >= b[i] ? 1.0f : 0.0f;
+				break;
+			case 0x2a: // slt
+				for (uint32_t i = 0; i < 4; i++) res[i] = a[i] < b[i] ? 1.0f : 0.0f;
+				break;
+			case 0x2c: // seq
+				for (uint32_t i = 0; i < 4; i++) res[i] = a[i] == b[i] ? 1.0f : 0.0f;
+				break;
+			case 0x2d: // sne
+				for (uint32_t i = 0; i < 4; i++) res[i] = a[i] != b[i] ? 1.0f : 0.0f;
+				break;
+			default:
+				continue;
+		}
+		float* dest;
+		switch (ins.desttype)
+		{
+			case RegisterType::TEMPORARY: dest = regs.temporaries[ins.destn]; break;
+			case RegisterType::VARYING: dest = regs.varyings[ins.destn]; break;
+			default: dest = regs.output; break;
+		}
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			if (ins.destmask & (1<<i))
+				dest[i] = res[i];
+		}
+	}
+	return true;
+}
+
+void SoftwareRenderer3D::present()
+{
+	Locker l(context->rendermutex);
+	// the content of the backbuffer is undefined after present, so the buffers can be swapped
+	frame.swap(backbuffer);
+	framewidth = backbufferwidth;
+	frameheight = backbufferheight;
+	backbuffer.resize(backbufferwidth*backbufferheight*4);
+	newframe = true;
+	updateTarget();
+}
+
+static const char* framevertexshader =
+	"#version 120\n"
+	"attribute vec2 position;\n"
+	"varying vec2 texcoord;\n"
+	"void main() {\n"
+	"\ttexcoord = vec2(position.x+1.0,1.0-position.y)*0.5;\n"
+	"\tgl_Position = vec4(position,0.0,1.0);\n"
+	"}\n";
+static const char* framefragmentshader =
+	"#version 120\n"
+	"uniform sampler2D frame;\n"
+	"varying vec2 texcoord;\n"
+	"void main() {\n"
+	"\tgl_FragColor = texture2D(frame,texcoord);\n"
+	"}\n";
+
+bool SoftwareRenderer3D::renderFrame(EngineData* engineData)
+{
+	Locker l(context->rendermutex);
+	if (frame.empty() || !framewidth || !frameheight)
+		return false;
+	if (frameprogram == UINT32_MAX)
+		frameprogram = context->getProgram(engineData,framevertexshader,framefragmentshader);
+	if (frametexture == UINT32_MAX)
+		engineData->exec_glGenTextures(1,&frametexture);
+	engineData->exec_glActiveTexture_GL_TEXTURE0(0);
+	engineData->exec_glBindTexture_GL_TEXTURE_2D(frametexture);
+	if (newframe)
+	{
+		engineData->exec_glTexParameteri_GL_TEXTURE_2D_GL_TEXTURE_MIN_FILTER_GL_NEAREST();
+		engineData->exec_glTexParameteri_GL_TEXTURE_2D_GL_TEXTURE_MAG_FILTER_GL_NEAREST();
+		engineData->exec_glTexImage2D_GL_TEXTURE_2D_GL_UNSIGNED_BYTE(0,framewidth,frameheight,0,frame.data(),true);
+		newframe = false;
+	}
+	engineData->exec_glUseProgram(frameprogram);
+	engineData->exec_glUniform1i(engineData->exec_glGetUniformLocation(frameprogram,"frame"),0);
+	int32_t position = engineData->exec_glGetAttribLocation(frameprogram,"position");
+	engineData->exec_glBindBuffer_GL_ARRAY_BUFFER(0);
+	engineData->exec_glDisable_GL_DEPTH_TEST();
+	engineData->exec_glBlendFunc(BLEND_ONE,BLEND_ZERO);
+	float coords[] = { -1.0,-1.0, 1.0,-1.0, -1.0,1.0, 1.0,1.0 };
+	engineData->exec_glVertexAttribPointer(position,0,coords,FLOAT_2);
+	engineData->exec_glEnableVertexAttribArray(position);
+	engineData->exec_glDrawArrays_GL_TRIANGLE_STRIP(0,4);
+	engineData->exec_glDisableVertexAttribArray(position);
+	engineData->exec_glBindTexture_GL_TEXTURE_2D(0);
+	return true;
+}
+
+void SoftwareRenderer3D::drawToBitmapData(BitmapData* destination)
+{
+	_NR<BitmapContainer> pixels = destination->getBitmapContainer();
+	if (pixels.isNull() || backbuffer.empty())
+		return;
+	uint32_t width = min(backbufferwidth,(uint32_t)pixels->getWidth());
+	uint32_t height = min(backbufferheight,(uint32_t)pixels->getHeight());
+	bool transparent = destination->transparent;
+	for (uint32_t y = 0; y < height; y++)
+	{
+		const uint8_t* src = backbuffer.data()+y*backbufferwidth*4;
+		uint32_t* dst = (uint32_t*)(pixels->getData()+y*pixels->getStride());
+		for (uint32_t x = 0; x < width; x++, src+=4)
+		{
+			// BitmapContainer stores premultiplied ARGB, the color channels can't exceed alpha
+			uint32_t alpha = transparent ? src[3] : 0xff;
+			uint32_t r = min((uint32_t)src[0],alpha);
+			uint32_t g = min((uint32_t)src[1],alpha);
+			uint32_t b = min((uint32_t)src[2],alpha);
+			dst[x] = (alpha<<24) | (r<<16) | (g<<8) | b;
+		}
+	}
+	destination->notifyUsers();
+}
@@ -0,0 +1,161 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2017 Ludger Krämer <dbluelle@onlinehome.de>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+#ifndef FLASHDISPLAY3DSOFTWARE_H
+#define FLASHDISPLAY3DSOFTWARE_H
+
+#include "scripting/flash/display3d/flashdisplay3d.h"
+
+#define CONTEXT3D_VARYING_COUNT 10
+#define CONTEXT3D_TEMPORARY_COUNT 32
+
+namespace lightspark
+{
+class BitmapData;
+
+/*
+ * Renders the actions of a Context3D on the CPU by interpreting the AGAL bytecode directly.
+ * It is used if the "software" render mode is requested or no OpenGL engine is available.
+ * All actions are processed in the vm thread when the context is presented or drawn to a BitmapData:
+ * vertices are transformed, clipped and set up immediately, the triangles are collected and rasterized
+ * in horizontal bands by several threads when the frame is complete or the render target changes.
+ */
+class SoftwareRenderer3D
+{
+friend class SoftwareRasterizerBatch;
+private:
+	struct clipvertex
+	{
+		float pos[4];
+		float varyings[CONTEXT3D_VARYING_COUNT][4];
+	};
+	// registers of one program invocation
+	struct registerset
+	{
+		float attributes[CONTEXT3D_ATTRIBUTE_COUNT][4];
+		float temporaries[CONTEXT3D_TEMPORARY_COUNT][4];
+		float varyings[CONTEXT3D_VARYING_COUNT][4];
+		float output[4];
+		const constantregister* constants;
+	};
+	struct samplerdata
+	{
+		const uint8_t* faces[6]; // only faces[0] is used for 2d textures
+		uint32_t width;
+		uint32_t height;
+		uint32_t bytesperpixel;
+	};
+	struct drawcommand
+	{
+		bool isclear;
+		// clear
+		float clearcolor[4];
+		float cleardepth;
+		uint32_t clearmask;
+		// triangles
+		_NR<Program3D> program;
+		uint32_t firstvertex; // offset into rastervertices
+		uint32_t numtriangles;
+		uint32_t vertexsize; // number of floats per vertex: x,y,z,1/w followed by the varyings divided by w
+		uint32_t fragmentconstants; // offset into fragmentconstantsnapshots
+		_NR<TextureBase> textures[CONTEXT3D_SAMPLER_COUNT];
+		BLEND_FACTOR blendsrc;
+		BLEND_FACTOR blenddst;
+		DEPTH_FUNCTION depthfunc;
+		bool depthmask;
+		uint32_t colormask;
+	};
+	Context3D* context;
+
+	// render targets
+	std::vector<uint8_t> backbuffer; // RGBA
+	std::vector<float> backbufferdepth;
+	bool backbufferhasdepth;
+	uint32_t backbufferwidth;
+	uint32_t backbufferheight;
+	_NR<TextureBase> targettexture;
+	std::vector<float> texturedepth;
+	bool texturehasdepth;
+	uint8_t* targetcolor;
+	float* targetdepth; // nullptr if the target has no depth buffer
+	uint32_t targetwidth;
+	uint32_t targetheight;
+
+	// current state
+	_NR<Program3D> program;
+	uint32_t programattributes; // bitmask of the attributes read by the vertex program
+	uint32_t programvaryings; // number of varyings written by the vertex program
+	_NR<VertexBuffer3D> vertexbuffers[CONTEXT3D_ATTRIBUTE_COUNT];
+	uint32_t vertexbufferoffsets[CONTEXT3D_ATTRIBUTE_COUNT];
+	VERTEXBUFFER_FORMAT vertexbufferformats[CONTEXT3D_ATTRIBUTE_COUNT];
+	_NR<TextureBase> textures[CONTEXT3D_SAMPLER_COUNT];
+	BLEND_FACTOR blendsrc;
+	BLEND_FACTOR blenddst;
+	DEPTH_FUNCTION depthfunc;
+	bool depthmask;
+	TRIANGLE_FACE culling;
+	uint32_t colormask;
+	bool fragmentconstantsdirty;
+
+	// recorded commands, rasterized on flush
+	std::vector<drawcommand> commands;
+	std::vector<float> rastervertices;
+	std::vector<constantregister> fragmentconstantsnapshots;
+
+	// transformed vertices of the current drawTriangles call, indexed by vertex index
+	std::vector<clipvertex> vertexcache;
+	std::vector<uint32_t> vertexcachestamp;
+	uint32_t vertexcachegeneration;
+
+	// last presented frame, accessed by the render thread (protected by the rendermutex of the context)
+	std::vector<uint8_t> frame;
+	uint32_t framewidth;
+	uint32_t frameheight;
+	bool newframe;
+	uint32_t frametexture;
+	uint32_t frameprogram;
+
+	void setRenderTarget(TextureBase* tex, bool enabledepth);
+	void updateTarget();
+	void drawTriangles(IndexBuffer3D* buffer, uint32_t firstindex, uint32_t count);
+	void shadeVertex(uint32_t index, registerset& regs, clipvertex& out);
+	void addTriangle(const clipvertex* v0, const clipvertex* v1, const clipvertex* v2);
+	void rasterizeBand(uint32_t y0, uint32_t y1, registerset& regs);
+	void clearBand(const drawcommand& cmd, uint32_t y0, uint32_t y1);
+	void drawBand(const drawcommand& cmd, uint32_t y0, uint32_t y1, registerset& regs);
+	void getSamplerData(TextureBase* tex, samplerdata& data);
+	static const float* sourceRegister(const registerset& regs, RegisterType type, uint32_t n);
+	static void readSource(const registerset& regs, const AGALSourceRegister& s, uint32_t row, float* out);
+	static bool runProgram(const std::vector<AGALInstruction>& instructions, registerset& regs, const samplerdata* samplers);
+	static void sample(const samplerdata& sampler, const SamplerRegister& state, const float* coords, float* result);
+public:
+	SoftwareRenderer3D(Context3D* ctx);
+	// decodes AGAL bytecode for the interpreter, returns false if the bytecode is invalid or contains embedded GLSL
+	static bool parseAGAL(ByteArray* agal, bool isVertexProgram, std::vector<AGALInstruction>& instructions);
+	void handleRenderAction(renderaction& action);
+	// rasterizes all recorded commands into the current render target
+	void flush();
+	// makes the backbuffer available to the render thread
+	void present();
+	// draws the last presented frame, called in the render thread
+	bool renderFrame(EngineData* engineData);
+	void drawToBitmapData(BitmapData* destination);
+};
+
+}
+#endif // FLASHDISPLAY3DSOFTWARE_H
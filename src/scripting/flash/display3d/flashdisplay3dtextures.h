@@ -31,6 +31,7 @@ namespace lightspark
 class TextureBase: public EventDispatcher
 {
 friend class Context3D;
+friend class SoftwareRenderer3D;
 protected:
 	uint32_t textureID;
 	uint32_t width;
@@ -65,6 +66,7 @@ public:
 class CubeTexture: public TextureBase
 {
 	friend class Context3D;
+	friend class SoftwareRenderer3D;
 protected:
 	uint32_t max_miplevel;
 public:
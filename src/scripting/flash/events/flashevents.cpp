@@ -49,6 +49,15 @@ void Event::finalize()
 	target = asAtomHandler::invalidAtom;
 }
 
+void Event::recycle()
+{
+	assert(isLastRef());
+	defaultPrevented = false;
+	eventPhase = 0;
+	currentTarget.reset();
+	target = asAtomHandler::invalidAtom;
+}
+
 void Event::sinit(Class_base* c)
 {
 	CLASS_SETUP(c, ASObject, _constructor, CLASS_SEALED);
@@ -584,11 +593,10 @@ void EventDispatcher::buildTraits(ASObject* o)
 
 void EventDispatcher::dumpHandlers()
 {
-	std::map<tiny_string,list<listener> >::iterator it=handlers.begin();
-	for(;it!=handlers.end();++it)
+	for(auto it=handlers.begin();it!=handlers.end();++it)
 	{
 		for (auto it2 = it->second.begin();it2 != it->second.end(); it2++)
-			LOG(LOG_INFO, it->first<<":"<<asAtomHandler::toDebugString(it2->f));
+			LOG(LOG_INFO, getSystemState()->getStringFromUniqueId(it->first)<<":"<<asAtomHandler::toDebugString(it2->f));
 	}
 }
 
@@ -607,24 +615,22 @@ ASFUNCTIONBODY_ATOM(EventDispatcher,addEventListener)
 	if(argslen>=4)
 		priority=asAtomHandler::toInt(args[3]);
 
-	const tiny_string& eventName=asAtomHandler::toString(args[0],sys);
+	uint32_t eventNameID=asAtomHandler::toStringId(args[0],sys);
 
-	if(th->is<DisplayObject>() && (eventName=="enterFrame"
-				|| eventName=="exitFrame"
-				|| eventName=="frameConstructed") )
+	BROADCAST_EVENT broadcasttype;
+	if(th->is<DisplayObject>() && SystemState::getBroadcastEventType(eventNameID,broadcasttype))
 	{
 		th->incRef();
-		th->getSystemState()->registerFrameListener(_MR(th->as<DisplayObject>()));
+		th->getSystemState()->registerFrameListener(_MR(th->as<DisplayObject>()),broadcasttype);
 	}
 
 	{
 		Locker l(th->handlersMutex);
 		//Search if any listener is already registered for the event
-		list<listener>& listeners=th->handlers[eventName];
-		ASATOM_INCREF(args[1]);
+		vector<listener>& listeners=th->handlers[eventNameID];
 		const listener newListener(args[1], priority, useCapture);
 		//Ordered insertion
-		list<listener>::iterator insertionPoint=lower_bound(listeners.begin(),listeners.end(),newListener);
+		vector<listener>::iterator insertionPoint=lower_bound(listeners.begin(),listeners.end(),newListener);
 		// check if a listener that matches type, use_capture and function is already registered
 		if (insertionPoint != listeners.end() && (*insertionPoint).use_capture == newListener.use_capture)
 		{
@@ -633,16 +639,16 @@ ASFUNCTIONBODY_ATOM(EventDispatcher,addEventListener)
 			if (insertPointFunc == newfunc || (insertPointFunc->clonedFrom && insertPointFunc->clonedFrom == newfunc->clonedFrom && insertPointFunc->closure_this==newfunc->closure_this))
 				return; // don't register the same listener twice
 		}
+		ASATOM_INCREF(args[1]);
 		listeners.insert(insertionPoint,newListener);
 	}
-	th->eventListenerAdded(eventName);
+	th->eventListenerAdded(sys->getStringFromUniqueId(eventNameID));
 }
 
 ASFUNCTIONBODY_ATOM(EventDispatcher,_hasEventListener)
 {
 	EventDispatcher* th=asAtomHandler::as<EventDispatcher>(obj);
-	const tiny_string& eventName=asAtomHandler::toString(args[0],sys);
-	asAtomHandler::setBool(ret,th->hasEventListener(eventName));
+	asAtomHandler::setBool(ret,th->hasEventListener(asAtomHandler::toStringId(args[0],sys)));
 }
 
 ASFUNCTIONBODY_ATOM(EventDispatcher,removeEventListener)
@@ -654,7 +660,7 @@ ASFUNCTIONBODY_ATOM(EventDispatcher,removeEventListener)
 	if(!asAtomHandler::isString(args[0]) || !asAtomHandler::isFunction(args[1]))
 		throw RunTimeException("Type mismatch in EventDispatcher::removeEventListener");
 
-	const tiny_string& eventName=asAtomHandler::toString(args[0],sys);
+	uint32_t eventNameID=asAtomHandler::toStringId(args[0],sys);
 
 	bool useCapture=false;
 	if(argslen>=3)
@@ -662,14 +668,14 @@ ASFUNCTIONBODY_ATOM(EventDispatcher,removeEventListener)
 
 	{
 		Locker l(th->handlersMutex);
-		map<tiny_string, list<listener> >::iterator h=th->handlers.find(eventName);
+		auto h=th->handlers.find(eventNameID);
 		if(h==th->handlers.end())
 		{
 			LOG(LOG_CALLS,_("Event not found"));
 			return;
 		}
 
-		std::list<listener>::iterator it=find(h->second.begin(),h->second.end(),
+		std::vector<listener>::iterator it=find(h->second.begin(),h->second.end(),
 											make_pair(args[1],useCapture));
 		if(it!=h->second.end())
 		{
@@ -681,15 +687,12 @@ ASFUNCTIONBODY_ATOM(EventDispatcher,removeEventListener)
 	}
 
 	// Only unregister the enterFrame listener _after_ the handlers have been erased.
-	if(th->is<DisplayObject>() && (eventName=="enterFrame"
-					|| eventName=="exitFrame"
-					|| eventName=="frameConstructed")
-				&& (!th->hasEventListener("enterFrame")
-					&& !th->hasEventListener("exitFrame")
-					&& !th->hasEventListener("frameConstructed")) )
+	BROADCAST_EVENT broadcasttype;
+	if(th->is<DisplayObject>() && SystemState::getBroadcastEventType(eventNameID,broadcasttype)
+				&& !th->hasEventListener(eventNameID))
 	{
 		th->incRef();
-		th->getSystemState()->unregisterFrameListener(_MR(th->as<DisplayObject>()));
+		th->getSystemState()->unregisterFrameListener(_MR(th->as<DisplayObject>()),broadcasttype);
 	}
 }
 
@@ -753,14 +756,16 @@ void EventDispatcher::handleEvent(_R<Event> e)
 	check();
 	e->check();
 	Locker l(handlersMutex);
-	map<tiny_string, list<listener> >::iterator h=handlers.find(e->type);
+	if(handlers.empty())
+		return;
+	auto h=handlers.find(getSystemState()->getUniqueStringId(e->type));
 	if(h==handlers.end())
 		return;
 
-	LOG(LOG_CALLS, _("Handling event ") << h->first);
+	LOG(LOG_CALLS, _("Handling event ") << e->type);
 
 	//Create a temporary copy of the listeners, as the list can be modified during the calls
-	vector<listener> tmpListener(h->second.begin(),h->second.end());
+	vector<listener> tmpListener(h->second);
 	l.release();
 	// listeners may be removed during the call to a listener, so we have to incref them before the call
 	// TODO how to handle listeners that are removed during the call to a listener, should they really be executed anyway?
@@ -787,9 +792,14 @@ void EventDispatcher::handleEvent(_R<Event> e)
 }
 
 bool EventDispatcher::hasEventListener(const tiny_string& eventName)
+{
+	return hasEventListener(getSystemState()->getUniqueStringId(eventName));
+}
+
+bool EventDispatcher::hasEventListener(uint32_t eventNameID)
 {
 	Locker l(handlersMutex);
-	if(handlers.find(eventName)==handlers.end())
+	if(handlers.find(eventNameID)==handlers.end())
 		return false;
 	else
 		return true;
@@ -51,6 +51,8 @@ public:
 	static void sinit(Class_base*);
 	static void buildTraits(ASObject* o);
 	virtual void setTarget(asAtom t) {target = t; }
+	// resets the dispatch state, used when the engine sends an event it holds the only reference to again
+	void recycle();
 	ASFUNCTION_ATOM(_constructor);
 	ASFUNCTION_ATOM(_preventDefault);
 	ASFUNCTION_ATOM(_isDefaultPrevented);
@@ -363,7 +365,8 @@ class EventDispatcher: public ASObject, public IEventDispatcher
 {
 private:
 	Mutex handlersMutex;
-	std::map<tiny_string,std::list<listener> > handlers;
+	// listeners per event name id, sorted by priority
+	std::unordered_map<uint32_t,std::vector<listener> > handlers;
 	/*
 	 * This will be used when a target is passed to EventDispatcher constructor
 	 */
@@ -383,6 +386,7 @@ public:
 	void handleEvent(_R<Event> e);
 	void dumpHandlers();
 	bool hasEventListener(const tiny_string& eventName);
+	bool hasEventListener(uint32_t eventNameID);
 	virtual void defaultEventBehavior(_R<Event> e) {}
 	virtual void afterExecution(_R<Event> e) {}
 	ASFUNCTION_ATOM(_constructor);
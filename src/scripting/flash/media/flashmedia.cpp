@@ -28,6 +28,11 @@
 #include "scripting/argconv.h"
 #include <unistd.h>
 
+// time in milliseconds after which a SoundChannel continues decoding when the decoder had enough samples buffered
+#define SOUND_DECODE_INTERVAL 100
+// free frames left in the decoder queue when a decoding job ends
+#define SOUND_DECODER_QUEUE_RESERVE 16
+
 using namespace lightspark;
 using namespace std;
 
@@ -719,7 +724,8 @@ ASFUNCTIONBODY_GETTER_SETTER(SoundLoaderContext,checkPolicyFile);
 
 SoundChannel::SoundChannel(Class_base* c, _NR<StreamCache> _stream, AudioFormat _format, bool autoplay, StartSoundTag* _tag)
 	: EventDispatcher(c),stream(_stream),stopped(true),terminated(true),audioDecoder(nullptr),audioStream(nullptr),
-	format(_format),tag(_tag),oldVolume(-1.0),startTime(0),loopstogo(0),restartafterabort(false),soundTransform(_MR(Class<SoundTransform>::getInstanceS(c->getSystemState()))),
+	format(_format),tag(_tag),oldVolume(-1.0),oldPan(0.0),startTime(0),loopstogo(0),restartafterabort(false),
+	decodebuf(nullptr),decodeinput(nullptr),streamDecoder(nullptr),waitForFlush(true),flushingdecoder(false),yielded(false),parked(false),soundTransform(_MR(Class<SoundTransform>::getInstanceS(c->getSystemState()))),
 	leftPeak(1),rightPeak(1)
 {
 	subtype=SUBTYPE_SOUNDCHANNEL;
@@ -758,6 +764,10 @@ void SoundChannel::play(number_t starttime)
 		}
 		restartafterabort=true;
 		startTime = starttime;
+		mutex.unlock();
+		// a parked decoding job has to notice the restart
+		wakeDecoding();
+		return;
 	}
 	else
 	{
@@ -776,7 +786,7 @@ void SoundChannel::play(number_t starttime)
 		{
 			// Start playback
 			incRef();
-			getSystemState()->addJob(this);
+			getSystemState()->addSoundJob(this);
 			RELEASE_WRITE(stopped,false);
 			RELEASE_WRITE(terminated,false);
 		}
@@ -789,7 +799,7 @@ void SoundChannel::resume()
 	{
 		// Start playback
 		incRef();
-		getSystemState()->addJob(this);
+		getSystemState()->addSoundJob(this);
 		RELEASE_WRITE(stopped,false);
 		RELEASE_WRITE(terminated,false);
 	}
@@ -861,7 +871,14 @@ void SoundChannel::execute()
 {
 	while (true)
 	{
-		playStream();
+		if (!decodebuf)
+			beginStream();
+		if (!decodeStream())
+		{
+			// the decoder has enough samples, decoding continues in a later job
+			yielded=true;
+			return;
+		}
 		if (loopstogo)
 			loopstogo--;
 		else
@@ -871,17 +888,17 @@ void SoundChannel::execute()
 	}
 }
 
-void SoundChannel::playStream()
+void SoundChannel::beginStream()
 {
 	// ensure audio manager is initialized
 	getSystemState()->waitInitialized();
 	assert(!stream.isNull());
-	std::streambuf *sbuf = stream->createReader();
-	istream s(sbuf);
-	s.exceptions ( istream::failbit | istream::badbit );
+	decodebuf = stream->createReader();
+	decodeinput = new istream(decodebuf);
+	decodeinput->exceptions ( istream::failbit | istream::badbit );
 
-	bool waitForFlush=true;
-	StreamDecoder* streamDecoder=nullptr;
+	waitForFlush=true;
+	flushingdecoder=false;
 	{
 		mutex.lock();
 		if (audioStream)
@@ -891,25 +908,35 @@ void SoundChannel::playStream()
 		}
 		mutex.unlock();
 	}
+}
+
+bool SoundChannel::decodeStream()
+{
 	//We need to catch possible EOF and other error condition in the non reliable stream
 	try
 	{
 #ifdef ENABLE_LIBAVCODEC
-		streamDecoder=new FFMpegStreamDecoder(nullptr,this->getSystemState()->getEngineData(),s,&format,stream->hasTerminated() ? stream->getReceivedLength() : -1);
-		if(!streamDecoder->isValid())
-		{
-			LOG(LOG_ERROR,"invalid streamDecoder");
-			threadAbort();
-			restartafterabort=false;
-		}
-		else
+		if (streamDecoder==nullptr)
 		{
-			streamDecoder->jumpToPosition(this->startTime);
-			if (audioStream)
-				audioStream->setPlayedTime(this->startTime);
+			streamDecoder=new FFMpegStreamDecoder(nullptr,this->getSystemState()->getEngineData(),*decodeinput,&format,stream->hasTerminated() ? stream->getReceivedLength() : -1);
+			if(!streamDecoder->isValid())
+			{
+				LOG(LOG_ERROR,"invalid streamDecoder");
+				threadAbort();
+				restartafterabort=false;
+			}
+			else
+			{
+				streamDecoder->jumpToPosition(this->startTime);
+				if (audioStream)
+					audioStream->setPlayedTime(this->startTime);
+			}
 		}
-		while(!ACQUIRE_READ(stopped))
+		while(!flushingdecoder && !ACQUIRE_READ(stopped))
 		{
+			// leave some room, as a single packet may be decoded into more than one frame
+			if(audioDecoder && audioDecoder->getQueuedFrames() >= AUDIO_DECODER_QUEUE_SIZE-SOUND_DECODER_QUEUE_RESERVE)
+				return false;
 			bool decodingSuccess=streamDecoder->decodeNextFrame();
 			if(decodingSuccess==false)
 				break;
@@ -917,16 +944,26 @@ void SoundChannel::playStream()
 				audioDecoder=streamDecoder->audioDecoder;
 
 			if(audioStream==nullptr && audioDecoder && audioDecoder->isValid())
+			{
 				audioStream=getSystemState()->audioManager->createStream(audioDecoder,false,this,startTime,soundTransform ? soundTransform->volume : 1.0);
+				// new streams start centered
+				oldPan=0.0;
+			}
 
 			if(audioStream)
 			{
-				//TODO: use soundTransform->pan
 				if(soundTransform && soundTransform->volume != oldVolume)
 				{
 					audioStream->setVolume(soundTransform->volume);
 					oldVolume = soundTransform->volume;
 				}
+				// sound envelopes take precedence over the panning of the soundTransform
+				if(soundTransform && soundTransform->pan != oldPan && !(tag && tag->getSoundInfo()->HasEnvelope))
+				{
+					number_t pan = max(-1.0,min(1.0,soundTransform->pan));
+					audioStream->setPanning(pan > 0 ? (1.0-pan)*32768 : 32768, pan < 0 ? (1.0+pan)*32768 : 32768);
+					oldPan = soundTransform->pan;
+				}
 				checkEnvelope();
 			}
 			
@@ -949,16 +986,26 @@ void SoundChannel::playStream()
 	{
 		LOG(LOG_ERROR, _("Exception in reading SoundChannel: ")<<e.what());
 	}
-	if(waitForFlush)
+	if(waitForFlush && !threadAborting)
 	{
 		//Put the decoders in the flushing state and wait for the complete consumption of contents
 		if(streamDecoder && streamDecoder->audioDecoder)
 		{
-			streamDecoder->audioDecoder->setFlushing();
-			streamDecoder->audioDecoder->waitFlushed();
+			if (!flushingdecoder)
+			{
+				streamDecoder->audioDecoder->setFlushing();
+				flushingdecoder=true;
+			}
+			if (!streamDecoder->audioDecoder->isFlushed())
+				return false;
 		}
 	}
+	endStream(true);
+	return true;
+}
 
+void SoundChannel::endStream(bool dispatchComplete)
+{
 	{
 		mutex.lock();
 		audioDecoder=nullptr;
@@ -967,25 +1014,65 @@ void SoundChannel::playStream()
 		mutex.unlock();
 	}
 	delete streamDecoder;
-	delete sbuf;
-
-	if (!ACQUIRE_READ(stopped))
+	streamDecoder=nullptr;
+	delete decodeinput;
+	decodeinput=nullptr;
+	delete decodebuf;
+	decodebuf=nullptr;
+	flushingdecoder=false;
+
+	if (dispatchComplete && !ACQUIRE_READ(stopped))
 	{
 		incRef();
 		getVm(getSystemState())->addEvent(_MR(this),_MR(Class<Event>::getInstanceS(getSystemState(),"soundComplete")));
 	}
 }
 
+void SoundChannel::wakeDecoding()
+{
+	// only one of the timer and the callers of this can restart a parked job
+	if (parked.exchange(false))
+		getSystemState()->addSoundJob(this);
+}
+
+void SoundChannel::tick()
+{
+	wakeDecoding();
+}
+
+void SoundChannel::tickFence()
+{
+	// release the reference held by the timer
+	if (getVm(getSystemState()))
+		getVm(getSystemState())->addDeletableObject(this);
+	else
+		this->decRef();
+}
 
 void SoundChannel::jobFence()
 {
+	if (yielded)
+	{
+		yielded=false;
+		if (!getSystemState()->isShuttingDown())
+		{
+			// the reference of the job is kept while it is parked, the timer gets its own
+			RELEASE_WRITE(parked,true);
+			incRef();
+			getSystemState()->addWait(SOUND_DECODE_INTERVAL,this);
+			return;
+		}
+	}
+	// the job may have been aborted before the decoding pass was finished
+	if (decodebuf)
+		endStream(false);
 	mutex.lock();
 	RELEASE_WRITE(terminated,true);
 	if (restartafterabort && !getSystemState()->isShuttingDown())
 	{
 		restartafterabort=false;
 		incRef();
-		getSystemState()->addJob(this);
+		getSystemState()->addSoundJob(this);
 		RELEASE_WRITE(stopped,false);
 		RELEASE_WRITE(terminated,false);
 	}
@@ -1022,6 +1109,7 @@ void SoundChannel::threadAbort()
 		audioDecoder=nullptr;
 	}
 	mutex.unlock();
+	wakeDecoding();
 }
 void SoundChannel::checkEnvelope()
 {
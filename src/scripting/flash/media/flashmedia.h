@@ -89,7 +89,12 @@ public:
 	ASFUNCTION_ATOM(_constructor);
 };
 
-class SoundChannel : public EventDispatcher, public IThreadJob
+/*
+ * A SoundChannel decodes its data in short jobs on the sound threadpool.
+ * When the decoder has enough samples buffered, the job ends and is started again by a timer,
+ * so a playing sound doesn't occupy a thread of the pool while the mixer consumes its samples.
+ */
+class SoundChannel : public EventDispatcher, public IThreadJob, public ITickJob
 {
 private:
 	_NR<StreamCache> stream;
@@ -101,11 +106,24 @@ private:
 	AudioFormat format;
 	StartSoundTag* tag;
 	number_t oldVolume;
+	number_t oldPan;
 	void validateSoundTransform(_NR<SoundTransform>);
-	void playStream();
 	number_t startTime;
 	int32_t loopstogo;
 	bool restartafterabort;
+	// decoding state of the current pass, kept between the decoding jobs
+	std::streambuf* decodebuf;
+	std::istream* decodeinput;
+	StreamDecoder* streamDecoder;
+	bool waitForFlush;
+	bool flushingdecoder; // all data is decoded, the mixer still has to play the buffered samples
+	bool yielded; // execute() returned before the sound was finished
+	ACQUIRE_RELEASE_FLAG(parked); // waiting for the timer to start the next decoding job
+	void beginStream();
+	// returns false if decoding has to be continued in a later job
+	bool decodeStream();
+	void endStream(bool dispatchComplete);
+	void wakeDecoding();
 	void checkEnvelope();
 public:
 	SoundChannel(Class_base* c, _NR<StreamCache> stream=NullRef, AudioFormat format=AudioFormat(CODEC_NONE,0,0), bool autoplay=true,StartSoundTag* _tag=nullptr);
@@ -131,6 +149,9 @@ public:
 	void execute();
 	void jobFence();
 	void threadAbort();
+	//ITickJob interface
+	void tick();
+	void tickFence();
 };
 
 class Video: public DisplayObject
@@ -34,7 +34,7 @@ using namespace std;
 using namespace lightspark;
 
 URLStreamThread::URLStreamThread(_R<URLRequest> request, _R<URLStream> ldr, _R<ByteArray> bytes)
-  : DownloaderThreadBase(request, ldr.getPtr()), loader(ldr), data(bytes),streambuffer(NULL),timestamp_last_progress(0),bytes_total(0)
+  : DownloaderThreadBase(request, ldr.getPtr()), loader(ldr), data(bytes),streambuffer(NULL),bytes_total(0)
 {
 }
 
@@ -48,19 +48,13 @@ void URLStreamThread::setBytesLoaded(uint32_t b)
 	if(b>curlen && streambuffer)
 	{
 		data->append(streambuffer,b - curlen);
-		uint64_t cur=compat_get_thread_cputime_us();
-		if (cur > timestamp_last_progress+ 40*1000)
-		{
-			timestamp_last_progress = cur;
-			loader->incRef();
-			getVm(loader->getSystemState())->addEvent(loader,_MR(Class<ProgressEvent>::getInstanceS(loader->getSystemState(),b,bytes_total)));
-		}
+		loader->incRef();
+		getVm(loader->getSystemState())->addEvent(loader,_MR(Class<ProgressEvent>::getInstanceS(loader->getSystemState(),b,bytes_total)));
 	}
 }
 
 void URLStreamThread::execute()
 {
-	timestamp_last_progress = compat_get_thread_cputime_us();
 	assert(!downloader);
 
 	//TODO: support httpStatus
@@ -38,7 +38,6 @@ private:
 	_R<URLStream> loader;
 	_R<ByteArray> data;
 	std::streambuf *streambuffer;
-	uint64_t timestamp_last_progress;
 	uint32_t bytes_total;
 	void execute();
 public:
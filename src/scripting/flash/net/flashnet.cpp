@@ -421,7 +421,7 @@ void URLLoaderThread::execute()
 	}
 }
 
-URLLoader::URLLoader(Class_base* c):EventDispatcher(c),dataFormat("text"),data(),job(NULL),timestamp_last_progress(0)
+URLLoader::URLLoader(Class_base* c):EventDispatcher(c),dataFormat("text"),data(),job(NULL)
 {
 }
 
@@ -478,13 +478,9 @@ void URLLoader::setBytesTotal(uint32_t b)
 void URLLoader::setBytesLoaded(uint32_t b)
 {
 	bytesLoaded = b;
-	uint64_t cur=compat_get_thread_cputime_us();
-	if (cur > timestamp_last_progress+ 40*1000)
-	{
-		timestamp_last_progress = cur;
-		this->incRef();
-		getVm(getSystemState())->addEvent(_MR(this),_MR(Class<ProgressEvent>::getInstanceS(getSystemState(),b,bytesTotal)));
-	}
+	//The downloader already limits progress updates to one per frame
+	this->incRef();
+	getVm(getSystemState())->addEvent(_MR(this),_MR(Class<ProgressEvent>::getInstanceS(getSystemState(),b,bytesTotal)));
 }
 
 ASFUNCTIONBODY_ATOM(URLLoader,_constructor)
@@ -1952,6 +1948,9 @@ void NetStream::execute()
 				done = true;
 				continue;
 			}
+			//The decoder sizes its frame queue to hold at least the buffer time
+			if(streamDecoder->videoDecoder)
+				streamDecoder->videoDecoder->bufferTime=bufferTime;
 			bool decodingSuccess= bufferfull && streamDecoder->decodeNextFrame();
 			if(!decodingSuccess && bufferfull)
 			{
@@ -177,7 +177,6 @@ private:
 	_NR<ASObject> data;
 	Mutex spinlock;
 	URLLoaderThread *job;
-	uint64_t timestamp_last_progress;
 public:
 	URLLoader(Class_base* c);
 	void finalize();
@@ -1,17 +1,32 @@
 #include "scripting/flash/sampler/flashsampler.h"
 #include "scripting/toplevel/Array.h"
 #include "scripting/argconv.h"
+#include "scripting/abc.h"
+#include "scripting/class.h"
+#include "scripting/sampler.h"
+#include "scripting/toplevel/Integer.h"
 
 using namespace lightspark;
 
 Sample::Sample(Class_base* c):
-	ASObject(c)
+	ASObject(c),time(0)
 {
 }
 
 void Sample::sinit(Class_base* c)
 {
-	CLASS_SETUP_NO_CONSTRUCTOR(c, ASObject, CLASS_SEALED|CLASS_FINAL);
+	CLASS_SETUP_NO_CONSTRUCTOR(c, ASObject, CLASS_SEALED);
+	REGISTER_GETTER(c,time);
+	REGISTER_GETTER(c,stack);
+}
+ASFUNCTIONBODY_GETTER(Sample,time);
+ASFUNCTIONBODY_GETTER(Sample,stack);
+
+void Sample::finalize()
+{
+	ASObject::finalize();
+	time=0;
+	stack.reset();
 }
 
 
@@ -27,63 +42,120 @@ void DeleteObjectSample::sinit(Class_base* c)
 
 
 NewObjectSample::NewObjectSample(Class_base* c):
-	Sample(c)
+	Sample(c),id(0),size(0)
 {
 }
 
 void NewObjectSample::sinit(Class_base* c)
 {
 	CLASS_SETUP_NO_CONSTRUCTOR(c, Sample, CLASS_SEALED|CLASS_FINAL);
+	REGISTER_GETTER(c,id);
+	REGISTER_GETTER(c,type);
 	REGISTER_GETTER(c,object);
 	REGISTER_GETTER(c,size);
 }
-ASFUNCTIONBODY_GETTER_NOT_IMPLEMENTED(NewObjectSample,object);
-ASFUNCTIONBODY_GETTER_NOT_IMPLEMENTED(NewObjectSample,size);
+ASFUNCTIONBODY_GETTER(NewObjectSample,id);
+ASFUNCTIONBODY_GETTER(NewObjectSample,type);
+// objects are not tracked after construction, so this is always null (as for collected objects)
+ASFUNCTIONBODY_GETTER(NewObjectSample,object);
+ASFUNCTIONBODY_GETTER(NewObjectSample,size);
+
+void NewObjectSample::finalize()
+{
+	Sample::finalize();
+	id=0;
+	size=0;
+	type.reset();
+	object.reset();
+}
 
 StackFrame::StackFrame(Class_base* c):
-	ASObject(c)
+	ASObject(c),line(0),scriptID(0)
 {
 }
 
 void StackFrame::sinit(Class_base* c)
 {
 	CLASS_SETUP_NO_CONSTRUCTOR(c, ASObject, CLASS_SEALED|CLASS_FINAL);
+	REGISTER_GETTER(c,name);
+	REGISTER_GETTER(c,file);
+	REGISTER_GETTER(c,line);
+	REGISTER_GETTER(c,scriptID);
 	c->setDeclaredMethodByQName("toString","",Class<IFunction>::getFunction(c->getSystemState(),_toString),NORMAL_METHOD,true);
 }
+ASFUNCTIONBODY_GETTER(StackFrame,name);
+ASFUNCTIONBODY_GETTER(StackFrame,file);
+ASFUNCTIONBODY_GETTER(StackFrame,line);
+ASFUNCTIONBODY_GETTER(StackFrame,scriptID);
+
 ASFUNCTIONBODY_ATOM(StackFrame,_toString)
 {
-	LOG(LOG_NOT_IMPLEMENTED,"flash.sampler.stackFrame.toString not implemented");
-	ret = asAtomHandler::fromStringID(BUILTIN_STRINGS::EMPTY);
+	StackFrame* th=asAtomHandler::as<StackFrame>(obj);
+	tiny_string res=th->name;
+	res+="()";
+	if(!th->file.empty())
+	{
+		res+="[";
+		res+=th->file;
+		res+=":";
+		res+=Integer::toString(th->line);
+		res+="]";
+	}
+	ret = asAtomHandler::fromObject(abstract_s(sys,res));
+}
+
+static Array* stackToArray(SystemState* sys, const Sampler* sampler, const std::vector<uint32_t>& stack)
+{
+	Array* res=Class<Array>::getInstanceSNoArgs(sys);
+	for(auto it=stack.begin();it!=stack.end();++it)
+	{
+		StackFrame* frame=Class<StackFrame>::getInstanceSNoArgs(sys);
+		frame->name=sampler->getFrameName(*it);
+		res->push(asAtomHandler::fromObject(frame));
+	}
+	return res;
+}
+
+/* the sampler only counts calls by function name, so getters and setters share their counts with methods */
+static uint32_t invocationCount(SystemState* sys, _NR<ASObject> o, _NR<ASQName> qname)
+{
+	Sampler* sampler=getVm(sys)->sampler;
+	if(sampler==nullptr)
+		return 0;
+	if(!qname.isNull())
+		return sampler->getInvocationCount(qname->getLocalName());
+	if(!o.isNull() && o->is<IFunction>())
+		return sampler->getInvocationCount(o->as<IFunction>()->functionname);
+	return 0;
 }
 
 
 ASFUNCTIONBODY_ATOM(lightspark,clearSamples)
 {
-	LOG(LOG_NOT_IMPLEMENTED,"flash.sampler.clearSamples not implemented");
+	Sampler* sampler=getVm(sys)->sampler;
+	if(sampler)
+		sampler->clearSamples();
 }
 ASFUNCTIONBODY_ATOM(lightspark,getGetterInvocationCount)
 {
 	_NR<ASObject> o;
 	_NR<ASQName> qname;
 	ARG_UNPACK_ATOM (o)(qname);
-	LOG(LOG_NOT_IMPLEMENTED,"flash.sampler.getGetterInvocationCount not implemented");
-	asAtomHandler::setInt(ret,sys,0);
+	asAtomHandler::setNumber(ret,sys,invocationCount(sys,o,qname));
 }
 ASFUNCTIONBODY_ATOM(lightspark,getInvocationCount)
 {
 	_NR<ASObject> o;
 	_NR<ASQName> qname;
 	ARG_UNPACK_ATOM (o)(qname);
-	LOG(LOG_NOT_IMPLEMENTED,"flash.sampler.getInvocationCount not implemented");
-	asAtomHandler::setInt(ret,sys,0);
+	asAtomHandler::setNumber(ret,sys,invocationCount(sys,o,qname));
 }
 ASFUNCTIONBODY_ATOM(lightspark,getSetterInvocationCount)
 {
 	_NR<ASObject> o;
 	_NR<ASQName> qname;
 	ARG_UNPACK_ATOM (o)(qname);
-	LOG(LOG_NOT_IMPLEMENTED,"flash.sampler.getSetterInvocationCount not implemented");
-	asAtomHandler::setInt(ret,sys,0);
+	asAtomHandler::setNumber(ret,sys,invocationCount(sys,o,qname));
 }
 ASFUNCTIONBODY_ATOM(lightspark,getLexicalScopes)
 {
@@ -110,13 +182,36 @@ ASFUNCTIONBODY_ATOM(lightspark,getMemberNames)
 }
 ASFUNCTIONBODY_ATOM(lightspark,getSampleCount)
 {
-	LOG(LOG_NOT_IMPLEMENTED,"flash.sampler.getSampleCount not implemented");
-	asAtomHandler::setInt(ret,sys,-1);
+	Sampler* sampler=getVm(sys)->sampler;
+	asAtomHandler::setNumber(ret,sys,sampler ? sampler->getSamples().size() : 0);
 }
 ASFUNCTIONBODY_ATOM(lightspark,getSamples)
 {
-	LOG(LOG_NOT_IMPLEMENTED,"flash.sampler.getSamples not implemented");
-	asAtomHandler::setUndefined(ret);
+	Sampler* sampler=getVm(sys)->sampler;
+	Array* res=Class<Array>::getInstanceSNoArgs(sys);
+	if(sampler)
+	{
+		const std::vector<Sampler::SampleData>& samples=sampler->getSamples();
+		for(auto it=samples.begin();it!=samples.end();++it)
+		{
+			Sample* sample;
+			if(it->type)
+			{
+				NewObjectSample* newSample=Class<NewObjectSample>::getInstanceSNoArgs(sys);
+				newSample->id=it->id;
+				newSample->size=it->size;
+				it->type->incRef();
+				newSample->type=_MNR(it->type);
+				sample=newSample;
+			}
+			else
+				sample=Class<Sample>::getInstanceSNoArgs(sys);
+			sample->time=it->time;
+			sample->stack=_MNR(stackToArray(sys,sampler,it->stack));
+			res->push(asAtomHandler::fromObject(sample));
+		}
+	}
+	ret = asAtomHandler::fromObject(res);
 }
 
 ASFUNCTIONBODY_ATOM(lightspark,getSize)
@@ -143,7 +238,14 @@ ASFUNCTIONBODY_ATOM(lightspark,isGetterSetter)
 }
 ASFUNCTIONBODY_ATOM(lightspark,pauseSampling)
 {
-	LOG(LOG_NOT_IMPLEMENTED,"flash.sampler.pauseSampling not implemented");
+	Sampler* sampler=getVm(sys)->sampler;
+	if(sampler)
+	{
+		sampler->setRecordSamples(false);
+		//Keep sampling when the stacks are collected for the output file
+		if(!sampler->hasOutputFile())
+			sampler->stop();
+	}
 	ret = asAtomHandler::undefinedAtom;
 }
 ASFUNCTIONBODY_ATOM(lightspark,sampleInternalAllocs)
@@ -158,10 +260,19 @@ ASFUNCTIONBODY_ATOM(lightspark,setSamplerCallback)
 }
 ASFUNCTIONBODY_ATOM(lightspark,startSampling)
 {
-	LOG(LOG_NOT_IMPLEMENTED,"flash.sampler.startSampling not implemented");
+	Sampler* sampler=getVm(sys)->getSampler();
+	sampler->setRecordSamples(true);
+	sampler->start();
 }
 ASFUNCTIONBODY_ATOM(lightspark,stopSampling)
 {
-	LOG(LOG_NOT_IMPLEMENTED,"flash.sampler.stopSampling not implemented");
+	Sampler* sampler=getVm(sys)->sampler;
+	if(sampler)
+	{
+		sampler->setRecordSamples(false);
+		sampler->clearSamples();
+		if(!sampler->hasOutputFile())
+			sampler->stop();
+	}
 }
 
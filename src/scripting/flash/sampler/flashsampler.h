@@ -30,6 +30,9 @@ class Sample : public ASObject
 public:
 	Sample(Class_base* c);
 	static void sinit(Class_base*);
+	void finalize() override;
+	ASPROPERTY_GETTER(number_t,time);
+	ASPROPERTY_GETTER(_NR<Array>,stack);
 };
 
 class DeleteObjectSample : public Sample
@@ -43,6 +46,9 @@ class NewObjectSample : public Sample
 public:
 	NewObjectSample(Class_base* c);
 	static void sinit(Class_base*);
+	void finalize() override;
+	ASPROPERTY_GETTER(number_t,id);
+	ASPROPERTY_GETTER(_NR<ASObject>,type);
 	ASPROPERTY_GETTER(_NR<ASObject>,object);
 	ASPROPERTY_GETTER(number_t,size);
 };
@@ -51,6 +57,10 @@ class StackFrame : public ASObject
 public:
 	StackFrame(Class_base* c);
 	static void sinit(Class_base*);
+	ASPROPERTY_GETTER(tiny_string,name);
+	ASPROPERTY_GETTER(tiny_string,file);
+	ASPROPERTY_GETTER(uint32_t,line);
+	ASPROPERTY_GETTER(number_t,scriptID);
 	ASFUNCTION_ATOM(_toString);
 };
 
@@ -91,21 +91,25 @@ public:
 	ASFUNCTION_ATOM(getDefinition);
 	ASPROPERTY_GETTER_SETTER(_NR<ByteArray>, domainMemory);
 	ASPROPERTY_GETTER(_NR<ApplicationDomain>, parentDomain);
+	// returns a pointer to sizeof(T) bytes of domain memory at addr, the check also covers addresses near UINT32_MAX
 	template<class T>
-	T readFromDomainMemory(uint32_t addr)
+	FORCE_INLINE uint8_t* getDomainMemoryPtr(uint32_t addr)
 	{
-		if(currentDomainMemory->getLength() < (addr+sizeof(T)))
+		if(uint64_t(addr)+sizeof(T) > currentDomainMemory->getLength())
 			throwError<RangeError>(kInvalidRangeError);
-		uint8_t* buf=currentDomainMemory->getBufferNoCheck();
-		return *reinterpret_cast<T*>(buf+addr);
+		return currentDomainMemory->getBufferNoCheck()+addr;
 	}
 	template<class T>
-	void writeToDomainMemory(uint32_t addr, T val)
+	FORCE_INLINE T readFromDomainMemory(uint32_t addr)
 	{
-		if(currentDomainMemory->getLength() < (addr+sizeof(T)))
-			throwError<RangeError>(kInvalidRangeError);
-		uint8_t* buf=currentDomainMemory->getBufferNoCheck();
-		*reinterpret_cast<T*>(buf+addr)=val;
+		T ret;
+		memcpy(&ret,getDomainMemoryPtr<T>(addr),sizeof(T));
+		return ret;
+	}
+	template<class T>
+	FORCE_INLINE void writeToDomainMemory(uint32_t addr, T val)
+	{
+		memcpy(getDomainMemoryPtr<T>(addr),&val,sizeof(T));
 	}
 	void checkDomainMemory();
 };
@@ -125,7 +125,7 @@ uint8_t* ByteArray::getBufferIntern(unsigned int size, bool enableResize)
 	if (size > BA_MAX_SIZE) 
 		throwError<ASError>(kOutOfMemoryError);
 	// The first allocation is exactly the size we need,
-	// the subsequent reallocations happen in increments of BA_CHUNK_SIZE bytes
+	// the subsequent reallocations grow the buffer by half its size, at least by BA_CHUNK_SIZE bytes
 	uint32_t prevLen = len;
 	if(bytes==nullptr)
 	{
@@ -146,9 +146,9 @@ uint8_t* ByteArray::getBufferIntern(unsigned int size, bool enableResize)
 #ifdef MEMORY_USAGE_PROFILING
 		uint32_t prev_real_len = real_len;
 #endif
-		while(real_len < size)
-			real_len += BA_CHUNK_SIZE;
-		// Reallocate the buffer, in chunks of BA_CHUNK_SIZE bytes
+		// grow geometrically, so that writing a large ByteArray piecewise is not quadratic
+		real_len = std::min(std::max(size,real_len+std::max(real_len/2,(uint32_t)BA_CHUNK_SIZE)),(uint32_t)BA_MAX_SIZE);
+		// Reallocate the buffer
 		uint8_t* bytes2 = (uint8_t*) realloc(bytes, real_len);
 #ifdef MEMORY_USAGE_PROFILING
 		getClass()->memoryAccount->addBytes(real_len-prev_real_len);
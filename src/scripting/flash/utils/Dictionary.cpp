@@ -29,9 +29,44 @@
 using namespace std;
 using namespace lightspark;
 
+Mutex Dictionary::weakKeysMutex;
+std::unordered_multimap<const ASObject*,Dictionary*> Dictionary::weakKeyOwners;
+
 Dictionary::Dictionary(Class_base* c):ASObject(c),
-	data(std::less<dictType::key_type>(), reporter_allocator<dictType::value_type>(c->memoryAccount)),weakkeys(false)
+	entries(reporter_allocator<Entry>(c->memoryAccount)),slots(reporter_allocator<uint32_t>(c->memoryAccount)),
+	freeEntries(reporter_allocator<uint32_t>(c->memoryAccount)),count(0),usedSlots(0),weakkeys(false)
+{
+}
+
+bool Dictionary::destruct()
+{
+	clearEntries();
+	weakkeys=false;
+	return destructIntern();
+}
+
+void Dictionary::finalize()
+{
+	clearEntries();
+	ASObject::finalize();
+}
+
+void Dictionary::clearEntries()
 {
+	//Detach the entries first, releasing keys and values may cause other objects to access this dictionary
+	std::vector<Entry,reporter_allocator<Entry>> oldEntries(entries.get_allocator());
+	oldEntries.swap(entries);
+	slots.clear();
+	freeEntries.clear();
+	count=0;
+	usedSlots=0;
+	for(auto it=oldEntries.begin();it!=oldEntries.end();++it)
+	{
+		if(it->key==nullptr)
+			continue;
+		releaseKey(it->key);
+		ASATOM_DECREF(it->value);
+	}
 }
 
 void Dictionary::sinit(Class_base* c)
@@ -55,16 +90,143 @@ ASFUNCTIONBODY_ATOM(Dictionary,_toJSON)
 	ret = asAtomHandler::fromString(sys,"Dictionary");
 }
 
-Dictionary::dictType::iterator Dictionary::findKey(ASObject *o)
+uint32_t Dictionary::findSlot(const ASObject* o) const
+{
+	if(slots.empty())
+		return UINT32_MAX;
+	uint32_t mask=slots.size()-1;
+	uint32_t i=hashKey(o,mask);
+	while(true)
+	{
+		uint32_t e=slots[i];
+		if(e==EMPTY_SLOT)
+			return UINT32_MAX;
+		if(e!=REMOVED_SLOT && entries[e].key==o)
+			return i;
+		i=(i+1)&mask;
+	}
+}
+
+/*
+ * Rebuilds the hash table and drops the removed slots.
+ * The entries are not moved, as a for..in loop may be iterating over their indexes
+ */
+void Dictionary::rehash(uint32_t newSize)
+{
+	slots.assign(newSize,EMPTY_SLOT);
+	uint32_t mask=newSize-1;
+	for(uint32_t e=0;e<entries.size();e++)
+	{
+		if(entries[e].key==nullptr)
+			continue;
+		uint32_t i=hashKey(entries[e].key,mask);
+		while(slots[i]!=EMPTY_SLOT)
+			i=(i+1)&mask;
+		slots[i]=e;
+	}
+	usedSlots=count;
+}
+
+/*
+ * The caller must have checked that the key is not already in the dictionary
+ * and it must pass the reference to the key if the keys are not weak
+ */
+void Dictionary::insertKey(ASObject* o, asAtom& value)
 {
-	Dictionary::dictType::iterator it = data.begin();
-	for(; it!=data.end(); ++it)
+	//Keep at least a quarter of the slots empty, removed slots are only dropped by rehash
+	if((usedSlots+1)*4>slots.size()*3)
+	{
+		uint32_t newSize=16;
+		while(newSize*3<(count+1)*4*2)
+			newSize*=2;
+		rehash(newSize);
+	}
+	uint32_t mask=slots.size()-1;
+	uint32_t i=hashKey(o,mask);
+	while(slots[i]!=EMPTY_SLOT)
+		i=(i+1)&mask;
+	Entry e;
+	e.key=o;
+	e.value=value;
+	//Fill a hole if there is one, a running for..in loop may or may not visit the new key
+	if(!freeEntries.empty())
+	{
+		slots[i]=freeEntries.back();
+		entries[freeEntries.back()]=e;
+		freeEntries.pop_back();
+	}
+	else
 	{
-		if (it->first->isEqualStrict(o))
-			return it;
+		slots[i]=entries.size();
+		entries.push_back(e);
 	}
+	usedSlots++;
+	count++;
+	if(weakkeys)
+	{
+		Locker l(weakKeysMutex);
+		weakKeyOwners.insert(make_pair(o,this));
+		o->setWeakDictionaryKey();
+	}
+}
 
-	return data.end();
+void Dictionary::removeSlot(uint32_t slot, bool release)
+{
+	Entry& e=entries[slots[slot]];
+	ASObject* key=e.key;
+	asAtom value=e.value;
+	e.key=nullptr;
+	e.value=asAtomHandler::invalidAtom;
+	freeEntries.push_back(slots[slot]);
+	slots[slot]=REMOVED_SLOT;
+	count--;
+	if(release)
+		releaseKey(key);
+	ASATOM_DECREF(value);
+}
+
+void Dictionary::releaseKey(ASObject* o)
+{
+	if(!weakkeys)
+	{
+		o->decRef();
+		return;
+	}
+	Locker l(weakKeysMutex);
+	auto range=weakKeyOwners.equal_range(o);
+	for(auto it=range.first;it!=range.second;++it)
+	{
+		if(it->second==this)
+		{
+			weakKeyOwners.erase(it);
+			break;
+		}
+	}
+}
+
+void Dictionary::removeWeakKey(ASObject* o)
+{
+	uint32_t slot=findSlot(o);
+	if(slot!=UINT32_MAX)
+		removeSlot(slot,false);
+}
+
+void Dictionary::weakKeyDestroyed(ASObject* o)
+{
+	//Removing an entry may destroy other dictionaries, so look up the owners one at a time
+	while(true)
+	{
+		Dictionary* owner;
+		{
+			Locker l(weakKeysMutex);
+			auto it=weakKeyOwners.find(o);
+			if(it==weakKeyOwners.end())
+				return;
+			owner=it->second;
+			weakKeyOwners.erase(it);
+		}
+		owner->removeWeakKey(o);
+	}
 }
 
 void Dictionary::setVariableByMultiname_i(multiname& name, int32_t value)
@@ -103,22 +265,25 @@ multiname *Dictionary::setVariableByMultiname(multiname& name, asAtom& o, CONST_
 			default:
 				break;
 		}
-		name.name_o->incRef();
-		_R<ASObject> name_o(name.name_o);
-
-		Dictionary::dictType::iterator it=findKey(name_o.getPtr());
-		if(it!=data.end())
+		uint32_t slot=findSlot(name.name_o);
+		if(slot!=UINT32_MAX)
 		{
-			if (alreadyset && it->second.uintval == o.uintval)
+			Entry& e=entries[slots[slot]];
+			if (alreadyset && e.value.uintval == o.uintval)
 				*alreadyset=true;
 			else
 			{
-				ASATOM_DECREF(it->second);
-				it->second=o;
+				asAtom oldvalue=e.value;
+				e.value=o;
+				ASATOM_DECREF(oldvalue);
 			}
 		}
 		else
-			data.insert(make_pair(name_o,o));
+		{
+			if(!weakkeys)
+				name.name_o->incRef();
+			insertKey(name.name_o,o);
+		}
 	}
 	else
 	{
@@ -163,14 +328,10 @@ bool Dictionary::deleteVariableByMultiname(const multiname& name)
 			default:
 				break;
 		}
-		name.name_o->incRef();
-		_R<ASObject> name_o(name.name_o);
-
-		Dictionary::dictType::iterator it=findKey(name_o.getPtr());
-		if(it != data.end())
+		uint32_t slot=findSlot(name.name_o);
+		if(slot!=UINT32_MAX)
 		{
-			ASATOM_DECREF(it->second);
-			data.erase(it);
+			removeSlot(slot,true);
 			return true;
 		}
 		return false;
@@ -217,26 +378,13 @@ GET_VARIABLE_RESULT Dictionary::getVariableByMultiname(asAtom& ret, const multin
 				default:
 					break;
 			}
-			bool islastref = name.name_o->isLastRef();
-			name.name_o->incRef();
-			_R<ASObject> name_o(name.name_o);
-
-			Dictionary::dictType::iterator it=findKey(name_o.getPtr());
-			if(it != data.end())
+			uint32_t slot=findSlot(name.name_o);
+			if(slot!=UINT32_MAX)
 			{
-				ret = it->second;
-				if (islastref)
-				{
-					LOG(LOG_INFO,"erasing weak key from dictionary:"<< name.name_o->toDebugString());
-					name.name_o->decRef();
-					data.erase(it);
-				}
-				else
-					ASATOM_INCREF(ret);
-				return GET_VARIABLE_RESULT::GETVAR_NORMAL;
+				ret = entries[slots[slot]].value;
+				ASATOM_INCREF(ret);
 			}
-			else
-				return GET_VARIABLE_RESULT::GETVAR_NORMAL;
+			return GET_VARIABLE_RESULT::GETVAR_NORMAL;
 		}
 		else
 		{
@@ -291,11 +439,7 @@ bool Dictionary::hasPropertyByMultiname(const multiname& name, bool considerDyna
 				break;
 		}
 
-		name.name_o->incRef();
-		_R<ASObject> name_o(name.name_o);
-
-		Dictionary::dictType::iterator it=findKey(name_o.getPtr());
-		return it != data.end();
+		return findSlot(name.name_o)!=UINT32_MAX;
 	}
 	else
 	{
@@ -312,54 +456,57 @@ bool Dictionary::hasPropertyByMultiname(const multiname& name, bool considerDyna
 uint32_t Dictionary::nextNameIndex(uint32_t cur_index)
 {
 	assert_and_throw(implEnable);
-	if(cur_index<data.size())
-		return cur_index+1;
-	else
+	uint32_t size=entries.size();
+	for(uint32_t i=cur_index;i<size;i++)
 	{
-		//Fall back on object properties
-		uint32_t ret=ASObject::nextNameIndex(cur_index-data.size());
-		if(ret==0)
-			return 0;
-		else
-			return ret+data.size();
-
+		if(entries[i].key)
+			return i+1;
 	}
+	//Fall back on object properties
+	uint32_t ret=ASObject::nextNameIndex(cur_index<size ? 0 : cur_index-size);
+	if(ret==0)
+		return 0;
+	else
+		return ret+size;
 }
 
 void Dictionary::nextName(asAtom& ret,uint32_t index)
 {
 	assert_and_throw(implEnable);
-	if(index<=data.size())
+	if(index<=entries.size())
 	{
-		auto it=data.begin();
-		for(unsigned int i=1;i<index;i++)
-			++it;
-		it->first->incRef();
-		ret = asAtomHandler::fromObject(it->first.getPtr());
+		//The entry may have been removed while iterating
+		ASObject* key=entries[index-1].key;
+		if(key)
+		{
+			key->incRef();
+			ret = asAtomHandler::fromObject(key);
+		}
+		else
+			asAtomHandler::setUndefined(ret);
 	}
 	else
 	{
 		//Fall back on object properties
-		ASObject::nextName(ret,index-data.size());
+		ASObject::nextName(ret,index-entries.size());
 	}
 }
 
 void Dictionary::nextValue(asAtom& ret,uint32_t index)
 {
 	assert_and_throw(implEnable);
-	if(index<=data.size())
+	if(index<=entries.size())
 	{
-		auto it=data.begin();
-		for(unsigned int i=1;i<index;i++)
-			++it;
-
-		ASATOM_INCREF(it->second);
-		ret = it->second;
+		ret = entries[index-1].value;
+		if(asAtomHandler::isInvalid(ret))
+			asAtomHandler::setUndefined(ret);
+		else
+			ASATOM_INCREF(ret);
 	}
 	else
 	{
 		//Fall back on object properties
-		ASObject::nextValue(ret,index-data.size());
+		ASObject::nextValue(ret,index-entries.size());
 	}
 }
 
@@ -367,13 +514,15 @@ tiny_string Dictionary::toString()
 {
 	std::stringstream retstr;
 	retstr << "{";
-	auto it=data.begin();
-	while(it != data.end())
+	bool first=true;
+	for(auto it=entries.begin();it!=entries.end();++it)
 	{
-		if(it != data.begin())
+		if(it->key==nullptr)
+			continue;
+		if(!first)
 			retstr << ", ";
-		retstr << "{" << it->first->toString() << ", " << asAtomHandler::toString(it->second,getSystemState()) << "}";
-		++it;
+		first=false;
+		retstr << "{" << it->key->toString() << ", " << asAtomHandler::toString(it->value,getSystemState()) << "}";
 	}
 	retstr << "}";
 
@@ -404,16 +553,15 @@ void Dictionary::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stri
 		//Add the dictionary to the map
 		objMap.insert(make_pair(this, objMap.size()));
 
+		//Count only live entries, the indices may skip removed keys
 		uint32_t count = 0;
-		uint32_t tmp;
-		while ((tmp = nextNameIndex(count)) != 0)
-		{
-			count = tmp;
-		}
+		uint32_t tmp = 0;
+		while ((tmp = nextNameIndex(tmp)) != 0)
+			count++;
 		assert_and_throw(count<0x20000000);
 		uint32_t value = (count << 1) | 1;
 		out->writeU29(value);
-		out->writeByte(0x00); // TODO handle weak keys
+		out->writeByte(weakkeys ? 0x01 : 0x00);
 		
 		tmp = 0;
 		while ((tmp = nextNameIndex(tmp)) != 0)
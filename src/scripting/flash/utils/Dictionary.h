@@ -22,6 +22,7 @@
 
 #include "compat.h"
 #include "swftypes.h"
+#include <unordered_map>
 
 
 namespace lightspark
@@ -31,24 +32,49 @@ class Dictionary: public ASObject
 {
 friend class ABCVm;
 private:
-	typedef std::map<_R<ASObject>,asAtom,std::less<_R<ASObject>>,
-	       reporter_allocator<std::pair<const _R<ASObject>, asAtom>>> dictType;
-	dictType data;
-	dictType::iterator findKey(ASObject *);
+	/*
+	 * Object keys are stored in insertion order in entries, slots is an open addressing
+	 * hash table (linear probing) of indexes into entries, keyed by object identity.
+	 * Removed entries leave a hole (key==nullptr) so that indexes used by for..in stay
+	 * valid, entries are never moved. Holes are reused by later insertions.
+	 * Primitive keys are handled by the normal ASObject dynamic properties.
+	 */
+	struct Entry
+	{
+		ASObject* key;
+		asAtom value;
+	};
+	std::vector<Entry,reporter_allocator<Entry>> entries;
+	std::vector<uint32_t,reporter_allocator<uint32_t>> slots;
+	//Indexes of the holes in entries
+	std::vector<uint32_t,reporter_allocator<uint32_t>> freeEntries;
+	uint32_t count;
+	uint32_t usedSlots;
 	bool weakkeys;
-public:
-	Dictionary(Class_base* c);
-	bool destruct() override
+	static const uint32_t EMPTY_SLOT=UINT32_MAX;
+	static const uint32_t REMOVED_SLOT=UINT32_MAX-1;
+	//Maps weak keys to the dictionaries containing them
+	static Mutex weakKeysMutex;
+	static std::unordered_multimap<const ASObject*,Dictionary*> weakKeyOwners;
+	static uint32_t hashKey(const ASObject* o, uint32_t mask)
 	{
-		Dictionary::dictType::iterator it = data.begin();
-		while(it!=data.end())
-		{
-			ASATOM_DECREF(it->second);
-			it++;
-		}
-		data.clear();
-		return destructIntern();
+		uint64_t h=uint64_t(uintptr_t(o))*UINT64_C(0x9E3779B97F4A7C15);
+		return uint32_t(h>>32)&mask;
 	}
+	//Returns the slot containing the key or UINT32_MAX
+	uint32_t findSlot(const ASObject* o) const;
+	void insertKey(ASObject* o, asAtom& value);
+	void removeSlot(uint32_t slot, bool releaseKey);
+	void rehash(uint32_t newSize);
+	void releaseKey(ASObject* o);
+	void removeWeakKey(ASObject* o);
+	void clearEntries();
+public:
+	Dictionary(Class_base* c);
+	bool destruct() override;
+	void finalize() override;
+	//Called when an object used as weak key is destroyed
+	static void weakKeyDestroyed(ASObject* o);
 	
 	static void sinit(Class_base*);
 	static void buildTraits(ASObject* o);
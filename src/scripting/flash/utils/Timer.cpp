@@ -33,8 +33,13 @@ void Timer::tick()
 {
 	//This will be executed once if repeatCount was originally 1
 	//Otherwise it's executed until stopMe is set to true
+	if (!timerEvent.isNull() && timerEvent->isLastRef())
+		timerEvent->recycle();
+	else
+		timerEvent = _MNR(Class<TimerEvent>::getInstanceS(getSystemState(),"timer"));
 	this->incRef();
-	getVm(getSystemState())->addEvent(_MR(this),_MR(Class<TimerEvent>::getInstanceS(getSystemState(),"timer")));
+	timerEvent->incRef();
+	getVm(getSystemState())->addEvent(_MR(this),_MR(timerEvent.getPtr()));
 
 	currentCount++;
 	if(repeatCount!=0)
@@ -54,6 +59,12 @@ void Timer::tickFence()
 	tickJobInstance = NullRef;
 }
 
+void Timer::finalize()
+{
+	EventDispatcher::finalize();
+	timerEvent.reset();
+}
+
 
 void Timer::sinit(Class_base* c)
 {
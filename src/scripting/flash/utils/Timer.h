@@ -39,6 +39,8 @@ private:
 	//tickJobInstance keeps a reference to self while this
 	//instance is being used by the timer thread.
 	_NR<Timer> tickJobInstance;
+	//the timer event is sent again on the next tick if no one else kept a reference to it
+	_NR<TimerEvent> timerEvent;
 protected:
 	bool running;
 	uint32_t delay;
@@ -46,6 +48,7 @@ protected:
 	uint32_t currentCount;
 public:
 	Timer(Class_base* c):EventDispatcher(c),running(false),delay(0),repeatCount(0),currentCount(0){}
+	void finalize() override;
 	static void sinit(Class_base* c);
 	ASFUNCTION_ATOM(_constructor);
 	ASFUNCTION_ATOM(_getCurrentCount);
@@ -0,0 +1,139 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2026  Lightspark Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "scripting/sampler.h"
+#include "scripting/abc.h"
+#include "scripting/class.h"
+#include "swf.h"
+#include <fstream>
+#include <glib.h>
+
+using namespace std;
+using namespace lightspark;
+
+Sampler::Sampler(SystemState* s, uint32_t intervalMs):sys(s),pending(0),running(false),recordSamples(false),
+	interval(intervalMs),startTime(g_get_monotonic_time()),nextObjectId(1)
+{
+}
+
+Sampler::~Sampler()
+{
+	stop();
+}
+
+void Sampler::start()
+{
+	if(running)
+		return;
+	running=true;
+	RELEASE_WRITE(pending,0);
+	sys->addTick(interval,this);
+}
+
+void Sampler::stop()
+{
+	if(!running)
+		return;
+	running=false;
+	sys->removeJob(this);
+}
+
+void Sampler::tick()
+{
+	RELEASE_WRITE(pending,1);
+}
+
+void Sampler::captureStack(ABCVm* vm, std::vector<uint32_t>& stack)
+{
+	stack.reserve(vm->cur_recursion);
+	for (uint32_t i = vm->cur_recursion; i > 0; i--)
+	{
+		const ABCVm::stacktrace_entry& e=vm->stacktrace[i-1];
+		const Class_base* c=asAtomHandler::getClass(const_cast<asAtom&>(e.object),sys);
+		auto key=make_pair(c,e.name);
+		auto it=frameIds.find(key);
+		if(it==frameIds.end())
+		{
+			tiny_string name=c ? c->getQualifiedClassName() : tiny_string("global");
+			name+="/";
+			name+=sys->getStringFromUniqueId(e.name);
+			it=frameIds.insert(make_pair(key,uint32_t(frameNames.size()))).first;
+			frameNames.push_back(name);
+		}
+		stack.push_back(it->second);
+	}
+}
+
+void Sampler::takeSample(ABCVm* vm)
+{
+	SampleData s;
+	s.time=g_get_monotonic_time()-startTime;
+	s.type=nullptr;
+	s.id=0;
+	s.size=0;
+	captureStack(vm,s.stack);
+	if(!outputFile.empty())
+		stackCounts[s.stack]++;
+	if(recordSamples)
+		samples.push_back(std::move(s));
+}
+
+void Sampler::objectConstructed(ABCVm* vm, Class_base* type, uint32_t size)
+{
+	if(!recordSamples)
+		return;
+	SampleData s;
+	s.time=g_get_monotonic_time()-startTime;
+	s.type=type;
+	s.id=nextObjectId++;
+	s.size=size;
+	captureStack(vm,s.stack);
+	samples.push_back(std::move(s));
+}
+
+uint32_t Sampler::getInvocationCount(uint32_t name) const
+{
+	auto it=invocations.find(name);
+	return it==invocations.end() ? 0 : it->second;
+}
+
+void Sampler::writeOutput()
+{
+	if(outputFile.empty())
+		return;
+	ofstream f(outputFile.raw_buf(), ios_base::out | ios_base::trunc);
+	if(!f)
+	{
+		LOG(LOG_ERROR,"Sampler: unable to write " << outputFile);
+		return;
+	}
+	//One line per distinct stack, outermost frame first, followed by the number of samples
+	for(auto it=stackCounts.begin();it!=stackCounts.end();++it)
+	{
+		const vector<uint32_t>& stack=it->first;
+		for(uint32_t i=stack.size();i>0;i--)
+		{
+			f << frameNames[stack[i-1]];
+			if(i>1)
+				f << ';';
+		}
+		f << ' ' << it->second << '\n';
+	}
+	LOG(LOG_INFO,"Sampler: " << stackCounts.size() << " stacks written to " << outputFile);
+}
@@ -0,0 +1,114 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2026  Lightspark Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef SCRIPTING_SAMPLER_H
+#define SCRIPTING_SAMPLER_H 1
+
+#include "compat.h"
+#include "timer.h"
+#include "tiny_string.h"
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace lightspark
+{
+
+class ABCVm;
+class Class_base;
+class SystemState;
+
+/*
+ * Statistical profiler for ActionScript code
+ *
+ * The timer thread only requests a sample, the VM thread takes it on the next
+ * function call (see ABCVm::incStack). This way the stack is always consistent
+ * and the interpreter needs no locking. Everything but tick() runs in the VM thread.
+ */
+class Sampler: public ITickJob
+{
+public:
+	class SampleData
+	{
+	public:
+		//Microseconds since sampling was started
+		uint64_t time;
+		//Frame ids, innermost frame first
+		std::vector<uint32_t> stack;
+		//Only set for samples of object allocations
+		Class_base* type;
+		uint32_t id;
+		uint32_t size;
+	};
+private:
+	SystemState* sys;
+	ATOMIC_INT32(pending);
+	bool running;
+	//Keep samples for flash.sampler.getSamples
+	bool recordSamples;
+	uint32_t interval;
+	uint64_t startTime;
+	uint32_t nextObjectId;
+	std::vector<SampleData> samples;
+	std::map<std::pair<const Class_base*,uint32_t>,uint32_t> frameIds;
+	std::vector<tiny_string> frameNames;
+	//Aggregated stacks for the collapsed stack output
+	tiny_string outputFile;
+	std::map<std::vector<uint32_t>,uint64_t> stackCounts;
+	//Calls per function name
+	std::unordered_map<uint32_t,uint32_t> invocations;
+	void captureStack(ABCVm* vm, std::vector<uint32_t>& stack);
+public:
+	Sampler(SystemState* s, uint32_t intervalMs=1);
+	~Sampler();
+	//Starts and stops the timer requesting samples
+	void start();
+	void stop();
+	bool isRunning() const { return running; }
+	void setRecordSamples(bool b) { recordSamples=b; }
+	void setOutputFile(const tiny_string& f) { outputFile=f; }
+	bool hasOutputFile() const { return !outputFile.empty(); }
+	//Writes the aggregated stacks in the format used by flamegraph.pl and speedscope
+	void writeOutput();
+	void tick() override;
+	void tickFence() override {}
+	void functionCalled(ABCVm* vm, uint32_t name)
+	{
+		invocations[name]++;
+		poll(vm);
+	}
+	//Takes a sample if the timer requested one
+	void poll(ABCVm* vm)
+	{
+		if(ACQUIRE_READ(pending))
+		{
+			RELEASE_WRITE(pending,0);
+			takeSample(vm);
+		}
+	}
+	void takeSample(ABCVm* vm);
+	void objectConstructed(ABCVm* vm, Class_base* type, uint32_t size);
+	const std::vector<SampleData>& getSamples() const { return samples; }
+	void clearSamples() { samples.clear(); }
+	const tiny_string& getFrameName(uint32_t id) const { return frameNames[id]; }
+	uint32_t getInvocationCount(uint32_t name) const;
+};
+
+}
+#endif /* SCRIPTING_SAMPLER_H */
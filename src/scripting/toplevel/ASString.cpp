@@ -54,6 +54,17 @@ ASString::ASString(Class_base* c,const char* s, uint32_t len) : ASObject(c,T_STR
 	currentindex=0;
 }
 
+void ASString::append(const tiny_string& s)
+{
+	assert(isLastRef());
+	getData() += s;
+	stringId = UINT32_MAX;
+	hasId = false;
+	// the buffer may have been reallocated
+	currentpos = CharIterator();
+	currentindex = 0;
+}
+
 ASFUNCTIONBODY_ATOM(ASString,_constructor)
 {
 	ASString* th=asAtomHandler::as<ASString>(obj);
@@ -500,7 +511,10 @@ number_t ASString::toNumber()
 	val = parseStringInfinite(s, &end);
 
 	// If did not parse as infinite, try decimal
-	if (!std::isinf(val))
+	const char* fastend;
+	if (!std::isinf(val) && Number::parseDecimalFast(s,&fastend,val))
+		end = const_cast<char*>(fastend);
+	else if (!std::isinf(val))
 	{
 		errno = 0;
 		val = g_ascii_strtod(s, &end);
@@ -28,7 +28,11 @@ namespace lightspark
 {
 /*
  * The AS String class.
- * The 'data' is immutable -> it cannot be changed after creation of the object
+ * The 'data' is immutable as seen from ActionScript: a string that is referenced from more
+ * than one place is never changed, operations create a new ASString instead.
+ * The only exception is append(): the add opcodes use it to extend a string in place if the
+ * operand is the last reference to it (e.g. the result of a previous add), as nobody else can
+ * observe the change. append() invalidates the cached string id and character position.
  */
 class ASString: public ASObject
 {
@@ -63,6 +67,8 @@ public:
 		}
 		return data;
 	}
+	// appends s to the string data, only allowed if nobody else holds a reference to this string
+	void append(const tiny_string& s);
 	FORCE_INLINE bool isEmpty() const
 	{
 		if (hasId)
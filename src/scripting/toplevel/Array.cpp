@@ -29,7 +29,7 @@
 using namespace std;
 using namespace lightspark;
 
-Array::Array(Class_base* c):ASObject(c,T_ARRAY),currentsize(0)
+Array::Array(Class_base* c):ASObject(c,T_ARRAY),currentsize(0),denselimit(ARRAY_SIZE_THRESHOLD)
 {
 }
 
@@ -46,6 +46,7 @@ bool Array::destruct()
 	data_first.clear();
 	data_second.clear();
 	currentsize=0;
+	denselimit=ARRAY_SIZE_THRESHOLD;
 	return destructIntern();
 }
 
@@ -158,18 +159,13 @@ ASFUNCTIONBODY_ATOM(Array,_concat)
 	
 	// copy values into new array
 	res->resize(th->size());
-	auto it1=th->data_first.begin();
-	for(;it1 != th->data_first.end();++it1)
-	{
-		res->data_first.push_back(*it1);
+	res->denselimit=th->denselimit;
+	res->data_first=th->data_first;
+	for(auto it1=res->data_first.begin();it1 != res->data_first.end();++it1)
 		ASATOM_INCREF((*it1));
-	}
-	auto it2=th->data_second.begin();
-	for(;it2 != th->data_second.end();++it2)
-	{
-		res->data_second[it2->first]=it2->second;
-		ASATOM_INCREF(res->data_second[it2->first]);
-	}
+	res->data_second=th->data_second;
+	for(auto it2=res->data_second.begin();it2 != res->data_second.end();++it2)
+		ASATOM_INCREF(it2->second);
 
 	for(unsigned int i=0;i<argslen;i++)
 	{
@@ -177,21 +173,32 @@ ASFUNCTIONBODY_ATOM(Array,_concat)
 		{
 			// Insert the contents of the array argument
 			uint64_t oldSize=res->currentsize;
-			uint64_t newSize=oldSize;
 			Array* otherArray=asAtomHandler::as<Array>(args[i]);
-			auto itother1=otherArray->data_first.begin();
-			for(;itother1!=otherArray->data_first.end(); ++itother1)
+			res->resize(oldSize+otherArray->size());
+			if (oldSize == res->data_first.size() && res->data_second.empty() && otherArray->data_second.empty())
 			{
-				res->push(*itother1);
-				newSize++;
+				// both arrays are dense, so the values can be appended in one step
+				res->data_first.insert(res->data_first.end(),otherArray->data_first.begin(),otherArray->data_first.end());
+				for(auto it1=res->data_first.begin()+oldSize;it1 != res->data_first.end();++it1)
+					ASATOM_INCREF((*it1));
+				if (res->data_first.size() > res->denselimit)
+					res->denselimit=res->data_first.size();
 			}
-			auto itother2=otherArray->data_second.begin();
-			for(;itother2!=otherArray->data_second.end(); ++itother2)
+			else
 			{
-				asAtom a = itother2->second;
-				res->set(newSize+itother2->first, a,false);
+				for(uint32_t j=0;j<otherArray->data_first.size();j++)
+				{
+					asAtom a = otherArray->data_first[j];
+					if (asAtomHandler::isValid(a))
+						res->set(oldSize+j,a,false);
+				}
+				auto itother2=otherArray->data_second.begin();
+				for(;itother2!=otherArray->data_second.end(); ++itother2)
+				{
+					asAtom a = itother2->second;
+					res->set(oldSize+itother2->first,a,false);
+				}
 			}
-			res->resize(oldSize+otherArray->size());
 		}
 		else
 		{
@@ -228,7 +235,7 @@ ASFUNCTIONBODY_ATOM(Array,filter)
 	while (index < th->currentsize)
 	{
 		index++;
-		if (index <= ARRAY_SIZE_THRESHOLD)
+		if (index <= th->denselimit)
 		{
 			asAtom& a =th->data_first.at(index-1);
 			if (asAtomHandler::isInvalid(a))
@@ -295,7 +302,7 @@ ASFUNCTIONBODY_ATOM(Array, some)
 	while (index < th->currentsize)
 	{
 		index++;
-		if (index <= ARRAY_SIZE_THRESHOLD)
+		if (index <= th->denselimit)
 		{
 			asAtom& a =th->data_first.at(index-1);
 			if (asAtomHandler::isInvalid(a))
@@ -358,7 +365,7 @@ ASFUNCTIONBODY_ATOM(Array, every)
 	while (index < th->currentsize)
 	{
 		index++;
-		if (index <= ARRAY_SIZE_THRESHOLD)
+		if (index <= th->denselimit)
 		{
 			asAtom& a =th->data_first.at(index-1);
 			if (asAtomHandler::isInvalid(a))
@@ -438,7 +445,7 @@ ASFUNCTIONBODY_ATOM(Array,forEach)
 	while (index < s)
 	{
 		index++;
-		if (index <= ARRAY_SIZE_THRESHOLD)
+		if (index <= th->denselimit)
 		{
 			asAtom& a =th->data_first.at(index-1);
 			if (asAtomHandler::isInvalid(a))
@@ -543,7 +550,7 @@ ASFUNCTIONBODY_ATOM(Array,lastIndexOf)
 	do
 	{
 		asAtom a=asAtomHandler::invalidAtom;
-		if ( i >= ARRAY_SIZE_THRESHOLD)
+		if ( i >= th->denselimit)
 		{
 			auto it = th->data_second.find(i);
 			if (it == th->data_second.end())
@@ -604,28 +611,11 @@ ASFUNCTIONBODY_ATOM(Array,shift)
 		asAtomHandler::setUndefined(ret);
 		return;
 	}
-	if (th->data_first.size() > 0)
+	asAtomHandler::setUndefined(ret);
+	if (th->data_first.size() > 0 && asAtomHandler::isValid(th->data_first[0]))
 		ret = th->data_first[0];
-	if (asAtomHandler::isInvalid(ret))
-		ret = asAtomHandler::undefinedAtom;
-	if (th->data_first.size() > 0)
-		th->data_first.erase(th->data_first.begin());
-
-	std::unordered_map<uint32_t,asAtom> tmp;
-	auto it=th->data_second.begin();
-	for (; it != th->data_second.end(); ++it )
-	{
-		if(it->first)
-		{
-			if (it->first == ARRAY_SIZE_THRESHOLD)
-				th->data_first[ARRAY_SIZE_THRESHOLD-1] = it->second;
-			else
-				tmp[it->first-1]=it->second;
-		}
-	}
-	th->data_second.clear();
-	th->data_second.insert(tmp.begin(),tmp.end());
-	th->resize(th->size()-1);
+	// the reference is handed over to the caller
+	th->removeRange(0,1);
 }
 
 int Array::capIndex(int i)
@@ -683,6 +673,8 @@ ASFUNCTIONBODY_ATOM(Array,splice)
 
 	startIndex=th->capIndex(startIndex);
 
+	if (deleteCount < 0)
+		deleteCount=0;
 	if((uint32_t)(startIndex+deleteCount)>totalSize)
 		deleteCount=totalSize-startIndex;
 
@@ -692,67 +684,22 @@ ASFUNCTIONBODY_ATOM(Array,splice)
 		// Derived classes may be sealed!
 		if (th->getSystemState()->getSwfVersion() < 13 && th->getClass() && th->getClass()->isSealed)
 			throwError<ReferenceError>(kReadSealedError,"splice",th->getClass()->getQualifiedClassName());
-		// write deleted items to return array
+		// move deleted items to return array, the references are handed over
 		for(int i=0;i<deleteCount;i++)
 		{
-			asAtom a = th->at((uint32_t)startIndex+i);
+			asAtom a = th->getStored((uint32_t)startIndex+i);
 			if (asAtomHandler::isValid(a))
-				res->set(i,a,false);
-		}
-		// delete items from current array
-		for (int i = 0; i < deleteCount; i++)
-		{
-			if (i+startIndex < ARRAY_SIZE_THRESHOLD)
-			{
-				if ((uint32_t)startIndex <th->data_first.size())
-					th->data_first.erase(th->data_first.begin()+startIndex);
-			}
-			else
-			{
-				auto it = th->data_second.find(startIndex+i);
-				if (it != th->data_second.end())
-				{
-					th->data_second.erase(it);
-				}
-			}
-		}
-	}
-	// remember items in current array that have to be moved to new position
-	vector<asAtom> tmp = vector<asAtom>(totalSize- (startIndex+deleteCount));
-	for (uint32_t i = (uint32_t)startIndex+deleteCount; i < totalSize ; i++)
-	{
-		if (i < ARRAY_SIZE_THRESHOLD)
-		{
-			if ((uint32_t)startIndex < th->data_first.size())
-			{
-				tmp[i-(startIndex+deleteCount)] = th->data_first[(uint32_t)startIndex];
-				th->data_first.erase(th->data_first.begin()+startIndex);
-			}
-		}
-		else
-		{
-			auto it = th->data_second.find(i);
-			if (it != th->data_second.end())
-			{
-				tmp[i-(startIndex+deleteCount)] = it->second;
-				th->data_second.erase(it);
-			}
+				res->set(i,a,false,false);
 		}
+		// move all following items down in one step
+		th->removeRange(startIndex,deleteCount);
 	}
-	th->resize(startIndex);
-
-	
 	//Insert requested values starting at startIndex
-	for(unsigned int i=2;i<argslen;i++)
+	if (argslen > 2)
 	{
-		th->push(args[i]);
-	}
-	// move remembered items to new position
-	th->resize((totalSize-deleteCount)+(argslen > 2 ? argslen-2 : 0));
-	for(uint32_t i=0;i<totalSize- (startIndex+deleteCount);i++)
-	{
-		if (asAtomHandler::isValid(tmp[i]))
-			th->set(startIndex+i+(argslen > 2 ? argslen-2 : 0),tmp[i],false);
+		th->insertGap(startIndex,argslen-2);
+		for(unsigned int i=2;i<argslen;i++)
+			th->set(startIndex+i-2,args[i],false);
 	}
 	ret =asAtomHandler::fromObject(res);
 }
@@ -856,9 +803,9 @@ ASFUNCTIONBODY_ATOM(Array,_pop)
 	if (size == 0)
 		return;
 	
-	if (size <= ARRAY_SIZE_THRESHOLD)
+	if (size <= th->denselimit)
 	{
-		if (th->data_first.size() > 0)
+		if (th->data_first.size() == size)
 		{
 			ret = *th->data_first.rbegin();
 			th->data_first.pop_back();
@@ -995,6 +942,57 @@ number_t Array::sortComparatorWrapper::compare(const asAtom& d1, const asAtom& d
 	return asAtomHandler::toNumber(ret);
 }
 
+// sorts arrays containing only primitive values without calling back into the vm:
+// the sort keys are computed once per element instead of once per comparison
+// returns false if the array contains values that need the generic comparator
+static bool sortPrimitivesArray(std::vector<asAtom>& v, SystemState* sys, bool oldversion, bool isNumeric, bool isCaseInsensitive, bool isDescending)
+{
+	if (isNumeric)
+	{
+		std::vector<std::pair<number_t,asAtom>> keys;
+		keys.reserve(v.size());
+		for (auto it=v.begin(); it != v.end(); ++it)
+		{
+			if (!asAtomHandler::isNumeric(*it))
+				return false;
+			if (oldversion)
+				keys.push_back(make_pair(number_t(asAtomHandler::toInt(*it) & 0x1fffffff),*it));
+			else
+				keys.push_back(make_pair(asAtomHandler::toNumber(*it),*it));
+		}
+		if (isDescending)
+			sort(keys.begin(),keys.end(),[](const std::pair<number_t,asAtom>& a, const std::pair<number_t,asAtom>& b) { return b.first<a.first; });
+		else
+			sort(keys.begin(),keys.end(),[](const std::pair<number_t,asAtom>& a, const std::pair<number_t,asAtom>& b) { return a.first<b.first; });
+		for (uint32_t i=0; i < keys.size(); i++)
+			v[i]=keys[i].second;
+		return true;
+	}
+	std::vector<tiny_string> strings;
+	strings.reserve(v.size());
+	for (auto it=v.begin(); it != v.end(); ++it)
+	{
+		if (!asAtomHandler::isPrimitive(*it))
+			return false;
+		strings.push_back(asAtomHandler::toString(*it,sys));
+	}
+	// sort pointers to the keys, so that the strings don't get copied around
+	std::vector<std::pair<tiny_string*,asAtom>> keys;
+	keys.reserve(v.size());
+	for (uint32_t i=0; i < v.size(); i++)
+		keys.push_back(make_pair(&strings[i],v[i]));
+	sort(keys.begin(),keys.end(),[isCaseInsensitive,isDescending](const std::pair<tiny_string*,asAtom>& a, const std::pair<tiny_string*,asAtom>& b)
+	{
+		//TODO: unicode support
+		if(isCaseInsensitive)
+			return isDescending ? a.first->strcasecmp(*b.first)>0 : a.first->strcasecmp(*b.first)<0;
+		return isDescending ? *a.first>*b.first : *a.first<*b.first;
+	});
+	for (uint32_t i=0; i < keys.size(); i++)
+		v[i]=keys[i].second;
+	return true;
+}
+
 ASFUNCTIONBODY_ATOM(Array,_sort)
 {
 	Array* th=asAtomHandler::as<Array>(obj);
@@ -1046,17 +1044,14 @@ ASFUNCTIONBODY_ATOM(Array,_sort)
 		sortComparatorWrapper c(comp);
 		simplequicksortArray(tmp,c,0,tmp.size()-1);
 	}
-	else
+	else if (!sortPrimitivesArray(tmp,sys,sys->getSwfVersion() < 11,isNumeric,isCaseInsensitive,isDescending))
 		sort(tmp.begin(),tmp.end(),sortComparatorDefault(sys->getSwfVersion() < 11, isNumeric,isCaseInsensitive,isDescending));
 
-	th->data_first.clear();
+	// the sorted values keep the references held by the array
+	th->data_first.swap(tmp);
 	th->data_second.clear();
-	std::vector<asAtom>::iterator ittmp=tmp.begin();
-	int i = 0;
-	for(;ittmp != tmp.end();++ittmp)
-	{
-		th->set(i++,*ittmp,false);
-	}
+	if (th->data_first.size() > th->denselimit)
+		th->denselimit=th->data_first.size();
 	ASATOM_INCREF(obj);
 	ret = obj;
 }
@@ -1215,14 +1210,14 @@ ASFUNCTIONBODY_ATOM(Array,sortOn)
 	
 	sort(tmp.begin(),tmp.end(),sortOnComparator(sortfields,sys));
 
+	// the sorted values keep the references held by the array
 	th->data_first.clear();
 	th->data_second.clear();
-	std::vector<sorton_value>::iterator ittmp=tmp.begin();
-	uint32_t i = 0;
-	for(;ittmp != tmp.end();++ittmp)
-	{
-		th->set(i++, ittmp->dataAtom,false);
-	}
+	th->data_first.reserve(tmp.size());
+	for(auto ittmp=tmp.begin();ittmp != tmp.end();++ittmp)
+		th->data_first.push_back(ittmp->dataAtom);
+	if (th->data_first.size() > th->denselimit)
+		th->denselimit=th->data_first.size();
 	// according to spec sortOn should return "nothing"(?), but it seems that the array is returned
 	ASATOM_INCREF(obj);
 	ret = obj;
@@ -1264,28 +1259,10 @@ ASFUNCTIONBODY_ATOM(Array,unshift)
 		throwError<ReferenceError>(kWriteSealedError,"unshift",th->getClass()->getQualifiedClassName());
 	if (argslen > 0)
 	{
-		th->resize(th->size()+argslen);
-		std::map<uint32_t,asAtom> tmp;
-		for (uint32_t i = 0; i< th->data_first.size(); i++)
-		{
-			tmp[i+argslen]=th->data_first[i];
-		}
-		for (auto it=th->data_second.begin(); it != th->data_second.end(); ++it )
-		{
-			tmp[it->first+argslen]=it->second;
-		}
-		
+		// move the existing items up in one step and fill the gap
+		th->insertGap(0,argslen);
 		for(uint32_t i=0;i<argslen;i++)
-		{
-			tmp[i] = args[i];
-			ASATOM_INCREF(args[i]);
-		}
-		th->data_first.clear();
-		th->data_second.clear();
-		for (auto it=tmp.begin(); it != tmp.end(); ++it )
-		{
-			th->set(it->first,it->second,false);
-		}
+			th->set(i,args[i],false);
 	}
 	asAtomHandler::setUInt(ret,sys,(int32_t)th->size());
 }
@@ -1396,7 +1373,7 @@ ASFUNCTIONBODY_ATOM(Array,_map)
 	while (index < s)
 	{
 		index++;
-		if (index <= ARRAY_SIZE_THRESHOLD)
+		if (index <= th->denselimit)
 		{
 			asAtom& a =th->data_first.at(index-1);
 			if(asAtomHandler::isValid(a))
@@ -1489,27 +1466,7 @@ ASFUNCTIONBODY_ATOM(Array,insertAt)
 	}
 	else
 	{
-		std::map<uint32_t,asAtom> tmp;
-		if (index < ARRAY_SIZE_THRESHOLD)
-			th->data_first.insert(th->data_first.begin()+index,o);
-		auto it=th->data_second.begin();
-		for (; it != th->data_second.end(); ++it )
-		{
-			tmp[it->first+(it->first >= (uint32_t)index ? 1 : 0)]=it->second;
-		}
-		if (th->data_first.size() > ARRAY_SIZE_THRESHOLD)
-		{
-			tmp[ARRAY_SIZE_THRESHOLD] = th->data_first[ARRAY_SIZE_THRESHOLD];
-			th->data_first.pop_back();
-		}
-		th->data_second.clear();
-		auto ittmp = tmp.begin();
-		while (ittmp != tmp.end())
-		{
-			th->set(ittmp->first,ittmp->second,false);
-			ittmp++;
-		}
-		th->currentsize++;
+		th->insertGap(index,1);
 		th->set(index,o,false);
 	}
 }
@@ -1524,40 +1481,11 @@ ASFUNCTIONBODY_ATOM(Array,removeAt)
 	if (index < 0)
 		index = 0;
 	asAtomHandler::setUndefined(ret);
-	if (index < ARRAY_SIZE_THRESHOLD)
-	{
-		if ((uint32_t)index < th->data_first.size())
-		{
-			ret = th->data_first[index];
-			if (asAtomHandler::isInvalid(ret))
-				asAtomHandler::setUndefined(ret);
-			th->data_first.erase(th->data_first.begin()+index);
-		}
-	}
-	else
-	{
-		auto it = th->data_second.find(index);
-		if(it != th->data_second.end())
-		{
-			ret = it->second;
-			if (asAtomHandler::isInvalid(ret))
-				asAtomHandler::setUndefined(ret);
-			th->data_second.erase(it);
-		}
-	}
-	if ((uint32_t)index < th->currentsize)
-		th->currentsize--;
-	std::map<uint32_t,asAtom> tmp;
-	auto it=th->data_second.begin();
-	for (; it != th->data_second.end(); ++it )
-	{
-		if (it->first == ARRAY_SIZE_THRESHOLD)
-			th->data_first[ARRAY_SIZE_THRESHOLD-1]=it->second;
-		else
-			tmp[it->first-(it->first > (uint32_t)index ? 1 : 0)]=it->second;
-	}
-	th->data_second.clear();
-	th->data_second.insert(tmp.begin(),tmp.end());
+	if ((uint32_t)index >= th->currentsize)
+		return;
+	// the reference is handed over to the caller
+	ret = th->at(index);
+	th->removeRange(index,1);
 }
 int32_t Array::getVariableByMultiname_i(const multiname& name)
 {
@@ -1568,7 +1496,7 @@ int32_t Array::getVariableByMultiname_i(const multiname& name)
 
 	if(index<size())
 	{
-		if (index < ARRAY_SIZE_THRESHOLD)
+		if (index < denselimit)
 		{
 			return data_first.size() > index ? asAtomHandler::toInt(data_first.at(index)) : 0;
 		}
@@ -1602,7 +1530,7 @@ GET_VARIABLE_RESULT Array::getVariableByMultiname(asAtom& ret, const multiname&
 	if (getClass() && getClass()->isSealed)
 		throwError<ReferenceError>(kReadSealedError,name.normalizedNameUnresolved(getSystemState()),getClass()->getQualifiedClassName());
 	
-	if (index < ARRAY_SIZE_THRESHOLD)
+	if (index < denselimit)
 	{
 		if (data_first.size() > index)
 		{
@@ -1647,7 +1575,7 @@ GET_VARIABLE_RESULT Array::getVariableByInteger(asAtom &ret, int index, GET_VARI
 	}
 	if (index >=0 && uint32_t(index) < size())
 	{
-		if (index < ARRAY_SIZE_THRESHOLD)
+		if (uint32_t(index) < denselimit)
 		{
 			if (data_first.size() > uint32_t(index))
 			{
@@ -1715,7 +1643,7 @@ bool Array::hasPropertyByMultiname(const multiname& name, bool considerDynamic,
 	// Derived classes may be sealed!
 	if (getClass() && getClass()->isSealed)
 		return false;
-	if (index < ARRAY_SIZE_THRESHOLD)
+	if (index < denselimit)
 	{
 		return data_first.size() > index ? (asAtomHandler::isValid(data_first.at(index))) : false;
 	}
@@ -1878,7 +1806,7 @@ tiny_string Array::toString_priv(bool localized)
 	for(uint32_t i=0;i<size();i++)
 	{
 		asAtom sl=asAtomHandler::invalidAtom;
-		if (i < ARRAY_SIZE_THRESHOLD)
+		if (i < denselimit)
 		{
 			if (i < data_first.size())
 				sl = data_first[i];
@@ -1908,7 +1836,7 @@ void Array::nextValue(asAtom& ret,uint32_t index)
 	if(index<=size())
 	{
 		--index;
-		if (index < ARRAY_SIZE_THRESHOLD)
+		if (index < denselimit)
 			ret = data_first.at(index);
 		else
 		{
@@ -1939,7 +1867,7 @@ uint32_t Array::nextNameIndex(uint32_t cur_index)
 	if(cur_index<s)
 	{
 		uint32_t firstsize = data_first.size();
-		while (cur_index < ARRAY_SIZE_THRESHOLD && cur_index<s && cur_index < firstsize && asAtomHandler::isInvalid(data_first.at(cur_index)))
+		while (cur_index < denselimit && cur_index<s && cur_index < firstsize && asAtomHandler::isInvalid(data_first.at(cur_index)))
 		{
 			cur_index++;
 		}
@@ -1980,7 +1908,7 @@ asAtom Array::at(unsigned int index)
 		outofbounds(index);
 	
 	asAtom ret=asAtomHandler::invalidAtom;
-	if (index < ARRAY_SIZE_THRESHOLD)
+	if (index < denselimit)
 	{
 		if (index < data_first.size())
 			ret = data_first.at(index);
@@ -1998,11 +1926,110 @@ asAtom Array::at(unsigned int index)
 	return asAtomHandler::undefinedAtom;
 }
 
+asAtom Array::getStored(uint32_t index) const
+{
+	if (index < denselimit)
+	{
+		if (index < data_first.size())
+			return data_first[index];
+	}
+	else
+	{
+		auto it = data_second.find(index);
+		if (it != data_second.end())
+			return it->second;
+	}
+	return asAtomHandler::invalidAtom;
+}
+
 void Array::outofbounds(unsigned int index) const
 {
 	throwError<RangeError>(kInvalidArrayLengthError, Number::toString(index));
 }
 
+void Array::growDense(uint32_t newlimit)
+{
+	denselimit = newlimit;
+	auto it=data_second.begin();
+	while (it != data_second.end())
+	{
+		if (it->first < denselimit)
+		{
+			if (it->first >= data_first.size())
+				data_first.resize(it->first+1);
+			data_first[it->first]=it->second;
+			it = data_second.erase(it);
+		}
+		else
+			++it;
+	}
+}
+
+void Array::removeRange(uint32_t start, uint32_t count)
+{
+	if (count == 0)
+		return;
+	uint64_t end = uint64_t(start)+count;
+	if (start < data_first.size())
+		data_first.erase(data_first.begin()+start,data_first.begin()+min(end,uint64_t(data_first.size())));
+	if (!data_second.empty())
+	{
+		std::unordered_map<uint32_t,asAtom> tmp;
+		for (auto it=data_second.begin(); it != data_second.end(); ++it)
+		{
+			if (it->first < start)
+				tmp.insert(*it);
+			else if (it->first >= end)
+			{
+				uint32_t newindex = it->first-count;
+				if (newindex < denselimit)
+				{
+					if (newindex >= data_first.size())
+						data_first.resize(newindex+1);
+					data_first[newindex]=it->second;
+				}
+				else
+					tmp[newindex]=it->second;
+			}
+		}
+		data_second.swap(tmp);
+	}
+	if (currentsize >= end)
+		currentsize -= count;
+	else if (currentsize > start)
+		currentsize = start;
+}
+
+void Array::insertGap(uint32_t start, uint32_t count)
+{
+	if (count == 0)
+		return;
+	if (!data_second.empty())
+	{
+		std::unordered_map<uint32_t,asAtom> tmp;
+		for (auto it=data_second.begin(); it != data_second.end(); ++it)
+			tmp[it->first >= start ? it->first+count : it->first]=it->second;
+		data_second.swap(tmp);
+	}
+	if (start < data_first.size())
+	{
+		data_first.insert(data_first.begin()+start,count,asAtomHandler::invalidAtom);
+		// the array stays dense, so move the limit instead of spilling into data_second
+		if (data_first.size() > denselimit)
+			growDense(data_first.size());
+	}
+	currentsize += count;
+}
+
+void Array::adoptValues(std::vector<asAtom>& values)
+{
+	resize(0);
+	data_first.swap(values);
+	currentsize = data_first.size();
+	if (data_first.size() > denselimit)
+		denselimit = data_first.size();
+}
+
 void Array::resize(uint64_t n)
 {
 	if (n < currentsize)
@@ -2063,7 +2090,7 @@ void Array::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap
 		serializeDynamicProperties(out, stringMap, objMap, traitsMap);
 		for(uint32_t i=0;i<denseCount;i++)
 		{
-			if (i < ARRAY_SIZE_THRESHOLD)
+			if (i < denselimit)
 			{
 				if (asAtomHandler::isInvalid(data_first.at(i)))
 					out->writeByte(null_marker);
@@ -2081,12 +2108,10 @@ void Array::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap
 	}
 }
 
-tiny_string Array::toJSON(std::vector<ASObject *> &path, asAtom replacer, const tiny_string& spaces,const tiny_string& filter)
+void Array::toJSON(std::string& res, std::vector<ASObject *> &path, asAtom replacer, const tiny_string& spaces,const tiny_string& filter)
 {
-	bool ok;
-	tiny_string res = call_toJSON(ok,path,replacer,spaces,filter);
-	if (ok)
-		return res;
+	if (call_toJSON(res,path,replacer,spaces,filter))
+		return;
 	// check for cylic reference
 	if (std::find(path.begin(),path.end(), this) != path.end())
 		throwError<TypeError>(kJSONCyclicStructure);
@@ -2094,22 +2119,31 @@ tiny_string Array::toJSON(std::vector<ASObject *> &path, asAtom replacer, const
 	path.push_back(this);
 	res += "[";
 	bool bfirst = true;
-	tiny_string newline = (spaces.empty() ? "" : "\n");
 	uint32_t denseCount = currentsize;
 	asAtom closure = asAtomHandler::isValid(replacer) && asAtomHandler::getClosure(replacer) ? asAtomHandler::fromObject(asAtomHandler::getClosure(replacer)) : asAtomHandler::nullAtom;
 	
 	for (uint32_t i=0 ; i < denseCount; i++)
 	{
 		asAtom a=asAtomHandler::invalidAtom;
-		if ( i < ARRAY_SIZE_THRESHOLD)
-			a = data_first.at(i);
+		if ( i < denselimit)
+		{
+			if (i < data_first.size())
+				a = data_first[i];
+		}
 		else
 		{
 			auto it = data_second.find(i);
 			if (it != data_second.end())
 				a = it->second;
 		}
-		tiny_string subres;
+		// the separator is removed again if the value is skipped
+		size_t mark = res.size();
+		if (!bfirst)
+			res += ",";
+		if (!spaces.empty())
+			res += "\n";
+		res.append(spaces.raw_buf(),spaces.numBytes());
+		size_t valuestart = res.size();
 		if (asAtomHandler::isValid(replacer) && asAtomHandler::isValid(a))
 		{
 			asAtom params[2];
@@ -2119,32 +2153,27 @@ tiny_string Array::toJSON(std::vector<ASObject *> &path, asAtom replacer, const
 			asAtom funcret=asAtomHandler::invalidAtom;
 			asAtomHandler::callFunction(replacer,funcret,closure, params, 2,false);
 			if (asAtomHandler::isValid(funcret))
-				subres = asAtomHandler::toObject(funcret,getSystemState())->toJSON(path,asAtomHandler::invalidAtom,spaces,filter);
+				asAtomHandler::toObject(funcret,getSystemState())->toJSON(res,path,asAtomHandler::invalidAtom,spaces,filter);
 		}
 		else
 		{
 			ASObject* o = asAtomHandler::isInvalid(a) ? getSystemState()->getNullRef() : asAtomHandler::toObject(a,getSystemState());
 			if (o)
-				subres = o->toJSON(path,replacer,spaces,filter);
-			else
-				continue;
+				o->toJSON(res,path,replacer,spaces,filter);
 		}
-		if (!subres.empty())
-		{
-			if (!bfirst)
-				res += ",";
-			res += newline+spaces;
-			
+		if (res.size() == valuestart)
+			res.resize(mark);
+		else
 			bfirst = false;
-			res += subres;
-		}
 	}
 	if (!bfirst)
-		res += newline+spaces.substr_bytes(0,spaces.numBytes()/2);
+	{
+		if (!spaces.empty())
+			res += "\n";
+		res.append(spaces.raw_buf(),spaces.numBytes()/2);
+	}
 	res += "]";
 	path.pop_back();
-	return res;
-	
 }
 
 Array::~Array()
@@ -2156,7 +2185,10 @@ bool Array::set(unsigned int index, asAtom& o, bool checkbounds, bool addref)
 	bool ret = true;
 	if(index<currentsize)
 	{
-		if (index < ARRAY_SIZE_THRESHOLD)
+		// keep the vector growing as long as it would be at least half filled
+		if (index >= denselimit && uint64_t(index) < (uint64_t(data_first.size())+data_second.size())*2)
+			growDense(max(uint64_t(index)+1,min(uint64_t(denselimit)*2,uint64_t(UINT32_MAX))));
+		if (index < denselimit)
 		{
 			if (index < data_first.size())
 			{
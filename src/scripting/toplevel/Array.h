@@ -25,7 +25,7 @@
 
 namespace lightspark
 {
-// maximum index stored in vector
+// initial maximum index stored in vector, it is raised for arrays that stay dense
 #define ARRAY_SIZE_THRESHOLD 65536
 
 
@@ -49,11 +49,21 @@ class Array: public ASObject
 friend class ABCVm;
 protected:
 	uint64_t currentsize;
-	// data is split into a vector for the first ARRAY_SIZE_THRESHOLD indexes, and a map for bigger indexes
+	// data is split into a vector for the first denselimit indexes, and a map for bigger indexes
+	// denselimit starts at ARRAY_SIZE_THRESHOLD and grows as long as the vector would be at least half filled
 	std::vector<asAtom> data_first;
 	std::unordered_map<uint32_t,asAtom> data_second;
+	uint32_t denselimit;
 	
 	void outofbounds(unsigned int index) const;
+	// returns the stored value without adding a reference, invalidAtom for holes
+	asAtom getStored(uint32_t index) const;
+	// raises denselimit and moves all affected values from data_second into data_first
+	void growDense(uint32_t newlimit);
+	// removes the values in [start,start+count) and moves all following values down, the removed values are not decreffed
+	void removeRange(uint32_t start, uint32_t count);
+	// moves all values from start on count indexes up, leaving the gap unset
+	void insertGap(uint32_t start, uint32_t count);
 	~Array();
 private:
 	class sortComparatorDefault
@@ -131,7 +141,7 @@ public:
 	asAtom at(unsigned int index);
 	FORCE_INLINE void at_nocheck(asAtom& ret,unsigned int index)
 	{
-		if (index < ARRAY_SIZE_THRESHOLD)
+		if (index < denselimit)
 		{
 			if (index < data_first.size())
 				asAtomHandler::set(ret,data_first.at(index));
@@ -151,6 +161,8 @@ public:
 	uint64_t size();
 	void push(asAtom o);
 	void resize(uint64_t n);
+	// replaces the content with the given values, the references are taken over
+	void adoptValues(std::vector<asAtom>& values);
 	GET_VARIABLE_RESULT getVariableByMultiname(asAtom& ret, const multiname& name, GET_VARIABLE_OPTION opt) override;
 	GET_VARIABLE_RESULT getVariableByInteger(asAtom& ret, int index, GET_VARIABLE_OPTION opt=NONE) override;
 	
@@ -168,7 +180,7 @@ public:
 	void serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
 				std::map<const ASObject*, uint32_t>& objMap,
 				std::map<const Class_base*, uint32_t>& traitsMap) override;
-	virtual tiny_string toJSON(std::vector<ASObject *> &path,asAtom replacer, const tiny_string &spaces,const tiny_string& filter) override;
+	void toJSON(std::string& res, std::vector<ASObject *> &path,asAtom replacer, const tiny_string &spaces,const tiny_string& filter) override;
 };
 
 
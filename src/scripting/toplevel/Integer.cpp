@@ -213,16 +213,11 @@ tiny_string Integer::toString()
 tiny_string Integer::toString(int32_t val)
 {
 	char buf[20];
-	if(val<0)
-	{
-		//This can be a slow path, as it not used for array access
-		snprintf(buf,20,"%i",val);
-		return tiny_string(buf,true);
-	}
 	buf[19]=0;
 	char* cur=buf+19;
 
-	int v=val;
+	//Use 64 bit to be able to negate INT32_MIN
+	int64_t v=val<0 ? -int64_t(val) : val;
 	do
 	{
 		cur--;
@@ -230,6 +225,8 @@ tiny_string Integer::toString(int32_t val)
 		v/=10;
 	}
 	while(v!=0);
+	if(val<0)
+		*--cur='-';
 	return tiny_string(cur,true); //Create a copy
 }
 
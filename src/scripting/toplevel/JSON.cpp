@@ -48,8 +48,332 @@ ASFUNCTIONBODY_ATOM(JSON,generator)
 	ret = asAtomHandler::invalidAtom;
 }
 
+namespace
+{
+/*
+ * Parser for JSON.parse without reviver function.
+ * It works on the utf8 bytes of the input in one pass and builds the values directly,
+ * so no positions have to be converted between characters and bytes.
+ * Object keys are converted to string ids once per distinct name.
+ */
+class JSONFastParser
+{
+private:
+	SystemState* sys;
+	const char* cur;
+	const char* end;
+	std::unordered_map<std::string,uint32_t> keyids;
+	std::string strbuf;
+	void fail()
+	{
+		throwError<SyntaxError>(kJSONInvalidParseInput);
+	}
+	void skipWhitespace()
+	{
+		while (cur < end && (*cur == ' ' || *cur == '\t' || *cur == '\n' || *cur == '\r'))
+			cur++;
+	}
+	void expectLiteral(const char* literal, uint32_t len)
+	{
+		if (uint32_t(end-cur) < len || memcmp(cur,literal,len) != 0)
+			fail();
+		cur += len;
+	}
+	// reads the string starting at the opening quote into strbuf
+	void parseRawString()
+	{
+		cur++; // ignore starting quotes
+		strbuf.clear();
+		while (true)
+		{
+			// copy runs of characters without escapes in one step
+			const char* start = cur;
+			while (cur < end && *cur != '"' && *cur != '\\' && (unsigned char)*cur >= 0x20)
+				cur++;
+			strbuf.append(start,cur-start);
+			if (cur >= end)
+				fail();
+			if (*cur == '"')
+			{
+				cur++;
+				return;
+			}
+			if (*cur != '\\')
+				fail();
+			cur++;
+			if (cur >= end)
+				fail();
+			switch (*cur)
+			{
+				case '"': strbuf += '"'; break;
+				case '\\': strbuf += '\\'; break;
+				case '/': strbuf += '/'; break;
+				case 'b': strbuf += '\b'; break;
+				case 'f': strbuf += '\f'; break;
+				case 'n': strbuf += '\n'; break;
+				case 'r': strbuf += '\r'; break;
+				case 't': strbuf += '\t'; break;
+				case 'u':
+				{
+					if (end-cur < 5)
+						fail();
+					uint32_t hexnum = 0;
+					for (int i = 1; i <= 4; i++)
+					{
+						char c = cur[i];
+						hexnum <<= 4;
+						if (c >= '0' && c <= '9')
+							hexnum |= c-'0';
+						else if (c >= 'a' && c <= 'f')
+							hexnum |= c-'a'+10;
+						else if (c >= 'A' && c <= 'F')
+							hexnum |= c-'A'+10;
+						else
+							fail();
+					}
+					if (hexnum < 0x20 && hexnum != 0xf)
+						fail();
+					char utf8[6];
+					strbuf.append(utf8,g_unichar_to_utf8(hexnum,utf8));
+					cur += 4;
+					break;
+				}
+				default:
+					fail();
+			}
+			cur++;
+		}
+	}
+	asAtom parseNumber()
+	{
+		const char* start = cur;
+		bool isinteger = true;
+		while (cur < end)
+		{
+			char c = *cur;
+			if (c >= '0' && c <= '9')
+				cur++;
+			else if (c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E')
+			{
+				if (c != '-' || cur != start)
+					isinteger = false;
+				cur++;
+			}
+			else
+				break;
+		}
+		uint32_t len = cur-start;
+		uint32_t digits = *start == '-' ? len-1 : len;
+		// small integers don't need an allocated Number, -0 has to stay a Number
+		if (isinteger && digits > 0 && digits <= 9 && !(digits == 1 && *start == '-' && start[1] == '0'))
+		{
+			int32_t v = 0;
+			for (const char* p = (*start == '-' ? start+1 : start); p < cur; p++)
+				v = v*10 + (*p-'0');
+			return asAtomHandler::fromInt(*start == '-' ? -v : v);
+		}
+		number_t num;
+		const char* fastend;
+		// the buffer is terminated, and the fast parser doesn't read past the characters collected above
+		if (len && Number::parseDecimalFast(start,&fastend,num) && fastend == cur)
+			return asAtomHandler::fromNumber(sys,num,false);
+		strbuf.assign(start,len);
+		char* numend = nullptr;
+		errno = 0;
+		num = g_ascii_strtod(strbuf.c_str(),&numend);
+		if (len == 0 || numend != strbuf.c_str()+len || std::isnan(num))
+			fail();
+		if (errno == ERANGE && std::isinf(num))
+			num = num > 0 ? numeric_limits<double>::infinity() : -numeric_limits<double>::infinity();
+		return asAtomHandler::fromNumber(sys,num,false);
+	}
+	void parseMembers(std::vector<std::pair<uint32_t,asAtom>>& members)
+	{
+		skipWhitespace();
+		if (cur < end && *cur == '}')
+		{
+			cur++;
+			return;
+		}
+		while (true)
+		{
+			skipWhitespace();
+			if (cur >= end || *cur != '"')
+				fail();
+			parseRawString();
+			auto it = keyids.find(strbuf);
+			uint32_t nameid;
+			if (it != keyids.end())
+				nameid = it->second;
+			else
+			{
+				nameid = sys->getUniqueStringId(tiny_string(strbuf));
+				keyids.insert(make_pair(strbuf,nameid));
+			}
+			skipWhitespace();
+			if (cur >= end || *cur != ':')
+				fail();
+			cur++;
+			members.push_back(make_pair(nameid,parseValue()));
+			skipWhitespace();
+			if (cur >= end)
+				fail();
+			if (*cur == '}')
+			{
+				cur++;
+				return;
+			}
+			if (*cur != ',')
+				fail();
+			cur++;
+		}
+	}
+	void parseElements(std::vector<asAtom>& values)
+	{
+		skipWhitespace();
+		if (cur < end && *cur == ']')
+		{
+			cur++;
+			return;
+		}
+		while (true)
+		{
+			values.push_back(parseValue());
+			skipWhitespace();
+			if (cur >= end)
+				fail();
+			if (*cur == ']')
+			{
+				cur++;
+				return;
+			}
+			if (*cur != ',')
+				fail();
+			cur++;
+		}
+	}
+	asAtom parseObject()
+	{
+		cur++; // ignore '{'
+		std::vector<std::pair<uint32_t,asAtom>> members;
+		try
+		{
+			parseMembers(members);
+		}
+		catch(...)
+		{
+			for (auto it = members.begin(); it != members.end(); ++it)
+				ASATOM_DECREF(it->second);
+			throw;
+		}
+		ASObject* res = Class<ASObject>::getInstanceS(sys);
+		if (members.size() > 1)
+		{
+			//Duplicated keys overwrite the previous value
+			std::stable_sort(members.begin(),members.end(),[](const std::pair<uint32_t,asAtom>& a, const std::pair<uint32_t,asAtom>& b) { return a.first < b.first; });
+			for (uint32_t i = 0; i+1 < members.size(); i++)
+			{
+				if (members[i].first == members[i+1].first)
+				{
+					ASATOM_DECREF(members[i].second);
+					members[i].second = asAtomHandler::invalidAtom;
+				}
+			}
+		}
+		for (auto it = members.begin(); it != members.end(); ++it)
+		{
+			if (asAtomHandler::isValid(it->second))
+				res->setDynamicVariableNoCheck(it->first,it->second);
+		}
+		return asAtomHandler::fromObject(res);
+	}
+	asAtom parseArray()
+	{
+		cur++; // ignore '['
+		std::vector<asAtom> values;
+		try
+		{
+			parseElements(values);
+		}
+		catch(...)
+		{
+			for (auto it = values.begin(); it != values.end(); ++it)
+				ASATOM_DECREF((*it));
+			throw;
+		}
+		Array* res = Class<Array>::getInstanceSNoArgs(sys);
+		res->adoptValues(values);
+		return asAtomHandler::fromObject(res);
+	}
+public:
+	JSONFastParser(SystemState* s, const tiny_string& jsonstring):sys(s),cur(jsonstring.raw_buf()),end(jsonstring.raw_buf()+jsonstring.numBytes())
+	{
+	}
+	asAtom parseValue()
+	{
+		skipWhitespace();
+		if (cur >= end)
+			fail();
+		switch (*cur)
+		{
+			case '{':
+				return parseObject();
+			case '[':
+				return parseArray();
+			case '"':
+				parseRawString();
+				return asAtomHandler::fromObject(abstract_s(sys,tiny_string(strbuf)));
+			case 't':
+				expectLiteral("true",4);
+				return asAtomHandler::fromBool(true);
+			case 'f':
+				expectLiteral("false",5);
+				return asAtomHandler::fromBool(false);
+			case 'n':
+				expectLiteral("null",4);
+				return asAtomHandler::nullAtom;
+			case '-':
+			case '0':
+			case '1':
+			case '2':
+			case '3':
+			case '4':
+			case '5':
+			case '6':
+			case '7':
+			case '8':
+			case '9':
+				return parseNumber();
+			default:
+				fail();
+		}
+		return asAtomHandler::invalidAtom;
+	}
+	// returns NULL if the input only consists of whitespace
+	ASObject* parseAll()
+	{
+		skipWhitespace();
+		if (cur >= end)
+			return NULL;
+		asAtom v = parseValue();
+		skipWhitespace();
+		if (cur < end)
+		{
+			ASATOM_DECREF(v);
+			fail();
+		}
+		return asAtomHandler::toObject(v,sys);
+	}
+};
+}
+
 ASObject *JSON::doParse(const tiny_string &jsonstring, asAtom reviver)
 {
+	if (asAtomHandler::isInvalid(reviver))
+	{
+		JSONFastParser parser(getSys(),jsonstring);
+		return parser.parseAll();
+	}
 	ASObject* res = NULL;
 	multiname dummy(NULL);
 	
@@ -135,9 +459,10 @@ ASFUNCTIONBODY_ATOM(JSON,_stringify)
 				spaces = spaces.substr_bytes(0,10);
 		}
 	}
-	tiny_string res = value->toJSON(path,replacer,spaces,filter);
+	std::string res;
+	value->toJSON(res,path,replacer,spaces,filter);
 
-	ret = asAtomHandler::fromObject(abstract_s(sys,res));
+	ret = asAtomHandler::fromObject(abstract_s(sys,tiny_string(res)));
 }
 void JSON::parseAll(const tiny_string &jsonstring, ASObject** parent , multiname& key, asAtom reviver)
 {
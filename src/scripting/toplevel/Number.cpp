@@ -243,6 +243,300 @@ ASFUNCTIONBODY_ATOM(Number,generator)
 		asAtomHandler::setNumber(ret,sys,asAtomHandler::toNumber(args[0]));
 }
 
+/*
+ * Shortest round-trip digit generation with the Grisu3 algorithm from
+ * Florian Loitsch, "Printing Floating-Point Numbers Quickly and Accurately with Integers".
+ * It only needs 64 bit integer arithmetic, but it rejects the few values (about 0.5%)
+ * for which it can't prove that the digits are the shortest and closest ones.
+ * Those are left to the exact (and much slower) avmplus D2A generator, which produces
+ * the same digits for all other values.
+ */
+struct DiyFp
+{
+	uint64_t f;
+	int32_t e;
+	DiyFp():f(0),e(0) {}
+	DiyFp(uint64_t _f, int32_t _e):f(_f),e(_e) {}
+	DiyFp operator-(const DiyFp& o) const { return DiyFp(f-o.f,e); }
+	// upper 64 bits of the 128 bit product, rounded
+	DiyFp operator*(const DiyFp& o) const
+	{
+		uint64_t a = f >> 32;
+		uint64_t b = f & 0xFFFFFFFF;
+		uint64_t c = o.f >> 32;
+		uint64_t d = o.f & 0xFFFFFFFF;
+		uint64_t ac = a*c;
+		uint64_t bc = b*c;
+		uint64_t ad = a*d;
+		uint64_t bd = b*d;
+		uint64_t tmp = (bd >> 32) + (ad & 0xFFFFFFFF) + (bc & 0xFFFFFFFF) + (1U << 31);
+		return DiyFp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32),e + o.e + 64);
+	}
+	DiyFp normalize() const
+	{
+		DiyFp res = *this;
+		while (!(res.f & 0xFFC0000000000000ULL))
+		{
+			res.f <<= 10;
+			res.e -= 10;
+		}
+		while (!(res.f & 0x8000000000000000ULL))
+		{
+			res.f <<= 1;
+			res.e--;
+		}
+		return res;
+	}
+};
+struct CachedPower
+{
+	uint64_t significand;
+	int16_t binaryexponent;
+	int16_t decimalexponent;
+};
+// normalized 10^k for k = -348,-340,...,340
+static const CachedPower cachedpowers[] = {
+	{ 0xfa8fd5a0081c0288ULL, -1220, -348 },
+	{ 0xbaaee17fa23ebf76ULL, -1193, -340 },
+	{ 0x8b16fb203055ac76ULL, -1166, -332 },
+	{ 0xcf42894a5dce35eaULL, -1140, -324 },
+	{ 0x9a6bb0aa55653b2dULL, -1113, -316 },
+	{ 0xe61acf033d1a45dfULL, -1087, -308 },
+	{ 0xab70fe17c79ac6caULL, -1060, -300 },
+	{ 0xff77b1fcbebcdc4fULL, -1034, -292 },
+	{ 0xbe5691ef416bd60cULL, -1007, -284 },
+	{ 0x8dd01fad907ffc3cULL, -980, -276 },
+	{ 0xd3515c2831559a83ULL, -954, -268 },
+	{ 0x9d71ac8fada6c9b5ULL, -927, -260 },
+	{ 0xea9c227723ee8bcbULL, -901, -252 },
+	{ 0xaecc49914078536dULL, -874, -244 },
+	{ 0x823c12795db6ce57ULL, -847, -236 },
+	{ 0xc21094364dfb5637ULL, -821, -228 },
+	{ 0x9096ea6f3848984fULL, -794, -220 },
+	{ 0xd77485cb25823ac7ULL, -768, -212 },
+	{ 0xa086cfcd97bf97f4ULL, -741, -204 },
+	{ 0xef340a98172aace5ULL, -715, -196 },
+	{ 0xb23867fb2a35b28eULL, -688, -188 },
+	{ 0x84c8d4dfd2c63f3bULL, -661, -180 },
+	{ 0xc5dd44271ad3cdbaULL, -635, -172 },
+	{ 0x936b9fcebb25c996ULL, -608, -164 },
+	{ 0xdbac6c247d62a584ULL, -582, -156 },
+	{ 0xa3ab66580d5fdaf6ULL, -555, -148 },
+	{ 0xf3e2f893dec3f126ULL, -529, -140 },
+	{ 0xb5b5ada8aaff80b8ULL, -502, -132 },
+	{ 0x87625f056c7c4a8bULL, -475, -124 },
+	{ 0xc9bcff6034c13053ULL, -449, -116 },
+	{ 0x964e858c91ba2655ULL, -422, -108 },
+	{ 0xdff9772470297ebdULL, -396, -100 },
+	{ 0xa6dfbd9fb8e5b88fULL, -369, -92 },
+	{ 0xf8a95fcf88747d94ULL, -343, -84 },
+	{ 0xb94470938fa89bcfULL, -316, -76 },
+	{ 0x8a08f0f8bf0f156bULL, -289, -68 },
+	{ 0xcdb02555653131b6ULL, -263, -60 },
+	{ 0x993fe2c6d07b7facULL, -236, -52 },
+	{ 0xe45c10c42a2b3b06ULL, -210, -44 },
+	{ 0xaa242499697392d3ULL, -183, -36 },
+	{ 0xfd87b5f28300ca0eULL, -157, -28 },
+	{ 0xbce5086492111aebULL, -130, -20 },
+	{ 0x8cbccc096f5088ccULL, -103, -12 },
+	{ 0xd1b71758e219652cULL, -77, -4 },
+	{ 0x9c40000000000000ULL, -50, 4 },
+	{ 0xe8d4a51000000000ULL, -24, 12 },
+	{ 0xad78ebc5ac620000ULL, 3, 20 },
+	{ 0x813f3978f8940984ULL, 30, 28 },
+	{ 0xc097ce7bc90715b3ULL, 56, 36 },
+	{ 0x8f7e32ce7bea5c70ULL, 83, 44 },
+	{ 0xd5d238a4abe98068ULL, 109, 52 },
+	{ 0x9f4f2726179a2245ULL, 136, 60 },
+	{ 0xed63a231d4c4fb27ULL, 162, 68 },
+	{ 0xb0de65388cc8ada8ULL, 189, 76 },
+	{ 0x83c7088e1aab65dbULL, 216, 84 },
+	{ 0xc45d1df942711d9aULL, 242, 92 },
+	{ 0x924d692ca61be758ULL, 269, 100 },
+	{ 0xda01ee641a708deaULL, 295, 108 },
+	{ 0xa26da3999aef774aULL, 322, 116 },
+	{ 0xf209787bb47d6b85ULL, 348, 124 },
+	{ 0xb454e4a179dd1877ULL, 375, 132 },
+	{ 0x865b86925b9bc5c2ULL, 402, 140 },
+	{ 0xc83553c5c8965d3dULL, 428, 148 },
+	{ 0x952ab45cfa97a0b3ULL, 455, 156 },
+	{ 0xde469fbd99a05fe3ULL, 481, 164 },
+	{ 0xa59bc234db398c25ULL, 508, 172 },
+	{ 0xf6c69a72a3989f5cULL, 534, 180 },
+	{ 0xb7dcbf5354e9beceULL, 561, 188 },
+	{ 0x88fcf317f22241e2ULL, 588, 196 },
+	{ 0xcc20ce9bd35c78a5ULL, 614, 204 },
+	{ 0x98165af37b2153dfULL, 641, 212 },
+	{ 0xe2a0b5dc971f303aULL, 667, 220 },
+	{ 0xa8d9d1535ce3b396ULL, 694, 228 },
+	{ 0xfb9b7cd9a4a7443cULL, 720, 236 },
+	{ 0xbb764c4ca7a44410ULL, 747, 244 },
+	{ 0x8bab8eefb6409c1aULL, 774, 252 },
+	{ 0xd01fef10a657842cULL, 800, 260 },
+	{ 0x9b10a4e5e9913129ULL, 827, 268 },
+	{ 0xe7109bfba19c0c9dULL, 853, 276 },
+	{ 0xac2820d9623bf429ULL, 880, 284 },
+	{ 0x80444b5e7aa7cf85ULL, 907, 292 },
+	{ 0xbf21e44003acdd2dULL, 933, 300 },
+	{ 0x8e679c2f5e44ff8fULL, 960, 308 },
+	{ 0xd433179d9c8cb841ULL, 986, 316 },
+	{ 0x9e19db92b4e31ba9ULL, 1013, 324 },
+	{ 0xeb96bf6ebadf77d9ULL, 1039, 332 },
+	{ 0xaf87023b9bf0ee6bULL, 1066, 340 },
+};
+#define CACHEDPOWERS_OFFSET 348
+#define CACHEDPOWERS_DISTANCE 8
+// the scaled values have their binary exponent in this range, so the integral part fits into 32 bits
+#define GRISU_MIN_TARGET_EXPONENT -60
+#define GRISU_MAX_TARGET_EXPONENT -32
+
+static bool grisuRoundWeed(char* buffer, int32_t length, uint64_t distancetoohighw, uint64_t unsafeinterval, uint64_t rest, uint64_t tenkappa, uint64_t unit)
+{
+	uint64_t smalldistance = distancetoohighw - unit;
+	uint64_t bigdistance = distancetoohighw + unit;
+	// move the last digit towards the exact value as long as that stays inside the safe interval
+	while (rest < smalldistance && unsafeinterval - rest >= tenkappa &&
+		   (rest + tenkappa < smalldistance || smalldistance - rest >= rest + tenkappa - smalldistance))
+	{
+		buffer[length-1]--;
+		rest += tenkappa;
+	}
+	// another candidate could be closer, the result can't be decided with the available precision
+	if (rest < bigdistance && unsafeinterval - rest >= tenkappa &&
+		(rest + tenkappa < bigdistance || bigdistance - rest > rest + tenkappa - bigdistance))
+		return false;
+	return (2 * unit <= rest) && (rest <= unsafeinterval - 4 * unit);
+}
+
+static bool grisuDigitGen(const DiyFp& low, const DiyFp& w, const DiyFp& high, char* buffer, int32_t& length, int32_t& kappa)
+{
+	uint64_t unit = 1;
+	DiyFp toolow(low.f - unit,low.e);
+	DiyFp toohigh(high.f + unit,high.e);
+	DiyFp unsafeinterval = toohigh - toolow;
+	DiyFp one(uint64_t(1) << -w.e,w.e);
+	uint32_t integrals = toohigh.f >> -one.e;
+	uint64_t fractionals = toohigh.f & (one.f - 1);
+	uint32_t divisor = 1000000000;
+	kappa = 10;
+	while (divisor > integrals)
+	{
+		divisor /= 10;
+		kappa--;
+	}
+	length = 0;
+	while (kappa > 0)
+	{
+		buffer[length++] = '0' + integrals / divisor;
+		integrals %= divisor;
+		kappa--;
+		uint64_t rest = (uint64_t(integrals) << -one.e) + fractionals;
+		if (rest < unsafeinterval.f)
+			return grisuRoundWeed(buffer,length,(toohigh - w).f,unsafeinterval.f,rest,uint64_t(divisor) << -one.e,unit);
+		divisor /= 10;
+	}
+	while (true)
+	{
+		fractionals *= 10;
+		unit *= 10;
+		unsafeinterval.f *= 10;
+		buffer[length++] = '0' + (fractionals >> -one.e);
+		fractionals &= one.f - 1;
+		kappa--;
+		if (fractionals < unsafeinterval.f)
+			return grisuRoundWeed(buffer,length,(toohigh - w).f * unit,unsafeinterval.f,fractionals,one.f,unit);
+	}
+}
+
+// writes the shortest digits of a positive double into buffer, value = 0.digits * 10^(exp10+1)
+static bool grisu3(double value, char* buffer, int32_t& length, int32_t& exp10)
+{
+	uint64_t bits;
+	memcpy(&bits,&value,sizeof(bits));
+	int32_t biasedexponent = (bits >> 52) & 0x7FF;
+	// D2A treats denormals as if they had full precision and uses asymmetric boundaries for the
+	// smallest normal exponent, so these are left to it to get the same digits
+	if (biasedexponent <= 1 || biasedexponent == 0x7FF)
+		return false;
+	DiyFp w((bits & 0x000FFFFFFFFFFFFFULL) | 0x0010000000000000ULL,biasedexponent - 1075);
+	// boundaries halfway to the neighbouring doubles, the lower one is closer for powers of two
+	DiyFp plus = DiyFp((w.f << 1) + 1,w.e - 1).normalize();
+	DiyFp minus;
+	if (w.f == 0x0010000000000000ULL)
+		minus = DiyFp((w.f << 2) - 1,w.e - 2);
+	else
+		minus = DiyFp((w.f << 1) - 1,w.e - 1);
+	minus.f <<= minus.e - plus.e;
+	minus.e = plus.e;
+	w = w.normalize();
+
+	int32_t minexponent = GRISU_MIN_TARGET_EXPONENT - (w.e + 64);
+	int32_t k = (int32_t)ceil((minexponent + 63) * 0.30102999566398114);
+	const CachedPower& cached = cachedpowers[(CACHEDPOWERS_OFFSET + k - 1) / CACHEDPOWERS_DISTANCE + 1];
+	DiyFp tenmk(cached.significand,cached.binaryexponent);
+	assert(w.e + tenmk.e + 64 >= GRISU_MIN_TARGET_EXPONENT && w.e + tenmk.e + 64 <= GRISU_MAX_TARGET_EXPONENT);
+
+	int32_t kappa;
+	if (!grisuDigitGen(minus * tenmk,w * tenmk,plus * tenmk,buffer,length,kappa))
+		return false;
+	exp10 = length + kappa - cached.decimalexponent - 1;
+	return true;
+}
+
+// formats the digits like the DTOSTR_NORMAL mode of Number::toString
+static tiny_string formatShortest(bool negative, const char* digits, int32_t length, int32_t exp10)
+{
+	char buffer[40];
+	char* s = buffer;
+	if (negative)
+		*s++ = '-';
+	if (exp10 < 0 && exp10 > -7)
+	{
+		*s++ = '0';
+		*s++ = '.';
+		for (int32_t i = exp10; i < -1; i++)
+			*s++ = '0';
+		memcpy(s,digits,length);
+		s += length;
+	}
+	else if (exp10 < 0 || exp10 > 20)
+	{
+		*s++ = digits[0];
+		if (length > 1)
+		{
+			*s++ = '.';
+			memcpy(s,digits+1,length-1);
+			s += length-1;
+		}
+		*s++ = 'e';
+		if (exp10 > 0)
+			*s++ = '+';
+		else
+		{
+			*s++ = '-';
+			exp10 = -exp10;
+		}
+		if (exp10 >= 100)
+			*s++ = '0' + exp10/100;
+		if (exp10 >= 10)
+			*s++ = '0' + (exp10/10)%10;
+		*s++ = '0' + exp10%10;
+	}
+	else
+	{
+		for (int32_t i = 0; i <= exp10; i++)
+			*s++ = i < length ? digits[i] : '0';
+		if (length > exp10+1)
+		{
+			*s++ = '.';
+			memcpy(s,digits+exp10+1,length-exp10-1);
+			s += length-exp10-1;
+		}
+	}
+	*s = 0;
+	return tiny_string(buffer,true);
+}
+
 tiny_string Number::toString()
 {
 	return Number::toString(isfloat ? dval : ival);
@@ -265,10 +559,12 @@ tiny_string Number::toString(number_t value, DTOSTRMODE mode, int32_t precision)
 	if (mode == DTOSTR_NORMAL) {
 		int32_t intValue = int32_t(value);
 		if ((value == (double)(intValue)) && ((uint32_t)intValue != 0x80000000))
-		{
-			snprintf(buffer,40,"%d",(int)(value));
-			return tiny_string(buffer,true);
-		}
+			return Integer::toString(intValue);
+		char digits[20];
+		int32_t length, exp10;
+		// exponential notation is cut off after 15 digits by the code below, so longer results are left to it
+		if (grisu3(fabs(value),digits,length,exp10) && (exp10 <= 20 || length <= 15))
+			return formatShortest(value < 0,digits,length,exp10);
 	}
 
 	const bool negative = value < 0.0;
@@ -565,6 +861,108 @@ tiny_string Number::toString(number_t value, DTOSTRMODE mode, int32_t precision)
 	return tiny_string(s,true);
 }
 
+/*
+ * Clinger's fast path: if the decimal mantissa and the power of ten are both exactly representable
+ * as doubles, a single (correctly rounded) multiplication or division gives the correct result.
+ */
+static const double exactpowersoften[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+#define MAX_EXACT_MANTISSA 0x20000000000000ULL
+
+bool Number::parseDecimalFast(const char* s, const char** end, number_t& result)
+{
+	const char* p = s;
+	bool negative = false;
+	if (*p == '-' || *p == '+')
+	{
+		negative = *p == '-';
+		p++;
+	}
+	// hexadecimal numbers are handled by strtod
+	if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))
+		return false;
+	uint64_t mantissa = 0;
+	int32_t significantdigits = 0;
+	int32_t exponent = 0;
+	bool hasdigits = false;
+	while (*p >= '0' && *p <= '9')
+	{
+		hasdigits = true;
+		if (mantissa || *p != '0')
+		{
+			mantissa = mantissa*10 + (*p-'0');
+			significantdigits++;
+		}
+		p++;
+	}
+	if (*p == '.')
+	{
+		p++;
+		while (*p >= '0' && *p <= '9')
+		{
+			hasdigits = true;
+			if (mantissa || *p != '0')
+			{
+				mantissa = mantissa*10 + (*p-'0');
+				significantdigits++;
+			}
+			exponent--;
+			p++;
+		}
+	}
+	if (!hasdigits || significantdigits > 19)
+		return false;
+	// the exponent is only consumed if it contains digits
+	if (*p == 'e' || *p == 'E')
+	{
+		const char* e = p+1;
+		bool negativeexponent = false;
+		if (*e == '-' || *e == '+')
+		{
+			negativeexponent = *e == '-';
+			e++;
+		}
+		if (*e >= '0' && *e <= '9')
+		{
+			int32_t exp = 0;
+			while (*e >= '0' && *e <= '9')
+			{
+				if (exp < 100000)
+					exp = exp*10 + (*e-'0');
+				e++;
+			}
+			exponent += negativeexponent ? -exp : exp;
+			p = e;
+		}
+	}
+	if (mantissa == 0)
+	{
+		result = negative ? -0.0 : 0.0;
+		*end = p;
+		return true;
+	}
+	if (mantissa > MAX_EXACT_MANTISSA)
+		return false;
+	// "123e25" can be computed exactly as 123000e22
+	while (exponent > 22 && mantissa*10 <= MAX_EXACT_MANTISSA)
+	{
+		mantissa *= 10;
+		exponent--;
+	}
+	if (exponent < -22 || exponent > 22)
+		return false;
+	number_t value = (number_t)mantissa;
+	if (exponent < 0)
+		value /= exactpowersoften[-exponent];
+	else
+		value *= exactpowersoften[exponent];
+	result = negative ? -value : value;
+	*end = p;
+	return true;
+}
+
 tiny_string Number::toStringRadix(number_t val, int radix)
 {
 	if(radix < 2 || radix > 36)
@@ -68,6 +68,9 @@ public:
 	static tiny_string toExponentialString(double v, int32_t fractionDigits);
 	static tiny_string toFixedString(double v, int32_t fractionDigits);
 	static tiny_string toPrecisionString(double v, int32_t precision);
+	/* parses a plain decimal number with up to 19 significant digits like strtod does, but without its slow exact path
+	 * returns false if the input has to be handled by strtod */
+	static bool parseDecimalFast(const char* s, const char** end, number_t& result);
 	static bool isInteger(number_t val)
 	{
 		return trunc(val) == val;
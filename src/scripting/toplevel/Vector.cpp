@@ -1311,12 +1311,10 @@ bool Vector::isValidMultiname(SystemState* sys,const multiname& name, uint32_t&
 	return validIndex;
 }
 
-tiny_string Vector::toJSON(std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces, const tiny_string &filter)
+void Vector::toJSON(std::string& res, std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces, const tiny_string &filter)
 {
-	bool ok;
-	tiny_string res = call_toJSON(ok,path,replacer,spaces,filter);
-	if (ok)
-		return res;
+	if (call_toJSON(res,path,replacer,spaces,filter))
+		return;
 	// check for cylic reference
 	if (std::find(path.begin(),path.end(), this) != path.end())
 		throwError<TypeError>(kJSONCyclicStructure);
@@ -1324,12 +1322,18 @@ tiny_string Vector::toJSON(std::vector<ASObject *> &path, asAtom replacer, const
 	path.push_back(this);
 	res += "[";
 	bool bfirst = true;
-	tiny_string newline = (spaces.empty() ? "" : "\n");
 	asAtom closure = asAtomHandler::isValid(replacer) && asAtomHandler::getClosure(replacer) ? asAtomHandler::fromObject(asAtomHandler::getClosure(replacer)) : asAtomHandler::nullAtom;
 	for (unsigned int i =0;  i < vec.size(); i++)
 	{
-		tiny_string subres;
 		asAtom o = vec[i];
+		// the separator is removed again if the value is skipped
+		size_t mark = res.size();
+		if (!bfirst)
+			res += ",";
+		if (!spaces.empty())
+			res += "\n";
+		res.append(spaces.raw_buf(),spaces.numBytes());
+		size_t valuestart = res.size();
 		if (asAtomHandler::isValid(replacer))
 		{
 			asAtom params[2];
@@ -1339,27 +1343,25 @@ tiny_string Vector::toJSON(std::vector<ASObject *> &path, asAtom replacer, const
 			asAtom funcret=asAtomHandler::invalidAtom;
 			asAtomHandler::callFunction(replacer,funcret,closure, params, 2,false);
 			if (asAtomHandler::isValid(funcret))
-				subres = asAtomHandler::toObject(funcret,getSystemState())->toJSON(path,asAtomHandler::invalidAtom,spaces,filter);
+				asAtomHandler::toObject(funcret,getSystemState())->toJSON(res,path,asAtomHandler::invalidAtom,spaces,filter);
 		}
 		else
 		{
-			subres = asAtomHandler::toObject(o,getSystemState())->toJSON(path,replacer,spaces,filter);
+			asAtomHandler::toObject(o,getSystemState())->toJSON(res,path,replacer,spaces,filter);
 		}
-		if (!subres.empty())
-		{
-			if (!bfirst)
-				res += ",";
-			res += newline+spaces;
-			
+		if (res.size() == valuestart)
+			res.resize(mark);
+		else
 			bfirst = false;
-			res += subres;
-		}
 	}
 	if (!bfirst)
-		res += newline+spaces.substr_bytes(0,spaces.numBytes()/2);
+	{
+		if (!spaces.empty())
+			res += "\n";
+		res.append(spaces.raw_buf(),spaces.numBytes()/2);
+	}
 	res += "]";
 	path.pop_back();
-	return res;
 }
 
 asAtom Vector::at(unsigned int index, asAtom defaultValue) const
@@ -45,16 +45,16 @@ void setDefaultXMLSettings()
 	prettyPrinting = true;
 }
 
-XML::XML(Class_base* c):ASObject(c,T_OBJECT,SUBTYPE_XML),parentNode(nullptr),nodetype((pugi::xml_node_type)0),isAttribute(false),nodenamespace_uri(BUILTIN_STRINGS::EMPTY),nodenamespace_prefix(BUILTIN_STRINGS::EMPTY),constructed(false)
+XML::XML(Class_base* c):ASObject(c,T_OBJECT,SUBTYPE_XML),parentNode(nullptr),nodetype((pugi::xml_node_type)0),isAttribute(false),nodenameid(BUILTIN_STRINGS::EMPTY),nodenamespace_uri(BUILTIN_STRINGS::EMPTY),nodenamespace_prefix(BUILTIN_STRINGS::EMPTY),constructed(false)
 {
 }
 
-XML::XML(Class_base* c, const std::string &str):ASObject(c,T_OBJECT,SUBTYPE_XML),parentNode(nullptr),nodetype((pugi::xml_node_type)0),isAttribute(false),nodenamespace_uri(BUILTIN_STRINGS::EMPTY),nodenamespace_prefix(BUILTIN_STRINGS::EMPTY),constructed(false)
+XML::XML(Class_base* c, const std::string &str):ASObject(c,T_OBJECT,SUBTYPE_XML),parentNode(nullptr),nodetype((pugi::xml_node_type)0),isAttribute(false),nodenameid(BUILTIN_STRINGS::EMPTY),nodenamespace_uri(BUILTIN_STRINGS::EMPTY),nodenamespace_prefix(BUILTIN_STRINGS::EMPTY),constructed(false)
 {
 	createTree(buildFromString(str, getParseMode()),false);
 }
 
-XML::XML(Class_base* c, const pugi::xml_node& _n, XML* parent, bool fromXMLList):ASObject(c,T_OBJECT,SUBTYPE_XML),parentNode(0),nodetype((pugi::xml_node_type)0),isAttribute(false),nodenamespace_uri(BUILTIN_STRINGS::EMPTY),nodenamespace_prefix(BUILTIN_STRINGS::EMPTY),constructed(false)
+XML::XML(Class_base* c, const pugi::xml_node& _n, XML* parent, bool fromXMLList):ASObject(c,T_OBJECT,SUBTYPE_XML),parentNode(0),nodetype((pugi::xml_node_type)0),isAttribute(false),nodenameid(BUILTIN_STRINGS::EMPTY),nodenamespace_uri(BUILTIN_STRINGS::EMPTY),nodenamespace_prefix(BUILTIN_STRINGS::EMPTY),constructed(false)
 {
 	if (parent)
 		parentNode = parent;
@@ -70,6 +70,7 @@ bool XML::destruct()
 	constructed = false;
 	childrenlist.reset();
 	nodename.clear();
+	nodenameid=BUILTIN_STRINGS::EMPTY;
 	nodevalue.clear();
 	nodenamespace_uri=BUILTIN_STRINGS::EMPTY;
 	nodenamespace_prefix=BUILTIN_STRINGS::EMPTY;
@@ -750,12 +751,13 @@ void XML::childrenImpl(XMLVector& ret, const tiny_string& name)
 {
 	if (!childrenlist.isNull())
 	{
-		for (uint32_t i = 0; i < childrenlist->nodes.size(); i++)
+		bool matchall = name=="*";
+		uint32_t nameid = matchall ? (uint32_t)BUILTIN_STRINGS::EMPTY : getSystemState()->getUniqueStringId(name);
+		for (auto it = childrenlist->nodes.cbegin(); it != childrenlist->nodes.cend(); ++it)
 		{
-			_R<XML> child= childrenlist->nodes[i];
-			if(name!="*" && child->nodename != name)
+			if(!matchall && (*it)->getNodeNameID() != nameid)
 				continue;
-			ret.push_back(child);
+			ret.push_back(*it);
 		}
 	}
 }
@@ -881,12 +883,12 @@ void XML::getElementNodes(const tiny_string& name, XMLVector& foundElements)
 {
 	if (childrenlist.isNull())
 		return;
-	for (uint32_t i = 0; i < childrenlist->nodes.size(); i++)
+	uint32_t nameid = name.empty() ? (uint32_t)BUILTIN_STRINGS::EMPTY : getSystemState()->getUniqueStringId(name);
+	for (auto it = childrenlist->nodes.cbegin(); it != childrenlist->nodes.cend(); ++it)
 	{
-		_R<XML> child= childrenlist->nodes[i];
-		if(child->nodetype==pugi::node_element && (name.empty() || name == child->nodename))
+		if((*it)->nodetype==pugi::node_element && (name.empty() || nameid == (*it)->getNodeNameID()))
 		{
-			foundElements.push_back( child );
+			foundElements.push_back( *it );
 		}
 	}
 }
@@ -1039,6 +1041,20 @@ ASFUNCTIONBODY_ATOM(XML,_setLocalName)
 	th->setLocalName(new_name);
 }
 
+void XML::setNodeName(const tiny_string& name)
+{
+	nodename = name;
+	nodenameid = UINT32_MAX;
+}
+
+uint32_t XML::getNodeNameID() const
+{
+	// the names are interned on the first lookup instead of while parsing
+	if (nodenameid == UINT32_MAX)
+		nodenameid = getSystemState()->getUniqueStringId(nodename);
+	return nodenameid;
+}
+
 void XML::setLocalName(const tiny_string& new_name)
 {
 	asAtom v =asAtomHandler::fromObject(abstract_s(getSystemState(),new_name));
@@ -1046,7 +1062,7 @@ void XML::setLocalName(const tiny_string& new_name)
 	{
 		throwError<TypeError>(kXMLInvalidName, new_name);
 	}
-	this->nodename = new_name;
+	setNodeName(new_name);
 	handleNotification("nameSet",asAtomHandler::fromObject(this),asAtomHandler::nullAtom);
 }
 
@@ -1259,31 +1275,36 @@ pugi::xml_node_type XML::getNodeKind() const
 
 
 void XML::getDescendantsByQName(const tiny_string& name, uint32_t ns, bool bIsAttribute, XMLVector& ret) const
+{
+	// the name is converted once, so that the tree walk only compares string ids
+	bool matchall = name=="" || name=="*";
+	uint32_t nameid = matchall ? (uint32_t)BUILTIN_STRINGS::EMPTY : getSystemState()->getUniqueStringId(name);
+	getDescendantsByQNameIntern(nameid, matchall, ns, bIsAttribute, ret);
+}
+
+void XML::getDescendantsByQNameIntern(uint32_t nameid, bool matchall, uint32_t ns, bool bIsAttribute, XMLVector& ret) const
 {
 	if (!constructed)
 		return;
 	if (bIsAttribute && !attributelist.isNull())
 	{
-		for (uint32_t i = 0; i < attributelist->nodes.size(); i++)
+		for (auto it = attributelist->nodes.cbegin(); it != attributelist->nodes.cend(); ++it)
 		{
-			
-			_R<XML> child= attributelist->nodes[i];
-			if(name=="" || name=="*" || (name == child->nodename && (ns == BUILTIN_STRINGS::STRING_WILDCARD || ns == child->nodenamespace_uri)))
+			if(matchall || (nameid == (*it)->getNodeNameID() && (ns == BUILTIN_STRINGS::STRING_WILDCARD || ns == (*it)->nodenamespace_uri)))
 			{
-				ret.push_back(child);
+				ret.push_back(*it);
 			}
 		}
 	}
 	if (childrenlist.isNull())
 		return;
-	for (uint32_t i = 0; i < childrenlist->nodes.size(); i++)
+	for (auto it = childrenlist->nodes.cbegin(); it != childrenlist->nodes.cend(); ++it)
 	{
-		_R<XML> child= childrenlist->nodes[i];
-		if(!bIsAttribute && (name=="" || name=="*" || (name == child->nodename && (ns == BUILTIN_STRINGS::STRING_WILDCARD || ns == child->nodenamespace_uri))))
+		if(!bIsAttribute && (matchall || (nameid == (*it)->getNodeNameID() && (ns == BUILTIN_STRINGS::STRING_WILDCARD || ns == (*it)->nodenamespace_uri))))
 		{
-			ret.push_back(child);
+			ret.push_back(*it);
 		}
-		child->getDescendantsByQName(name, ns, bIsAttribute, ret);
+		(*it)->getDescendantsByQNameIntern(nameid, matchall, ns, bIsAttribute, ret);
 	}
 }
 
@@ -1328,7 +1349,7 @@ XML::XMLVector XML::getAttributesByMultiname(const multiname& name, const tiny_s
 		}
 		++it;
 	}
-	const XMLList::XMLListVector nodes = attributelist->nodes;
+	const XMLList::XMLListVector& nodes = attributelist->nodes;
 	if (normalizedName.empty())
 	{
 		for (auto child = nodes.cbegin(); child != nodes.cend(); child++)
@@ -1363,11 +1384,12 @@ XML::XMLVector XML::getAttributesByMultiname(const multiname& name, const tiny_s
 	}
 	else
 	{
+		uint32_t nameid = getSystemState()->getUniqueStringId(normalizedName);
 		for (auto child = nodes.cbegin(); child != nodes.cend(); child++)
 		{
 			uint32_t childnamespace_uri = (*child)->nodenamespace_uri;
 			
-			bool bmatch =(normalizedName==(*child)->nodename) &&
+			bool bmatch =(nameid==(*child)->getNodeNameID()) &&
 						 ((namespace_uri.find(BUILTIN_STRINGS::STRING_WILDCARD)!= namespace_uri.end()) ||
 						  (namespace_uri.size() == 0 && childnamespace_uri == BUILTIN_STRINGS::EMPTY) ||
 						  (namespace_uri.find(childnamespace_uri) != namespace_uri.end())
@@ -1459,11 +1481,12 @@ XML::XMLVector XML::getValuesByMultiname(_NR<XMLList> nodelist, const multiname&
 	}
 	else
 	{
+		uint32_t nameid = getSystemState()->getUniqueStringId(normalizedName);
 		for (auto child = nodes.cbegin(); child != nodes.cend(); child++)
 		{
 			uint32_t childnamespace_uri = (*child)->nodenamespace_uri;
 			
-			bool bmatch = (normalizedName==(*child)->nodename) &&
+			bool bmatch = (nameid==(*child)->getNodeNameID()) &&
 						 (hasAnyNS||
 						  (namespace_uri.find(BUILTIN_STRINGS::STRING_WILDCARD)!= namespace_uri.end()) ||
 						  (namespace_uri.size() == 0 && childnamespace_uri == BUILTIN_STRINGS::EMPTY) ||
@@ -1649,7 +1672,7 @@ multiname* XML::setVariableByMultinameIntern(multiname& name, asAtom& o, CONST_A
 			tmp->parentNode = this;
 			tmp->nodetype = pugi::node_null;
 			tmp->isAttribute = true;
-			tmp->nodename = buf;
+			tmp->setNodeName(buf);
 			tmp->nodenamespace_uri = ns_uri;
 			tmp->nodenamespace_prefix = ns_prefix;
 			tmp->nodevalue = nodeval;
@@ -1688,7 +1711,7 @@ multiname* XML::setVariableByMultinameIntern(multiname& name, asAtom& o, CONST_A
 						if (replacetext)
 						{
 							tmpnode->nodetype = pugi::node_pcdata;
-							tmpnode->nodename = "text";
+							tmpnode->setNodeName("text");
 							tmpnode->nodenamespace_uri = BUILTIN_STRINGS::EMPTY;
 							tmpnode->nodenamespace_prefix = BUILTIN_STRINGS::EMPTY;
 							tmpnode->nodevalue = asAtomHandler::toString(o,getSystemState());
@@ -1699,7 +1722,7 @@ multiname* XML::setVariableByMultinameIntern(multiname& name, asAtom& o, CONST_A
 							tmp->parentNode = tmpnode.getPtr();
 							tmp->incRef();
 							tmp->nodetype = pugi::node_pcdata;
-							tmp->nodename = "text";
+							tmp->setNodeName("text");
 							tmp->nodenamespace_uri = BUILTIN_STRINGS::EMPTY;
 							tmp->nodenamespace_prefix = BUILTIN_STRINGS::EMPTY;
 							tmp->nodevalue = asAtomHandler::toString(o,getSystemState());
@@ -2898,6 +2921,7 @@ void XML::fillNode(XML* node, const pugi::xml_node &srcnode)
 			}
 		}
 	}
+	node->nodenameid = UINT32_MAX;
 	for(itattr = srcnode.attributes_begin();itattr!=srcnode.attributes_end();++itattr)
 	{
 		tiny_string aname = tiny_string(itattr->name(),true);
@@ -2940,6 +2964,7 @@ void XML::fillNode(XML* node, const pugi::xml_node &srcnode)
 				}
 			}
 		}
+		tmp->nodenameid = UINT32_MAX;
 		tmp->nodevalue = itattr->value();
 		tmp->constructed = true;
 		node->attributelist->nodes.push_back(tmp);
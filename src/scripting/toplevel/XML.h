@@ -38,6 +38,9 @@ private:
 	pugi::xml_node_type nodetype;
 	bool isAttribute;
 	tiny_string nodename;
+	// string id of nodename, used to compare names during lookups
+	// UINT32_MAX until the first lookup, so parsing a document doesn't intern the names of all nodes
+	mutable uint32_t nodenameid;
 	tiny_string nodevalue;
 	uint32_t nodenamespace_uri;
 	uint32_t nodenamespace_prefix;
@@ -66,6 +69,9 @@ private:
 	void childrenImpl(XMLVector& ret, uint32_t index);
 	uint32_t getNamespacePrefixByURI(uint32_t uri, bool create=false);
 	void setLocalName(const tiny_string& localname);
+	void setNodeName(const tiny_string& name);
+	uint32_t getNodeNameID() const;
+	void getDescendantsByQNameIntern(uint32_t nameid, bool matchall, uint32_t ns, bool bIsAttribute, XMLVector& ret) const;
 	void setNamespace(uint32_t ns_uri, uint32_t ns_prefix=BUILTIN_STRINGS::EMPTY);
 	void handleNotification(const tiny_string& command, asAtom value, asAtom detail);
 	// Append node or attribute to this. Concatenates adjacent
@@ -713,10 +713,12 @@ void XMLList::getTargetVariables(const multiname& name,XML::XMLVector& retnodes)
 		if(namespace_uri==BUILTIN_STRINGS::EMPTY)
 			namespace_uri=getVm(getSystemState())->getDefaultXMLNamespaceID();
 
+		bool matchall = normalizedName=="" || normalizedName=="*";
+		uint32_t nameid = matchall ? (uint32_t)BUILTIN_STRINGS::EMPTY : getSystemState()->getUniqueStringId(normalizedName);
 		for (uint32_t i = 0; i < nodes.size(); i++)
 		{
-			_R<XML> child= nodes[i];
-			bool nameMatches = (normalizedName=="" || normalizedName==child->nodename  || normalizedName=="*");
+			const _R<XML>& child= nodes[i];
+			bool nameMatches = (matchall || nameid==child->getNodeNameID());
 			bool nsMatches = (namespace_uri==BUILTIN_STRINGS::EMPTY || 
 							  (child->nodenamespace_uri == namespace_uri));
 
@@ -921,7 +923,7 @@ multiname* XMLList::setVariableByMultinameIntern(multiname& name, asAtom& o, CON
 			{
 				XML* tmp = Class<XML>::getInstanceSNoArgs(getSystemState());
 				tmp->nodetype = pugi::node_element;
-				tmp->nodename = targetproperty.normalizedName(getSystemState());
+				tmp->setNodeName(targetproperty.normalizedName(getSystemState()));
 				tmp->attributelist = _MR(Class<XMLList>::getInstanceSNoArgs(getSystemState()));
 				tmp->constructed = true;
 				tmp->setVariableByMultiname(name,o,allowConst);
@@ -931,7 +933,7 @@ multiname* XMLList::setVariableByMultinameIntern(multiname& name, asAtom& o, CON
 				{
 					XML* tmp2 = Class<XML>::getInstanceSNoArgs(getSystemState());
 					tmp2->nodetype = pugi::node_element;
-					tmp2->nodename = tmpname;
+					tmp2->setNodeName(tmpname);
 					tmp2->attributelist = _MR(Class<XMLList>::getInstanceSNoArgs(getSystemState()));
 					tmp2->constructed = true;
 					asAtom v = asAtomHandler::fromObject(tmp);
@@ -1009,10 +1011,12 @@ bool XMLList::deleteVariableByMultiname(const multiname& name)
 
 void XMLList::getDescendantsByQName(const tiny_string& name, uint32_t ns, bool bIsAttribute, XML::XMLVector& ret)
 {
+	bool matchall = name=="" || name=="*";
+	uint32_t nameid = matchall ? (uint32_t)BUILTIN_STRINGS::EMPTY : getSystemState()->getUniqueStringId(name);
 	auto it=nodes.begin();
 	for(; it!=nodes.end(); ++it)
 	{
-		(*it)->getDescendantsByQName(name, ns, bIsAttribute, ret);
+		(*it)->getDescendantsByQNameIntern(nameid, matchall, ns, bIsAttribute, ret);
 	}
 }
 
@@ -1160,7 +1164,7 @@ void XMLList::replace(unsigned int idx, ASObject *o, const XML::XMLVector &retno
 			{
 				nodes[idx]->childrenlist->clear();
 				nodes[idx]->nodetype = pugi::node_pcdata;
-				nodes[idx]->nodename = "text";
+				nodes[idx]->setNodeName("text");
 				nodes[idx]->nodevalue = o->toString();
 				nodes[idx]->nodenamespace_uri = BUILTIN_STRINGS::EMPTY;
 				nodes[idx]->nodenamespace_prefix = BUILTIN_STRINGS::EMPTY;
@@ -1171,7 +1175,7 @@ void XMLList::replace(unsigned int idx, ASObject *o, const XML::XMLVector &retno
 				_R<XML> tmp = _MR<XML>(Class<XML>::getInstanceSNoArgs(getSystemState()));
 				tmp->parentNode = nodes[idx].getPtr();
 				tmp->nodetype = pugi::node_pcdata;
-				tmp->nodename = "text";
+				tmp->setNodeName("text");
 				tmp->nodenamespace_uri = BUILTIN_STRINGS::EMPTY;
 				tmp->nodenamespace_prefix = BUILTIN_STRINGS::EMPTY;
 				tmp->nodevalue = o->toString();
@@ -1191,7 +1195,7 @@ void XMLList::replace(unsigned int idx, ASObject *o, const XML::XMLVector &retno
 		{
 			nodes[idx]->childrenlist->clear();
 			nodes[idx]->nodetype = pugi::node_pcdata;
-			nodes[idx]->nodename = "text";
+			nodes[idx]->setNodeName("text");
 			nodes[idx]->nodevalue = o->toString();
 			nodes[idx]->nodenamespace_uri = BUILTIN_STRINGS::EMPTY;
 			nodes[idx]->nodenamespace_prefix = BUILTIN_STRINGS::EMPTY;
@@ -1206,7 +1210,7 @@ void XMLList::replace(unsigned int idx, ASObject *o, const XML::XMLVector &retno
 				_R<XML> tmp = _MR<XML>(Class<XML>::getInstanceSNoArgs(getSystemState()));
 				tmp->parentNode = nodes[idx].getPtr();
 				tmp->nodetype = pugi::node_pcdata;
-				tmp->nodename = "text";
+				tmp->setNodeName("text");
 				tmp->nodenamespace_uri = BUILTIN_STRINGS::EMPTY;
 				tmp->nodenamespace_prefix = BUILTIN_STRINGS::EMPTY;
 				tmp->nodevalue = o->toString();
@@ -448,6 +448,7 @@ void SyntheticFunction::call(asAtom& ret, asAtom& obj, asAtom *args, uint32_t nu
 	cc->parent_scope_stack=func_scope.getPtr();
 	cc->defaultNamespaceUri = saved_cc ? saved_cc->defaultNamespaceUri : (uint32_t)BUILTIN_STRINGS::EMPTY;
 	cc->inClass = this->inClass;
+	cc->applicationdomain = mi->context->root->applicationDomain.getPtr();
 	cc->stackp = cc->stack;
 
 	/* Set the current global object, each script in each DoABCTag has its own */
@@ -1291,6 +1292,14 @@ void Class_base::handleConstruction(asAtom& target, asAtom* args, unsigned int a
 	if(buildAndLink)
 	{
 		asAtomHandler::getObject(target)->afterConstruction();
+		//The constructors of the super classes are handled with buildAndLink==false, so only the most derived class is recorded
+		ABCVm* vm=getVm(getSystemState());
+		if(USUALLY_FALSE(vm->sampler!=nullptr) && vm->sampler->isRunning() && isVmThread())
+		{
+			//Only a rough estimate of the memory used by the object
+			ASObject* o=asAtomHandler::getObject(target);
+			vm->sampler->objectConstructed(vm,this,sizeof(ASObject)+o->numVariables()*sizeof(variable));
+		}
 	}
 }
 
@@ -2782,7 +2791,11 @@ number_t lightspark::parseNumber(const tiny_string str, bool useoldversion)
 			return numeric_limits<double>::quiet_NaN();
 		return d;
 	}
-	double d=strtod(p, &end);
+	number_t d;
+	const char* fastend;
+	if (Number::parseDecimalFast(p,&fastend,d))
+		return d;
+	d=strtod(p, &end);
 
 	if (end==p)
 		return numeric_limits<double>::quiet_NaN();
@@ -153,18 +153,67 @@ const URLInfo& RootMovieClip::getBaseURL()
 		return origin;
 }
 
-void SystemState::registerFrameListener(_R<DisplayObject> obj)
+void SystemState::registerFrameListener(_R<DisplayObject> obj, BROADCAST_EVENT type)
 {
 	Locker l(mutexFrameListeners);
-	if (frameListeners.find(obj) != frameListeners.end())
-		return;
-	frameListeners.insert(obj);
+	frameListeners[type].insert(obj);
+}
+
+void SystemState::unregisterFrameListener(_R<DisplayObject> obj, BROADCAST_EVENT type)
+{
+	Locker l(mutexFrameListeners);
+	frameListeners[type].erase(obj);
+}
+
+void SystemState::requestRenderEvent()
+{
+	Locker l(mutexFrameListeners);
+	renderEventRequested=true;
+}
+
+bool SystemState::getBroadcastEventType(uint32_t eventNameID, BROADCAST_EVENT& type)
+{
+	switch (eventNameID)
+	{
+		case BUILTIN_STRINGS::STRING_ENTERFRAME:
+			type = BROADCAST_ENTERFRAME;
+			return true;
+		case BUILTIN_STRINGS::STRING_FRAMECONSTRUCTED:
+			type = BROADCAST_FRAMECONSTRUCTED;
+			return true;
+		case BUILTIN_STRINGS::STRING_EXITFRAME:
+			type = BROADCAST_EXITFRAME;
+			return true;
+		case BUILTIN_STRINGS::STRING_RENDER:
+			type = BROADCAST_RENDER;
+			return true;
+		default:
+			return false;
+	}
 }
 
-void SystemState::unregisterFrameListener(_R<DisplayObject> obj)
+void SystemState::dispatchBroadcastEvent(BROADCAST_EVENT type, const tiny_string& eventName)
 {
 	Locker l(mutexFrameListeners);
-	frameListeners.erase(obj);
+	if (type == BROADCAST_RENDER)
+	{
+		if (!renderEventRequested)
+			return;
+		renderEventRequested=false;
+	}
+	std::set<_R<DisplayObject>>& listeners = frameListeners[type];
+	if(listeners.empty())
+		return;
+	_NR<Event>& e = broadcastEvents[type];
+	if (!e.isNull() && e->isLastRef())
+		e->recycle();
+	else
+		e = _MNR(Class<Event>::getInstanceS(this,eventName));
+	for(auto it=listeners.begin();it!=listeners.end();it++)
+	{
+		e->incRef();
+		getVm(this)->addEvent(*it,_MR(e.getPtr()));
+	}
 }
 
 RootMovieClip* RootMovieClip::getInstance(_NR<LoaderInfo> li, _R<ApplicationDomain> appDomain, _R<SecurityDomain> secDomain)
@@ -208,7 +257,8 @@ static const char* builtinStrings[] = {"any", "void", "prototype", "Function", "
 									   "_target","this","_root","_parent","_global","super",
 									   "onEnterFrame","onMouseMove","onMouseDown","onMouseUp","onPress","onRelease","onReleaseOutside","onMouseWheel","onLoad",
 									   "object","undefined","boolean","number","string","function","onRollOver","onRollOut",
-									   "__proto__","target","flash.events:IEventDispatcher","addEventListener","removeEventListener","dispatchEvent","hasEventListener"
+									   "__proto__","target","flash.events:IEventDispatcher","addEventListener","removeEventListener","dispatchEvent","hasEventListener",
+									   "enterFrame","frameConstructed","exitFrame","render"
 									  };
 
 extern uint32_t asClassCount;
@@ -218,7 +268,7 @@ SystemState::SystemState(uint32_t fileSize, FLASH_MODE mode):
 	renderThread(nullptr),inputThread(nullptr),engineData(nullptr),dumpedSWFPathAvailable(0),
 	vmVersion(VMNONE),childPid(0),
 	parameters(NullRef),
-	invalidateQueueHead(NullRef),invalidateQueueTail(NullRef),lastUsedStringId(0),lastUsedNamespaceId(0x7fffffff),
+	renderEventRequested(false),invalidateQueueHead(NullRef),invalidateQueueTail(NullRef),lastUsedStringId(0),lastUsedNamespaceId(0x7fffffff),
 	showProfilingData(false),allowFullscreen(false),flashMode(mode),swffilesize(fileSize),avm1global(nullptr),
 	currentVm(nullptr),builtinClasses(nullptr),useInterpreter(true),useFastInterpreter(false),useJit(false),ignoreUnhandledExceptions(false),exitOnError(ERROR_NONE),singleworker(true),
 	downloadManager(nullptr),extScriptObject(nullptr),scaleMode(SHOW_ALL),unaccountedMemory(nullptr),tagsMemory(nullptr),stringMemory(nullptr),textTokenMemory(nullptr),shapeTokenMemory(nullptr),morphShapeTokenMemory(nullptr),bitmapTokenMemory(nullptr),spriteTokenMemory(nullptr),
@@ -307,6 +357,7 @@ SystemState::SystemState(uint32_t fileSize, FLASH_MODE mode):
 	static_SoundMixer_soundTransform->setRefConstant();
 	threadPool=new ThreadPool(this);
 	downloadThreadPool=new ThreadPool(this);
+	soundThreadPool=new ThreadPool(this);
 
 	timerThread=new TimerThread(this);
 	frameTimerThread=new TimerThread(this);
@@ -506,6 +557,8 @@ void SystemState::stopEngines()
 {
 	if(downloadThreadPool)
 		downloadThreadPool->forceStop();
+	if(soundThreadPool)
+		soundThreadPool->forceStop();
 	if(threadPool)
 		threadPool->forceStop();
 	timerThread->wait();
@@ -525,6 +578,8 @@ void SystemState::stopEngines()
 	threadPool=nullptr;
 	delete downloadThreadPool;
 	downloadThreadPool=nullptr;
+	delete soundThreadPool;
+	soundThreadPool=nullptr;
 	//Now stop the managers
 	delete audioManager;
 	audioManager=nullptr;
@@ -589,7 +644,11 @@ void SystemState::systemFinalize()
 	invalidateQueueTail.reset();
 	parameters.reset();
 	static_SoundMixer_soundTransform.reset();
-	frameListeners.clear();
+	for (uint32_t i = 0; i < BROADCAST_EVENT_COUNT; i++)
+	{
+		frameListeners[i].clear();
+		broadcastEvents[i].reset();
+	}
 	for(auto it = sharedobjectmap.begin(); it != sharedobjectmap.end(); it++)
 		it->second->doFlush();
 	sharedobjectmap.clear();
@@ -660,6 +719,8 @@ void SystemState::destroy()
 	//The thread pool should be stopped before everything
 	if(downloadThreadPool)
 		downloadThreadPool->forceStop();
+	if(soundThreadPool)
+		soundThreadPool->forceStop();
 	if(threadPool)
 		threadPool->forceStop();
 	stopEngines();
@@ -1142,6 +1203,10 @@ void SystemState::addDownloadJob(IThreadJob* j)
 {
 	downloadThreadPool->addJob(j);
 }
+void SystemState::addSoundJob(IThreadJob* j)
+{
+	soundThreadPool->addJob(j);
+}
 
 void SystemState::addTick(uint32_t tickTime, ITickJob* job)
 {
@@ -1232,7 +1297,8 @@ void SystemState::flushInvalidationQueue()
 						}
 						drawJobsNew.insert(j);
 					}
-					addJob(j);
+					// draw jobs are needed for the next frame, so they go ahead of parsing and decoding jobs
+					threadPool->addJob(j,THREADPOOL_PRIORITY_HIGH);
 					drawjobLock.unlock();
 				}
 				else
@@ -2082,18 +2148,7 @@ void SystemState::tick()
 	}
 
 	/* Step 2: Send enterFrame events, if needed */
-	{
-		Locker l(mutexFrameListeners);
-		if(!frameListeners.empty())
-		{
-			_R<Event> e(Class<Event>::getInstanceS(this,"enterFrame"));
-			auto it=frameListeners.begin();
-			for(;it!=frameListeners.end();it++)
-			{
-				getVm(this)->addEvent(*it,e);
-			}
-		}
-	}
+	dispatchBroadcastEvent(BROADCAST_ENTERFRAME,"enterFrame");
 
 	/* Step 3: create legacy objects, which are new in this frame (top-down),
 	 * run their constructors (bottom-up) */
@@ -2101,36 +2156,15 @@ void SystemState::tick()
 	currentVm->addEvent(NullRef, _MR(new (unaccountedMemory) InitFrameEvent(_MR(stage))));
 
 	/* Step 4: dispatch frameConstructed events */
-	{
-		Locker l(mutexFrameListeners);
-		if(!frameListeners.empty())
-		{
-			_R<Event> e(Class<Event>::getInstanceS(this,"frameConstructed"));
-			auto it=frameListeners.begin();
-			for(;it!=frameListeners.end();it++)
-			{
-				getVm(this)->addEvent(*it,e);
-			}
-		}
-	}
+	dispatchBroadcastEvent(BROADCAST_FRAMECONSTRUCTED,"frameConstructed");
 	/* Step 5: run all frameScripts (bottom-up) */
 	stage->incRef();
 	currentVm->addEvent(NullRef, _MR(new (unaccountedMemory) ExecuteFrameScriptEvent(_MR(stage))));
 
 	/* Step 6: dispatch exitFrame event */
-	{
-		Locker l(mutexFrameListeners);
-		if(!frameListeners.empty())
-		{
-			_R<Event> e(Class<Event>::getInstanceS(this,"exitFrame"));
-			auto it=frameListeners.begin();
-			for(;it!=frameListeners.end();it++)
-			{
-				getVm(this)->addEvent(*it,e);
-			}
-		}
-	}
-	/* TODO: Step 7: dispatch render event (Assuming stage.invalidate() has been called) */
+	dispatchBroadcastEvent(BROADCAST_EXITFRAME,"exitFrame");
+	/* Step 7: dispatch render event (Assuming stage.invalidate() has been called) */
+	dispatchBroadcastEvent(BROADCAST_RENDER,"render");
 
 	/* Step 9: we are idle now, so we can handle all input events */
 	_R<IdleEvent> idle = _MR(new (unaccountedMemory) IdleEvent());
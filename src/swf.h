@@ -185,6 +185,9 @@ public:
 	void plot(uint32_t max, cairo_t *cr);
 };
 
+// events that are sent to every display object listening for them on each frame
+enum BROADCAST_EVENT { BROADCAST_ENTERFRAME=0, BROADCAST_FRAMECONSTRUCTED, BROADCAST_EXITFRAME, BROADCAST_RENDER, BROADCAST_EVENT_COUNT };
+
 class SystemState: public ITickJob, public InvalidateQueue
 {
 private:
@@ -198,6 +201,7 @@ private:
 	friend class SystemState::EngineCreator;
 	ThreadPool* threadPool;
 	ThreadPool* downloadThreadPool;
+	ThreadPool* soundThreadPool;
 	TimerThread* timerThread;
 	TimerThread* frameTimerThread;
 	Semaphore terminated;
@@ -263,7 +267,13 @@ private:
 	Mutex profileDataSpinlock;
 
 	Mutex mutexFrameListeners;
-	std::set<_R<DisplayObject>> frameListeners;
+	// one set of subscribed display objects per broadcast event
+	std::set<_R<DisplayObject>> frameListeners[BROADCAST_EVENT_COUNT];
+	// set by Stage.invalidate(), the render event is only sent on frames where this is true
+	bool renderEventRequested;
+	// events sent for the broadcasts, reused on the next frame if no one else kept a reference
+	_NR<Event> broadcastEvents[BROADCAST_EVENT_COUNT];
+	void dispatchBroadcastEvent(BROADCAST_EVENT type, const tiny_string& eventName);
 	/*
 	   The head of the invalidate queue
 	*/
@@ -286,6 +296,10 @@ private:
 	*/
 	tiny_string profOut;
 #endif
+	/*
+	   Output file for the stacks collected by the ActionScript sampler
+	*/
+	tiny_string samplingOut;
 #ifdef MEMORY_USAGE_PROFILING
 	mutable Mutex memoryAccountsMutex;
 	std::list<MemoryAccount> memoryAccounts;
@@ -439,6 +453,9 @@ public:
 	// downloaders may be executed from inside a job from the main threadpool,
 	// so we use a second threadpool for them, to avoid deadlocks
 	void addDownloadJob(IThreadJob* j) DLL_PUBLIC;
+	// sound decoding jobs may block while waiting for downloaded data, so they get their own
+	// threadpool and don't starve the jobs of the main threadpool
+	void addSoundJob(IThreadJob* j);
 	void addTick(uint32_t tickTime, ITickJob* job);
 	void addFrameTick(uint32_t tickTime, ITickJob* job);
 	void addWait(uint32_t waitTime, ITickJob* job);
@@ -482,9 +499,12 @@ public:
 	ObjectEncoding::ENCODING staticSharedObjectDefaultObjectEncoding;
 	bool staticSharedObjectPreventBackup;
 	
-	//enterFrame event management
-	void registerFrameListener(_R<DisplayObject> clip);
-	void unregisterFrameListener(_R<DisplayObject> clip);
+	//enterFrame/frameConstructed/exitFrame/render event management
+	void registerFrameListener(_R<DisplayObject> clip, BROADCAST_EVENT type=BROADCAST_ENTERFRAME);
+	void unregisterFrameListener(_R<DisplayObject> clip, BROADCAST_EVENT type=BROADCAST_ENTERFRAME);
+	void requestRenderEvent();
+	// returns true if the event name is one of the broadcast events
+	static bool getBroadcastEventType(uint32_t eventNameID, BROADCAST_EVENT& type);
 
 	//Invalidation queue management
 	void addToInvalidateQueue(_R<DisplayObject> d) override;
@@ -505,6 +525,8 @@ public:
 	std::vector<ABCContext*> contextes;
 	void saveProfilingInformation();
 #endif
+	void setSamplingOutput(const tiny_string& t) DLL_PUBLIC { samplingOut=t; }
+	const tiny_string& getSamplingOutput() const { return samplingOut; }
 	MemoryAccount* allocateMemoryAccount(const tiny_string& name) DLL_PUBLIC;
 	MemoryAccount* unaccountedMemory;
 	MemoryAccount* tagsMemory;
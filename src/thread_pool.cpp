@@ -26,15 +26,20 @@
 
 using namespace lightspark;
 
-ThreadPool::ThreadPool(SystemState* s):num_jobs(0),stopFlag(false)
+ThreadPool::ThreadPool(SystemState* s):num_jobs(0),runningThreads(0),idleThreads(0),stopFlag(false)
 {
 	m_sys=s;
 	for(uint32_t i=0;i<NUM_THREADS;i++)
 	{
 		curJobs[i]=nullptr;
+		threads[i]=nullptr;
 		data[i].index=i;
 		data[i].pool = this;
-		threads[i] = SDL_CreateThread(job_worker,"ThreadPool",&data[i]);
+	}
+	for(uint32_t i=0;i<THREADPOOL_PRIORITY_COUNT;i++)
+	{
+		jobsStarted[i]=0;
+		jobsWaitTime[i]=0;
 	}
 }
 
@@ -42,15 +47,13 @@ void ThreadPool::forceStop()
 {
 	if(!stopFlag)
 	{
-		stopFlag=true;
-		//Signal an event for all the threads
-		for(int i=0;i<NUM_THREADS;i++)
-			num_jobs.signal();
-
+		uint32_t numThreads;
 		{
 			Locker l(mutex);
+			stopFlag=true;
+			numThreads=runningThreads;
 			//Now abort any job that is still executing
-			for(int i=0;i<NUM_THREADS;i++)
+			for(uint32_t i=0;i<numThreads;i++)
 			{
 				if(curJobs[i])
 				{
@@ -59,13 +62,21 @@ void ThreadPool::forceStop()
 				}
 			}
 			//Fence all the non executed jobs
-			std::deque<IThreadJob*>::iterator it=jobs.begin();
-			for(;it!=jobs.end();++it)
-				(*it)->jobFence();
-			jobs.clear();
+			for(uint32_t p=0;p<THREADPOOL_PRIORITY_COUNT;p++)
+			{
+				std::deque<QueuedJob>::iterator it=jobs[p].begin();
+				for(;it!=jobs[p].end();++it)
+					it->job->jobFence();
+				jobs[p].clear();
+				if(jobsStarted[p])
+					LOG(LOG_INFO,"ThreadPool: "<<jobsStarted[p]<<" jobs with priority "<<p<<", average queue time "<<jobsWaitTime[p]/jobsStarted[p]<<"us");
+			}
 		}
+		//Signal an event for all the threads
+		for(uint32_t i=0;i<numThreads;i++)
+			num_jobs.signal();
 
-		for(int i=0;i<NUM_THREADS;i++)
+		for(uint32_t i=0;i<numThreads;i++)
 		{
 			SDL_WaitThread(threads[i],nullptr);
 		}
@@ -94,9 +105,20 @@ int ThreadPool::job_worker(void *d)
 		if(data->pool->stopFlag)
 			return 0;
 		Locker l(data->pool->mutex);
-		IThreadJob* myJob=data->pool->jobs.front();
-		data->pool->jobs.pop_front();
+		if(data->pool->stopFlag)
+			return 0;
+		//Take the oldest job of the highest priority
+		uint32_t priority=0;
+		while(data->pool->jobs[priority].empty())
+			priority++;
+		assert(priority<THREADPOOL_PRIORITY_COUNT);
+		QueuedJob queued=data->pool->jobs[priority].front();
+		data->pool->jobs[priority].pop_front();
+		IThreadJob* myJob=queued.job;
 		data->pool->curJobs[data->index]=myJob;
+		data->pool->idleThreads--;
+		data->pool->jobsStarted[priority]++;
+		data->pool->jobsWaitTime[priority]+=g_get_monotonic_time()-queued.queuetime;
 		l.release();
 
 		chronometer.checkpoint();
@@ -126,6 +148,7 @@ int ThreadPool::job_worker(void *d)
 
 		l.acquire();
 		data->pool->curJobs[data->index]=nullptr;
+		data->pool->idleThreads++;
 		l.release();
 
 		//jobFencing is allowed to happen outside the mutex
@@ -134,7 +157,7 @@ int ThreadPool::job_worker(void *d)
 	return 0;
 }
 
-void ThreadPool::addJob(IThreadJob* j)
+void ThreadPool::addJob(IThreadJob* j, THREADPOOL_PRIORITY priority)
 {
 	Locker l(mutex);
 	if(stopFlag)
@@ -143,7 +166,24 @@ void ThreadPool::addJob(IThreadJob* j)
 		return;
 	}
 	assert(j);
-	jobs.push_back(j);
+	QueuedJob queued;
+	queued.job=j;
+	queued.queuetime=g_get_monotonic_time();
+	jobs[priority].push_back(queued);
+	//Start another worker if there are more waiting jobs than idle workers
+	uint32_t waiting=0;
+	for(uint32_t p=0;p<THREADPOOL_PRIORITY_COUNT;p++)
+		waiting+=jobs[p].size();
+	if(waiting>idleThreads && runningThreads<NUM_THREADS)
+	{
+		threads[runningThreads] = SDL_CreateThread(job_worker,"ThreadPool",&data[runningThreads]);
+		if(threads[runningThreads])
+		{
+			runningThreads++;
+			idleThreads++;
+		}
+		else
+			LOG(LOG_ERROR,"ThreadPool: unable to create worker thread:"<<SDL_GetError());
+	}
 	num_jobs.signal();
 }
-
@@ -32,6 +32,9 @@ namespace lightspark
 
 class SystemState;
 
+// jobs with a higher priority are started before any waiting job of a lower priority
+enum THREADPOOL_PRIORITY { THREADPOOL_PRIORITY_HIGH=0, THREADPOOL_PRIORITY_NORMAL, THREADPOOL_PRIORITY_COUNT };
+
 class ThreadPool
 {
 private:
@@ -40,19 +43,33 @@ private:
 		ThreadPool* pool;
 		int index;
 	};
+	struct QueuedJob
+	{
+		IThreadJob* job;
+		int64_t queuetime;
+	};
 	Mutex mutex;
 	SDL_Thread* threads[NUM_THREADS];
 	ThreadPoolData data[NUM_THREADS];
 	IThreadJob* volatile curJobs[NUM_THREADS];
-	std::deque<IThreadJob*> jobs;
+	std::deque<QueuedJob> jobs[THREADPOOL_PRIORITY_COUNT];
 	Semaphore num_jobs;
+	/*
+	 * Worker threads are only started when a job is added and all running
+	 * workers are busy, so long running jobs don't delay the others
+	 */
+	uint32_t runningThreads;
+	uint32_t idleThreads;
+	// number of jobs started and total time they waited in the queue (in microseconds)
+	uint64_t jobsStarted[THREADPOOL_PRIORITY_COUNT];
+	uint64_t jobsWaitTime[THREADPOOL_PRIORITY_COUNT];
 	static int job_worker(void* d);
 	SystemState* m_sys;
 	volatile bool stopFlag;
 public:
 	ThreadPool(SystemState* s);
 	~ThreadPool();
-	void addJob(IThreadJob* j);
+	void addJob(IThreadJob* j, THREADPOOL_PRIORITY priority=THREADPOOL_PRIORITY_NORMAL);
 	void forceStop();
 };
 
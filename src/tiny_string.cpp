@@ -23,7 +23,15 @@
 
 using namespace lightspark;
 
-tiny_string::tiny_string(std::istream& in, int len):buf(_buf_static),stringSize(len+1),type(STATIC)
+//DYNAMIC buffers start with the reference count, the string data follows at this offset
+#define BUFFER_HEADER_SIZE 8
+
+static inline std::atomic<uint32_t>* bufferRefCount(char* buf)
+{
+	return reinterpret_cast<std::atomic<uint32_t>*>(buf-BUFFER_HEADER_SIZE);
+}
+
+tiny_string::tiny_string(std::istream& in, int len):buf(_buf_static),stringSize(len+1),bufferSize(0),charposcache(0),type(STATIC)
 {
 	if(stringSize > STATIC_SIZE)
 		createBuffer(stringSize);
@@ -32,7 +40,7 @@ tiny_string::tiny_string(std::istream& in, int len):buf(_buf_static),stringSize(
 	init();
 }
 
-tiny_string::tiny_string(const char* s,bool copy):_buf_static(),buf(_buf_static),type(READONLY)
+tiny_string::tiny_string(const char* s,bool copy):_buf_static(),buf(_buf_static),bufferSize(0),charposcache(0),type(READONLY)
 {
 	if(copy)
 		makePrivateCopy(s);
@@ -45,7 +53,7 @@ tiny_string::tiny_string(const char* s,bool copy):_buf_static(),buf(_buf_static)
 }
 
 tiny_string::tiny_string(const tiny_string& r):
-	_buf_static(),buf(_buf_static),stringSize(r.stringSize),numchars(r.numchars),type(STATIC),isASCII(r.isASCII),hasNull(r.hasNull)
+	_buf_static(),buf(_buf_static),stringSize(r.stringSize),bufferSize(0),numchars(r.numchars),charposcache(r.charposcache.load(std::memory_order_relaxed)),type(STATIC),isASCII(r.isASCII),hasNull(r.hasNull)
 {
 	//Fast path for static read-only strings
 	if(r.type==READONLY)
@@ -55,11 +63,15 @@ tiny_string::tiny_string(const tiny_string& r):
 		return;
 	}
 	if(stringSize > STATIC_SIZE)
-		createBuffer(stringSize);
+	{
+		//r has a dynamic buffer, share it
+		shareBuffer(r);
+		return;
+	}
 	memcpy(buf,r.buf,stringSize);
 }
 
-tiny_string::tiny_string(const std::string& r):_buf_static(),buf(_buf_static),stringSize(r.size()+1),type(STATIC)
+tiny_string::tiny_string(const std::string& r):_buf_static(),buf(_buf_static),stringSize(r.size()+1),bufferSize(0),charposcache(0),type(STATIC)
 {
 	if(stringSize > STATIC_SIZE)
 		createBuffer(stringSize);
@@ -74,6 +86,8 @@ tiny_string::~tiny_string()
 
 tiny_string& tiny_string::operator=(const tiny_string& s)
 {
+	if(&s==this)
+		return *this;
 	resetToStatic();
 	stringSize=s.stringSize;
 	//Fast path for static read-only strings
@@ -82,15 +96,14 @@ tiny_string& tiny_string::operator=(const tiny_string& s)
 		type=READONLY;
 		buf=s.buf;
 	}
+	else if(stringSize > STATIC_SIZE)
+		shareBuffer(s);
 	else
-	{
-		if(stringSize > STATIC_SIZE)
-			createBuffer(stringSize);
 		memcpy(buf,s.buf,stringSize);
-	}
 	this->isASCII = s.isASCII;
 	this->hasNull = s.hasNull;
 	this->numchars = s.numchars;
+	this->charposcache.store(s.charposcache.load(std::memory_order_relaxed),std::memory_order_relaxed);
 	return *this;
 }
 
@@ -121,14 +134,7 @@ tiny_string& tiny_string::operator+=(const char* s)
 	}
 	uint32_t addedLen=strlen(s);
 	uint32_t newStringSize=stringSize + addedLen;
-	if(type==STATIC && newStringSize > STATIC_SIZE)
-	{
-		createBuffer(newStringSize);
-		//don't copy trailing \0
-		memcpy(buf,_buf_static,stringSize-1);
-	}
-	else if(type==DYNAMIC && addedLen!=0)
-		resizeBuffer(newStringSize);
+	reserveForAppend(newStringSize);
 	//also copy \0 at the end
 	memcpy(buf+stringSize-1,s,addedLen+1);
 	stringSize=newStringSize;
@@ -144,14 +150,7 @@ tiny_string& tiny_string::operator+=(const tiny_string& r)
 		makePrivateCopy(tmp);
 	}
 	uint32_t newStringSize=stringSize + r.stringSize-1;
-	if(type==STATIC && newStringSize > STATIC_SIZE)
-	{
-		createBuffer(newStringSize);
-		//don't copy trailing \0
-		memcpy(buf,_buf_static,stringSize-1);
-	}
-	else if(type==DYNAMIC && r.stringSize>1)
-		resizeBuffer(newStringSize);
+	reserveForAppend(newStringSize);
 	//start position is where the \0 was
 	memcpy(buf+stringSize-1,r.buf,r.stringSize);
 	stringSize=newStringSize;
@@ -290,13 +289,24 @@ bool tiny_string::endsWith(const char* o) const
  * returns index of character */
 uint32_t tiny_string::find(const tiny_string& needle, uint32_t start) const
 {
-	//TODO: omit copy into std::string
-	size_t bytestart = g_utf8_offset_to_pointer(buf,start) - buf;
-	size_t bytepos = std::string(*this).find(needle.raw_buf(),bytestart,needle.numBytes());
-	if(bytepos == std::string::npos)
+	if(start > numChars())
 		return npos;
-	else
-		return g_utf8_pointer_to_offset(buf,buf+bytepos);
+	uint32_t bytestart = charToBytePos(start);
+	uint32_t needlesize = needle.numBytes();
+	if(needlesize == 0)
+		return start;
+	const char* end = buf+numBytes();
+	const char* p = buf+bytestart;
+	while(p+needlesize <= end)
+	{
+		p = (const char*)memchr(p,needle.buf[0],end-p-needlesize+1);
+		if(p == nullptr)
+			break;
+		if(memcmp(p,needle.buf,needlesize) == 0)
+			return bytePosToIndex(p-buf);
+		p++;
+	}
+	return npos;
 }
 
 uint32_t tiny_string::rfind(const tiny_string& needle, uint32_t start) const
@@ -306,13 +316,13 @@ uint32_t tiny_string::rfind(const tiny_string& needle, uint32_t start) const
 	if(start == npos)
 		bytestart = std::string::npos;
 	else
-		bytestart = g_utf8_offset_to_pointer(buf,start) - buf;
+		bytestart = charToBytePos(start);
 
 	size_t bytepos = std::string(*this).rfind(needle.raw_buf(),bytestart,needle.numBytes());
 	if(bytepos == std::string::npos)
 		return npos;
 	else
-		return g_utf8_pointer_to_offset(buf,buf+bytepos);
+		return bytePosToIndex(bytepos);
 }
 
 void tiny_string::makePrivateCopy(const char* s)
@@ -328,27 +338,66 @@ void tiny_string::createBuffer(uint32_t s)
 {
 	type=DYNAMIC;
 	reportMemoryChange(s);
-	buf=new char[s];
+	char* mem=new char[s+BUFFER_HEADER_SIZE];
+	new (mem) std::atomic<uint32_t>(1);
+	buf=mem+BUFFER_HEADER_SIZE;
+	bufferSize=s;
 }
 
 void tiny_string::resizeBuffer(uint32_t s)
 {
 	assert(type==DYNAMIC);
-	char* oldBuf=buf;
-	reportMemoryChange(s-stringSize);
-	buf=new char[s];
 	assert(s >= stringSize);
+	char* oldBuf=buf;
+	uint32_t oldBufferSize=bufferSize;
+	createBuffer(s);
 	memcpy(buf,oldBuf,stringSize);
-	delete[] oldBuf;
+	releaseBuffer(oldBuf,oldBufferSize);
 }
 
-void tiny_string::resetToStatic()
+void tiny_string::shareBuffer(const tiny_string& r)
 {
-	if(type==DYNAMIC)
+	assert(r.type==DYNAMIC);
+	bufferRefCount(r.buf)->fetch_add(1,std::memory_order_relaxed);
+	type=DYNAMIC;
+	buf=r.buf;
+	bufferSize=r.bufferSize;
+}
+
+void tiny_string::releaseBuffer(char* b, uint32_t size)
+{
+	if(bufferRefCount(b)->fetch_sub(1,std::memory_order_acq_rel)==1)
+	{
+		reportMemoryChange(-size);
+		delete[] (b-BUFFER_HEADER_SIZE);
+	}
+}
+
+void tiny_string::reserveForAppend(uint32_t newStringSize)
+{
+	if(type==STATIC && newStringSize > STATIC_SIZE)
+	{
+		createBuffer(newStringSize);
+		//don't copy trailing \0
+		memcpy(buf,_buf_static,stringSize-1);
+	}
+	else if(type==DYNAMIC && newStringSize > bufferSize)
+	{
+		//grow geometrically, so that building a string by repeated appending is not quadratic
+		resizeBuffer(std::max(newStringSize,bufferSize+bufferSize/2));
+	}
+	else if(type==DYNAMIC && bufferRefCount(buf)->load(std::memory_order_acquire)!=1)
 	{
-		reportMemoryChange(-stringSize);
-		delete[] buf;
+		//the buffer is shared with other strings, make a private copy before modifying it
+		resizeBuffer(bufferSize);
 	}
+}
+
+void tiny_string::resetToStatic()
+{
+	if(type==DYNAMIC)
+		releaseBuffer(buf,bufferSize);
+	charposcache.store(0,std::memory_order_relaxed);
 	stringSize=1;
 	_buf_static[0] = '\0';
 	buf=_buf_static;
@@ -357,6 +406,7 @@ void tiny_string::resetToStatic()
 
 void tiny_string::init()
 {
+	charposcache.store(0,std::memory_order_relaxed);
 	numchars = 0;
 	isASCII = true;
 	hasNull = false;
@@ -412,8 +462,8 @@ tiny_string& tiny_string::replace(uint32_t pos1, uint32_t n1, const tiny_string&
 		n1 = numChars()-pos1;
 	if (isASCII)
 		return replace_bytes(pos1, n1, o);
-	uint32_t bytestart = g_utf8_offset_to_pointer(buf,pos1)-buf;
-	uint32_t byteend = g_utf8_offset_to_pointer(buf,pos1+n1)-buf;
+	uint32_t bytestart = charToBytePos(pos1);
+	uint32_t byteend = charToBytePos(pos1+n1);
 	return replace_bytes(bytestart, byteend-bytestart, o);
 }
 
@@ -450,8 +500,8 @@ tiny_string tiny_string::substr(uint32_t start, uint32_t len) const
 		len = numChars()-start;
 	if (isASCII)
 		return substr_bytes(start, len);
-	uint32_t bytestart = g_utf8_offset_to_pointer(buf,start) - buf;
-	uint32_t byteend = g_utf8_offset_to_pointer(buf,start+len) - buf;
+	uint32_t bytestart = charToBytePos(start);
+	uint32_t byteend = charToBytePos(start+len);
 	return substr_bytes(bytestart, byteend-bytestart);
 }
 
@@ -460,7 +510,7 @@ tiny_string tiny_string::substr(uint32_t start, const CharIterator& end) const
 	if (isASCII)
 		return substr_bytes(start, (end.buf_ptr - buf)-start);
 	assert_and_throw(start < numChars());
-	uint32_t bytestart = g_utf8_offset_to_pointer(buf,start) - buf;
+	uint32_t bytestart = charToBytePos(start);
 	uint32_t byteend = end.buf_ptr - buf;
 	return substr_bytes(bytestart, byteend-bytestart);
 }
@@ -1136,7 +1186,42 @@ uint32_t tiny_string::bytePosToIndex(uint32_t bytepos) const
 	if (isASCII)
 		return bytepos;
 
-	return g_utf8_pointer_to_offset(raw_buf(), raw_buf() + bytepos);
+	uint64_t cache = charposcache.load(std::memory_order_relaxed);
+	uint32_t cachedchar = cache>>32;
+	uint32_t cachedbyte = cache&0xffffffff;
+	uint32_t charpos;
+	// count from the cached position if it is closer than the start of the string
+	if (bytepos >= cachedbyte || cachedbyte-bytepos < bytepos)
+		charpos = cachedchar + g_utf8_pointer_to_offset(buf+cachedbyte, buf+bytepos);
+	else
+		charpos = g_utf8_pointer_to_offset(buf, buf+bytepos);
+	charposcache.store((uint64_t(charpos)<<32) | bytepos,std::memory_order_relaxed);
+	return charpos;
+}
+
+uint32_t tiny_string::charToBytePos(uint32_t charpos) const
+{
+	if (isASCII)
+		return charpos;
+	if (charpos >= numchars)
+		return numBytes();
+
+	uint64_t cache = charposcache.load(std::memory_order_relaxed);
+	uint32_t cachedchar = cache>>32;
+	uint32_t cachedbyte = cache&0xffffffff;
+	uint32_t fromcache = charpos >= cachedchar ? charpos-cachedchar : cachedchar-charpos;
+	uint32_t fromend = numchars-charpos;
+	// walk from the nearest of the start, the cached position and the end of the string
+	const char* p;
+	if (charpos <= fromcache && charpos <= fromend)
+		p = g_utf8_offset_to_pointer(buf, charpos);
+	else if (fromcache <= fromend)
+		p = g_utf8_offset_to_pointer(buf+cachedbyte, glong(charpos)-glong(cachedchar));
+	else
+		p = g_utf8_offset_to_pointer(buf+numBytes(), -glong(fromend));
+	uint32_t bytepos = p-buf;
+	charposcache.store((uint64_t(charpos)<<32) | bytepos,std::memory_order_relaxed);
+	return bytepos;
 }
 
 CharIterator tiny_string::begin()
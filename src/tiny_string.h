@@ -24,6 +24,7 @@
 #include <cstdint>
 #include <ostream>
 #include <list>
+#include <atomic>
 /* for utf8 handling */
 #include <glib.h>
 #include "compat.h"
@@ -97,7 +98,18 @@ private:
 	   stringSize includes the trailing \0
 	*/
 	uint32_t stringSize;
+	/*
+	   size of the allocated buffer if the type is DYNAMIC, may be bigger than stringSize
+	   DYNAMIC buffers are preceded by an atomic reference count and shared between copies of the string,
+	   they are only copied when one of the strings sharing them is modified
+	*/
+	uint32_t bufferSize;
 	uint32_t numchars;
+	/*
+	   last character index looked up in a non-ASCII string (upper 32 bits) and its byte offset (lower 32 bits),
+	   so that iterating over the characters doesn't have to walk from the start of the string for every access
+	*/
+	mutable std::atomic<uint64_t> charposcache;
 	TYPE type;
 #ifdef MEMORY_USAGE_PROFILING
 	//Implemented in memory_support.cpp
@@ -110,14 +122,20 @@ private:
 	void makePrivateCopy(const char* s);
 	void createBuffer(uint32_t s);
 	void resizeBuffer(uint32_t s);
+	void shareBuffer(const tiny_string& r);
+	void releaseBuffer(char* b, uint32_t size);
+	/* makes sure the buffer can hold newStringSize bytes before appending to the string */
+	void reserveForAppend(uint32_t newStringSize);
 	void resetToStatic();
 	void init();
+	/* converts an index of utf-8 characters to a byte offset */
+	uint32_t charToBytePos(uint32_t charpos) const;
 	bool isASCII:1;
 	bool hasNull:1;
 public:
 	static const uint32_t npos = (uint32_t)(-1);
 
-	tiny_string():_buf_static(),buf(_buf_static),stringSize(1),numchars(0),type(STATIC),isASCII(true),hasNull(false){buf[0]=0;}
+	tiny_string():_buf_static(),buf(_buf_static),stringSize(1),bufferSize(0),numchars(0),charposcache(0),type(STATIC),isASCII(true),hasNull(false){buf[0]=0;}
 	/* construct from utf character */
 	static tiny_string fromChar(uint32_t c);
 	tiny_string(const char* s,bool copy=false);
@@ -201,7 +219,7 @@ public:
 	{
 		if (isASCII)
 			return buf[idx];
-		return g_utf8_get_char(g_utf8_offset_to_pointer(buf,idx));
+		return g_utf8_get_char(buf+charToBytePos(idx));
 	}
 	/* start is an index of characters.
 	 * returns index of character */